@@ -63,7 +63,7 @@ TOOLS := compiletest rustdoc rustc rustbook
 DEPS_core :=
 DEPS_libc := core
 DEPS_rustc_unicode := core
-DEPS_alloc := core libc native:jemalloc
+DEPS_alloc := core libc native:jemalloc native:rust_valgrind
 DEPS_std := core libc rand alloc collections rustc_unicode \
 	native:rust_builtin native:backtrace native:rustrt_native \
 	rustc_bitflags
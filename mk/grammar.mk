@@ -50,6 +50,9 @@ endif
 $(BG)verify: $(BG) $(SG)verify.rs $(VERIFY_DEPS)
 	$(Q)$(RUSTC) --out-dir $(BG) -L $(L) $(SG)verify.rs
 
+$(BG)bench: $(BG) $(SG)bench.rs $(VERIFY_DEPS)
+	$(Q)$(RUSTC) -O --out-dir $(BG) -L $(L) $(SG)bench.rs
+
 ifdef CFG_JAVAC
 ifdef CFG_ANTLR4
 ifdef CFG_GRUN
@@ -79,7 +82,7 @@ $(BG)lex.yy.c: $(SG)lexer.l $(BG)
 
 $(BG)lexer-lalr.o: $(BG)lex.yy.c $(BG)parser-lalr.tab.h
 	@$(call E, cc: $@)
-	$(Q)$(CFG_CC) -include $(BG)parser-lalr.tab.h -c -o $@ $<
+	$(Q)$(CFG_CC) -O2 -include $(BG)parser-lalr.tab.h -c -o $@ $<
 
 $(BG)parser-lalr.tab.c $(BG)parser-lalr.tab.h: $(SG)parser-lalr.y
 	@$(call E, bison: $@)
@@ -88,11 +91,11 @@ $(BG)parser-lalr.tab.c $(BG)parser-lalr.tab.h: $(SG)parser-lalr.y
 
 $(BG)parser-lalr.o: $(BG)parser-lalr.tab.c
 	@$(call E, cc: $@)
-	$(Q)$(CFG_CC) -c -o $@ $<
+	$(Q)$(CFG_CC) -O2 -c -o $@ $<
 
 $(BG)parser-lalr-main.o: $(SG)parser-lalr-main.c
 	@$(call E, cc: $@)
-	$(Q)$(CFG_CC) -std=c99 -c -o $@ $<
+	$(Q)$(CFG_CC) -O2 -std=c99 -c -o $@ $<
 
 $(BG)parser-lalr: $(BG)parser-lalr.o $(BG)parser-lalr-main.o $(BG)lexer-lalr.o
 	@$(call E, cc: $@)
@@ -105,13 +108,23 @@ check-grammar: $(BG) $(BG)parser-lalr
 	$(info Verifying grammar ...)
 	$(SG)testparser.py -p $(BG)parser-lalr -s $(S)src
 
+# Report lexing and parsing throughput of libsyntax and of the reference
+# grammar over the in-tree crates.
+bench-grammar: $(BG) $(BG)parser-lalr $(BG)bench
+	$(info Benchmarking libsyntax ...)
+	$(Q)$(BG)bench $(S)src
+	$(info Benchmarking reference grammar ...)
+	$(Q)$(SG)benchparser.py -p $(BG)parser-lalr -s $(S)src
+
 else
 $(info cfg: bison not available, skipping parser test...)
 check-grammar:
+bench-grammar:
 
 endif
 else
 $(info cfg: flex not available, skipping parser test...)
 check-grammar:
+bench-grammar:
 
 endif
@@ -128,6 +128,24 @@ else
   CFG_RUSTC_FLAGS += -O --cfg rtopt
 endif
 
+ifdef CFG_ENABLE_HEAP_PROFILE
+  $(info cfg: building in the sampling heap profiler (CFG_ENABLE_HEAP_PROFILE))
+  CFG_RUSTC_FLAGS += --cfg heap_profile
+endif
+
+ifdef CFG_ENABLE_SWISS_TABLE
+  $(info cfg: using the group probing hash table (CFG_ENABLE_SWISS_TABLE))
+  CFG_RUSTC_FLAGS += --cfg swiss_table
+endif
+
+ifdef CFG_ENABLE_VALGRIND_HEAP
+  $(info cfg: annotating heap and arena allocations for valgrind (CFG_ENABLE_VALGRIND_HEAP))
+  CFG_RUSTC_FLAGS += --cfg valgrind_heap
+  # liballoc describes its blocks to valgrind itself; keep jemalloc from
+  # describing them a second time
+  CFG_JEMALLOC_FLAGS += --disable-valgrind
+endif
+
 CFG_JEMALLOC_FLAGS += $(JEMALLOC_FLAGS)
 
 ifdef CFG_ENABLE_DEBUG_ASSERTIONS
@@ -179,6 +197,15 @@ RUST_LIB_FLAGS_ST3 += -C prefer-dynamic
 # by not emitting them.
 RUSTFLAGS_STAGE0 += -Z no-landing-pads
 
+# The snapshot compiler does not know -C stack-probes, so stage0 keeps using
+# __morestack checks.
+ifdef CFG_ENABLE_STACK_PROBES
+  $(info cfg: checking for stack exhaustion with stack probes (CFG_ENABLE_STACK_PROBES))
+  RUSTFLAGS_STAGE1 += -C stack-probes
+  RUSTFLAGS_STAGE2 += -C stack-probes
+  RUSTFLAGS_STAGE3 += -C stack-probes
+endif
+
 # platform-specific auto-configuration
 include $(CFG_SRC_DIR)mk/platform.mk
 
@@ -36,7 +36,7 @@
 # target.
 ################################################################################
 NATIVE_LIBS := rust_builtin hoedown morestack miniz \
-		rustrt_native rust_test_helpers
+		rustrt_native rust_test_helpers rust_valgrind
 
 # $(1) is the target triple
 define NATIVE_LIBRARIES
@@ -57,6 +57,7 @@ NATIVE_DEPS_rustrt_native_$(1) := \
 			rust_try.ll \
 			arch/$$(HOST_$(1))/record_sp.S
 NATIVE_DEPS_rust_test_helpers_$(1) := rust_test_helpers.c
+NATIVE_DEPS_rust_valgrind_$(1) := rust_valgrind.c
 NATIVE_DEPS_morestack_$(1) := arch/$$(HOST_$(1))/morestack.S
 
 
@@ -272,6 +272,10 @@ pub fn test_opts(config: &Config) -> test::TestOpts {
         run_benchmarks: true,
         nocapture: env::var("RUST_TEST_NOCAPTURE").is_ok(),
         color: test::AutoColor,
+        bench_samples: test::DEFAULT_BENCH_SAMPLES,
+        bench_save: None,
+        bench_baseline: None,
+        bench_counters: false,
     }
 }
 
@@ -0,0 +1,108 @@
+#!/usr/bin/env python
+#
+# Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+# file at the top-level directory of this distribution and at
+# http://rust-lang.org/COPYRIGHT.
+#
+# Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+# http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+# <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+# option. This file may not be copied, modified, or distributed
+# except according to those terms.
+
+# This script generates src/libserialize/float/table.rs, the powers of five
+# used to convert between decimal and binary floating point:
+#
+# - POW5_128 holds 5^q normalized to 128 bits, for the Eisel-Lemire parser.
+# - POW5_SPLIT and POW5_INV_SPLIT hold 5^i and its reciprocal to POW5_BITS
+#   bits, for the Ryu printer.
+#
+# Run it from the top of the tree:
+#
+#     python src/etc/float_tables.py > src/libserialize/float/table.rs
+
+preamble = '''// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// NOTE: The following code was generated by "src/etc/float_tables.py", do not edit directly
+'''
+
+POW5_128_MIN = -342
+POW5_128_MAX = 308
+POW5_BITS = 125
+POW5_SPLIT_LEN = 326
+POW5_INV_SPLIT_LEN = 342
+
+MASK64 = (1 << 64) - 1
+
+def pow5_128(q):
+    if q >= 0:
+        p = 5 ** q
+        while p < (1 << 127):
+            p *= 2
+        while p >= (1 << 128):
+            p //= 2
+        return p
+    p = 5 ** -q
+    z = 0
+    while (1 << z) < p:
+        z += 1
+    if q >= -27:
+        return 2 ** (z + 127) // p + 1
+    c = 2 ** (2 * z + 128) // p + 1
+    while c >= (1 << 128):
+        c //= 2
+    return c
+
+def pow5_split(i):
+    p = 5 ** i
+    l = p.bit_length()
+    if l >= POW5_BITS:
+        return p >> (l - POW5_BITS)
+    return p << (POW5_BITS - l)
+
+def pow5_inv_split(i):
+    p = 5 ** i
+    return 2 ** (p.bit_length() - 1 + POW5_BITS) // p + 1
+
+def entry(hi, lo):
+    return "    (0x%016x, 0x%016x)," % (hi, lo)
+
+print(preamble)
+print("/// The least power of ten in `POW5_128`.")
+print("pub const POW5_128_MIN: i64 = %d;" % POW5_128_MIN)
+print("/// The greatest power of ten in `POW5_128`.")
+print("pub const POW5_128_MAX: i64 = %d;" % POW5_128_MAX)
+print("")
+print("/// `5^q` for `q` in `POW5_128_MIN...POW5_128_MAX`, normalized to 128 bits")
+print("/// as `(high, low)`. Positive powers are truncated; negative ones are")
+print("/// reciprocals rounded up.")
+print("pub static POW5_128: [(u64, u64); %d] = [" % (POW5_128_MAX - POW5_128_MIN + 1))
+for q in range(POW5_128_MIN, POW5_128_MAX + 1):
+    p = pow5_128(q)
+    print(entry(p >> 64, p & MASK64))
+print("];")
+print("")
+print("/// Bits in the entries of `POW5_SPLIT` and `POW5_INV_SPLIT`.")
+print("pub const POW5_BITS: i32 = %d;" % POW5_BITS)
+print("")
+print("/// `5^i` truncated to `POW5_BITS` bits, as `(low, high)`.")
+print("pub static POW5_SPLIT: [(u64, u64); %d] = [" % POW5_SPLIT_LEN)
+for i in range(POW5_SPLIT_LEN):
+    p = pow5_split(i)
+    print(entry(p & MASK64, p >> 64))
+print("];")
+print("")
+print("/// `2^(bits(5^i) - 1 + POW5_BITS) / 5^i`, rounded up, as `(low, high)`.")
+print("pub static POW5_INV_SPLIT: [(u64, u64); %d] = [" % POW5_INV_SPLIT_LEN)
+for i in range(POW5_INV_SPLIT_LEN):
+    p = pow5_inv_split(i)
+    print(entry(p & MASK64, p >> 64))
+print("];")
@@ -0,0 +1,114 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! Measures the throughput of libsyntax's lexer and parser over the in-tree
+//! crates, for comparison with the reference grammar (see `benchparser.py`).
+//!
+//! Usage: `bench <src-dir>`. Every `<src-dir>/lib*/lib.rs` is parsed as a
+//! crate root, which pulls in all of its out-of-line modules; each source
+//! file the parser loaded is then lexed on its own.
+
+#![feature(rustc_private, std_misc, path_ext)]
+
+extern crate syntax;
+
+use std::env;
+use std::fs::{self, PathExt};
+use std::path::Path;
+use std::rc::Rc;
+use std::time::Duration;
+
+use syntax::codemap::FileMap;
+use syntax::parse;
+use syntax::parse::lexer::{self, Reader};
+use syntax::parse::token;
+
+struct Stats {
+    files: usize,
+    bytes: usize,
+    tokens: usize,
+    dur: Duration,
+}
+
+impl Stats {
+    fn new() -> Stats {
+        Stats { files: 0, bytes: 0, tokens: 0, dur: Duration::zero() }
+    }
+
+    fn report(&self, what: &str) {
+        let ns = self.dur.num_nanoseconds().unwrap();
+        let secs = if ns > 0 { ns as f64 / 1e9 } else { 1e-9 };
+        let mb = self.bytes as f64 / 1e6;
+        println!("{}: {} files, {:.2} MB, {} tokens in {:.3}s: {:.2} MB/s, {:.0} tokens/s",
+                 what, self.files, mb, self.tokens, secs,
+                 mb / secs, self.tokens as f64 / secs);
+    }
+}
+
+/// Parses the crate rooted at `root`, returning the files the parser loaded.
+fn parse_crate(root: &Path, stats: &mut Stats) -> Vec<Rc<FileMap>> {
+    let sess = parse::new_parse_sess();
+    stats.dur = stats.dur + Duration::span(|| {
+        parse::parse_crate_from_file(root, Vec::new(), &sess);
+    });
+    let files = sess.span_diagnostic.cm.files.borrow().clone();
+    for fm in &files {
+        stats.files += 1;
+        stats.bytes += fm.src.as_ref().map_or(0, |s| s.len());
+    }
+    files
+}
+
+/// Lexes a single file to completion, returning the number of tokens seen.
+fn lex_file(fm: &FileMap, stats: &mut Stats) -> usize {
+    let src = match fm.src {
+        Some(ref src) => (**src).clone(),
+        None => return 0,
+    };
+    let sess = parse::new_parse_sess();
+    let filemap = parse::string_to_filemap(&sess, src, fm.name.clone());
+    let mut tokens = 0;
+    stats.dur = stats.dur + Duration::span(|| {
+        let mut reader = lexer::StringReader::new(&sess.span_diagnostic, filemap);
+        while reader.next_token().tok != token::Eof {
+            tokens += 1;
+        }
+    });
+    stats.files += 1;
+    stats.bytes += fm.src.as_ref().map_or(0, |s| s.len());
+    stats.tokens += tokens;
+    tokens
+}
+
+fn main() {
+    let src_dir = env::args().nth(1).expect("usage: bench <src-dir>");
+
+    let mut roots = Vec::new();
+    for entry in fs::read_dir(&Path::new(&src_dir)).unwrap() {
+        let path = entry.unwrap().path();
+        let is_lib = path.file_name().and_then(|n| n.to_str())
+                         .map_or(false, |n| n.starts_with("lib"));
+        if is_lib && path.join("lib.rs").is_file() {
+            roots.push(path.join("lib.rs"));
+        }
+    }
+    roots.sort();
+
+    let mut lex = Stats::new();
+    let mut parse = Stats::new();
+    for root in &roots {
+        for fm in &parse_crate(root, &mut parse) {
+            parse.tokens += lex_file(fm, &mut lex);
+        }
+    }
+
+    lex.report("lex  ");
+    parse.report("parse");
+}
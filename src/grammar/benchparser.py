@@ -0,0 +1,75 @@
+#!/usr/bin/env python
+#
+# Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+# file at the top-level directory of this distribution and at
+# http://rust-lang.org/COPYRIGHT.
+#
+# Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+# http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+# <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+# option. This file may not be copied, modified, or distributed
+# except according to those terms.
+
+# ignore-tidy-linelength
+
+import sys
+
+import os
+import subprocess
+import argparse
+
+# usage: benchparser.py [-h] -p PARSER -s SOURCE_DIR
+
+# Runs the reference lexer and parser in benchmark mode (`-b`) over every
+# `.rs` file in the `lib*` crates under SOURCE_DIR and reports aggregate
+# lexing and parsing throughput. Files are passed to the parser in batches,
+# and it prints one line of `bytes tokens lex_us parse_us ret` per file.
+
+parser = argparse.ArgumentParser()
+parser.add_argument('-p', '--parser', nargs=1, required=True)
+parser.add_argument('-s', '--source-dir', nargs=1, required=True)
+args = parser.parse_args(sys.argv[1:])
+
+files = 0
+failed = 0
+total_bytes = 0
+total_tokens = 0
+lex_us = 0
+parse_us = 0
+
+BATCH = 256
+
+source_dir = args.source_dir[0]
+paths = []
+for crate in sorted(os.listdir(source_dir)):
+    if not crate.startswith('lib'):
+        continue
+    for base, dirs, names in os.walk(os.path.join(source_dir, crate)):
+        for f in filter(lambda p: p.endswith('.rs'), names):
+            paths.append(os.path.join(base, f))
+
+devnull = open(os.devnull, 'w')
+for i in range(0, len(paths), BATCH):
+    out = subprocess.Popen([args.parser[0], '-b'] + paths[i:i + BATCH],
+                           stdout=subprocess.PIPE, stderr=devnull).communicate()[0]
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) != 5 or int(fields[4]) != 0:
+            failed += 1
+            continue
+        files += 1
+        total_bytes += int(fields[0])
+        total_tokens += int(fields[1])
+        lex_us += int(fields[2])
+        parse_us += int(fields[3])
+devnull.close()
+
+def report(what, us):
+    secs = max(us, 1) / 1e6
+    print("{}: {} files, {:.2f} MB, {} tokens in {:.3f}s: {:.2f} MB/s, {:.0f} tokens/s"
+          .format(what, files, total_bytes / 1e6, total_tokens, secs,
+                  total_bytes / 1e6 / secs, total_tokens / secs))
+
+report("lex  ", lex_us)
+report("parse", parse_us)
+print("{} files skipped because the reference grammar rejected them".format(failed))
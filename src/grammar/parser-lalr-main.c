@@ -8,13 +8,27 @@
 // option. This file may not be copied, modified, or distributed
 // except according to those terms.
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 extern int yylex();
 extern int rsparse();
+extern void lexer_reset();
+
+// Entry points generated by flex, used to lex sources straight out of an
+// in-memory buffer instead of through stdio.
+typedef void *YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_buffer(char *base, size_t size);
+extern void yy_delete_buffer(YY_BUFFER_STATE b);
 
 #define PUSHBACK_LEN 4
 
@@ -173,27 +187,198 @@ void print_node(struct node *n, int depth) {
   }
 }
 
-int main(int argc, char **argv) {
-  if (argc == 2 && strcmp(argv[1], "-v") == 0) {
-    verbose = 1;
+void free_nodes() {
+  struct node *tmp;
+  while (nodes) {
+    tmp = nodes;
+    nodes = tmp->next;
+    if (tmp->own_string) {
+      free((void*)tmp->name);
+    }
+    free(tmp);
+  }
+  n_nodes = 0;
+}
+
+// A source file held in memory, followed by the two NUL bytes that flex
+// requires at the end of a scan buffer. `map_len` is nonzero if `buf` is a
+// mapping of the file rather than a heap allocation.
+struct source {
+  char *buf;
+  size_t len;
+  size_t map_len;
+};
+
+// Reads the rest of `f` into a heap buffer.
+int read_source(FILE *f, struct source *src) {
+  size_t cap = 64 * 1024, n = 0, r;
+  char *buf = malloc(cap), *tmp;
+  while (buf && (r = fread(buf + n, 1, cap - n - 2, f)) > 0) {
+    n += r;
+    if (n + 2 == cap) {
+      cap *= 2;
+      tmp = realloc(buf, cap);
+      if (!tmp) {
+        free(buf);
+        return -1;
+      }
+      buf = tmp;
+    }
+  }
+  if (!buf) {
+    return -1;
+  }
+  buf[n] = buf[n + 1] = '\0';
+  src->buf = buf;
+  src->len = n;
+  src->map_len = 0;
+  return 0;
+}
+
+// Maps the file at `path` into memory. The kernel zero-fills the remainder
+// of the file's last page, so that is used for the terminating NULs when
+// there is room; otherwise the file is read into a heap buffer instead.
+// The mapping is private and writable because flex temporarily
+// NUL-terminates each token in place.
+int open_source(const char *path, struct source *src) {
+  struct stat st;
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  int ret = -1;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  if (fstat(fd, &st) == 0) {
+    size_t len = (size_t)st.st_size;
+    size_t tail = len % page;
+    if (len > 0 && tail != 0 && tail <= page - 2) {
+      void *p = mmap(NULL, len + 2, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        src->buf = p;
+        src->len = len;
+        src->map_len = len + 2;
+        ret = 0;
+      }
+    }
+    if (ret != 0) {
+      FILE *f = fdopen(fd, "rb");
+      if (f) {
+        ret = read_source(f, src);
+        fclose(f);
+        return ret;
+      }
+    }
+  }
+  close(fd);
+  return ret;
+}
+
+void close_source(struct source *src) {
+  if (src->map_len) {
+    munmap(src->buf, src->map_len);
   } else {
-    verbose = 0;
+    free(src->buf);
   }
-  int ret = 0;
-  struct node *tmp;
+}
+
+// Points the lexer at `src`, which must outlive the returned buffer.
+YY_BUFFER_STATE scan_source(struct source *src) {
+  lexer_reset();
   memset(pushback, '\0', PUSHBACK_LEN);
+  return yy_scan_buffer(src->buf, src->len + 2);
+}
+
+long elapsed_us(clock_t start) {
+  return (long)((double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC);
+}
+
+// Benchmark mode: lex the source to completion, then parse it, and print a
+// single line of `bytes tokens lex_us parse_us ret` for benchparser.py to
+// aggregate. Times are CPU time of this process only.
+int bench(struct source *src) {
+  long tokens = 0, lex_us, parse_us;
+  int tok, ret;
+  clock_t start;
+  YY_BUFFER_STATE b;
+
+  b = scan_source(src);
+  start = clock();
+  while ((tok = yylex()) > 0) {
+    tokens++;
+  }
+  lex_us = elapsed_us(start);
+  yy_delete_buffer(b);
+  if (tok < 0) {
+    printf("%lu %ld %ld 0 1\n", (unsigned long)src->len, tokens, lex_us);
+    return 1;
+  }
+
+  b = scan_source(src);
+  start = clock();
   ret = rsparse();
+  parse_us = elapsed_us(start);
+  yy_delete_buffer(b);
+  free_nodes();
+
+  printf("%lu %ld %ld %ld %d\n", (unsigned long)src->len, tokens, lex_us, parse_us, ret);
+  return ret;
+}
+
+int parse(struct source *src) {
+  YY_BUFFER_STATE b = scan_source(src);
+  int ret = rsparse();
+  yy_delete_buffer(b);
   print("--- PARSE COMPLETE: ret:%d, n_nodes:%d ---\n", ret, n_nodes);
   if (nodes) {
     print_node(nodes, 0);
   }
-  while (nodes) {
-    tmp = nodes;
-    nodes = tmp->next;
-    if (tmp->own_string) {
-      free((void*)tmp->name);
+  free_nodes();
+  return ret;
+}
+
+// usage: parser-lalr [-v] [-b] [FILE...]
+//
+// Parses each FILE, or stdin if none are given, and exits with a nonzero
+// status if any of them fails to parse. `-v` prints the parse tree and
+// `-b` runs the benchmark mode instead.
+int main(int argc, char **argv) {
+  int i, ret = 0, bench_mode = 0;
+  struct source src;
+  verbose = 0;
+  for (i = 1; i < argc && argv[i][0] == '-'; ++i) {
+    if (strcmp(argv[i], "-v") == 0) {
+      verbose = 1;
+    } else if (strcmp(argv[i], "-b") == 0) {
+      bench_mode = 1;
+    } else {
+      fprintf(stderr, "usage: %s [-v] [-b] [FILE...]\n", argv[0]);
+      return 2;
     }
-    free(tmp);
+  }
+
+  if (i == argc) {
+    if (read_source(stdin, &src) != 0) {
+      fprintf(stderr, "failed to read stdin\n");
+      return 1;
+    }
+    ret = bench_mode ? bench(&src) : parse(&src);
+    close_source(&src);
+    return ret;
+  }
+
+  for (; i < argc; ++i) {
+    if (open_source(argv[i], &src) != 0) {
+      fprintf(stderr, "failed to open %s\n", argv[i]);
+      if (bench_mode) {
+        printf("0 0 0 0 1\n");
+      }
+      ret = 1;
+      continue;
+    }
+    if (bench_mode ? bench(&src) : parse(&src)) {
+      ret = 1;
+    }
+    close_source(&src);
   }
   return ret;
 }
@@ -20,8 +20,8 @@ import argparse
 
 # usage: testparser.py [-h] [-p PARSER [PARSER ...]] -s SOURCE_DIR
 
-# Parsers should read from stdin and return exit status 0 for a
-# successful parse, and nonzero for an unsuccessful parse
+# Parsers are passed the path of the file to parse and should return exit
+# status 0 for a successful parse, and nonzero for an unsuccessful parse
 
 parser = argparse.ArgumentParser()
 parser.add_argument('-p', '--parser', nargs='+')
@@ -49,7 +49,7 @@ for base, dirs, files in os.walk(args.source_dir[0]):
             continue
         total += 1
         for parser in args.parser:
-            if subprocess.call(parser, stdin=open(p), stderr=subprocess.STDOUT, stdout=devnull) == 0:
+            if subprocess.call([parser, p], stderr=subprocess.STDOUT, stdout=devnull) == 0:
                 if parse_fail:
                     bad[parser].append(p)
                 else:
@@ -257,6 +257,16 @@ fn span_cmp(antlr_sp: codemap::Span, rust_sp: codemap::Span, cm: &codemap::CodeM
         antlr_sp.hi.to_usize() == cm.bytepos_to_file_charpos(rust_sp.hi).to_usize()
 }
 
+/// Reads a whole file into a buffer sized from its metadata, so that it
+/// is read without regrowing and copying the buffer.
+fn read_file(path: &Path) -> String {
+    let mut file = File::open(path).unwrap();
+    let len = file.metadata().map(|m| m.len() as usize).unwrap_or(0);
+    let mut contents = String::with_capacity(len + 1);
+    file.read_to_string(&mut contents).unwrap();
+    contents
+}
+
 fn main() {
     fn next(r: &mut lexer::StringReader) -> TokenAndSpan {
         use syntax::parse::lexer::Reader;
@@ -270,8 +280,7 @@ fn main() {
     }
 
     // Rust's lexer
-    let mut code = String::new();
-    File::open(&Path::new(&filename)).unwrap().read_to_string(&mut code).unwrap();
+    let code = read_file(Path::new(&filename));
 
     let surrogate_pairs_pos: Vec<usize> = code.chars().enumerate()
                                                      .filter(|&(_, c)| c as usize > 0xFFFF)
@@ -294,9 +303,7 @@ fn main() {
     let ref cm = lexer.span_diagnostic.cm;
 
     // ANTLR
-    let mut token_file = File::open(&Path::new(&args.next().unwrap())).unwrap();
-    let mut token_list = String::new();
-    token_file.read_to_string(&mut token_list).unwrap();
+    let token_list = read_file(Path::new(&args.next().unwrap()));
     let token_map = parse_token_list(&token_list[..]);
 
     let stdin = std::io::stdin();
@@ -19,6 +19,7 @@
 /// size on the platform.
 #[inline]
 pub unsafe fn allocate(size: usize, align: usize) -> *mut u8 {
+    profile::record(size);
     imp::allocate(size, align)
 }
 
@@ -38,6 +39,7 @@ pub unsafe fn allocate(size: usize, align: usize) -> *mut u8 {
 /// any value in range_inclusive(requested_size, usable_size).
 #[inline]
 pub unsafe fn reallocate(ptr: *mut u8, old_size: usize, size: usize, align: usize) -> *mut u8 {
+    profile::record(size);
     imp::reallocate(ptr, old_size, size, align)
 }
 
@@ -131,6 +133,134 @@ const MIN_ALIGN: usize = 8;
               target_arch = "aarch64")))]
 const MIN_ALIGN: usize = 16;
 
+/// Sampling of allocations for a heap profiler.
+///
+/// With `--cfg heap_profile` every thread counts down the bytes it allocates
+/// and, each time the count runs out, hands the allocation to the hook set
+/// by `start`. The intervals between samples are drawn at random around the
+/// sampling rate, so that periodic allocation patterns are not missed or
+/// over-counted, and each sample stands for `rate` bytes or for its own
+/// size if that is larger. std builds its profiler (`RUST_HEAP_PROFILE`)
+/// on top of this.
+#[cfg(all(heap_profile, target_os = "linux"))]
+pub mod profile {
+    use core::atomic::{AtomicUsize, Ordering, ATOMIC_USIZE_INIT};
+    use core::mem;
+
+    // How often a thread with no profiler running looks again.
+    const IDLE_INTERVAL: isize = 1 << 20;
+
+    static RATE: AtomicUsize = ATOMIC_USIZE_INIT;
+    static HOOK: AtomicUsize = ATOMIC_USIZE_INIT;
+
+    #[thread_local] static mut UNTIL_SAMPLE: isize = 0;
+    #[thread_local] static mut SEED: u32 = 0;
+    #[thread_local] static mut IN_HOOK: bool = false;
+
+    /// Starts sampling about one allocation per `rate` bytes. `hook` is
+    /// called with the size of each sampled allocation and the number of
+    /// bytes it stands for, before the allocation is made. Allocations made
+    /// by the hook itself are not sampled.
+    pub fn start(rate: usize, hook: fn(size: usize, weight: usize)) {
+        HOOK.store(hook as usize, Ordering::SeqCst);
+        RATE.store(rate, Ordering::SeqCst);
+    }
+
+    /// Stops sampling.
+    pub fn stop() {
+        RATE.store(0, Ordering::SeqCst);
+    }
+
+    #[inline]
+    pub fn record(size: usize) {
+        unsafe {
+            UNTIL_SAMPLE -= size as isize;
+            if UNTIL_SAMPLE < 0 {
+                sample(size)
+            }
+        }
+    }
+
+    #[cold]
+    #[inline(never)]
+    unsafe fn sample(size: usize) {
+        let rate = RATE.load(Ordering::SeqCst);
+        if rate == 0 || IN_HOOK {
+            UNTIL_SAMPLE = if rate == 0 { IDLE_INTERVAL } else { 0 };
+            return
+        }
+
+        // xorshift32, seeded from the address of this thread's statics
+        if SEED == 0 {
+            SEED = (&SEED as *const u32 as usize as u32) | 1;
+        }
+        SEED ^= SEED << 13;
+        SEED ^= SEED >> 17;
+        SEED ^= SEED << 5;
+        UNTIL_SAMPLE = (SEED as usize % (2 * rate)) as isize;
+
+        let hook: fn(usize, usize) = mem::transmute(HOOK.load(Ordering::SeqCst));
+        IN_HOOK = true;
+        hook(size, if size > rate { size } else { rate });
+        IN_HOOK = false;
+    }
+}
+
+#[cfg(not(all(heap_profile, target_os = "linux")))]
+mod profile {
+    #[inline(always)]
+    pub fn record(_size: usize) {}
+}
+
+/// Descriptions of jemalloc's blocks for valgrind's tools.
+///
+/// jemalloc is linked with a `je_` prefix, so valgrind cannot intercept it as
+/// it does the system `malloc`: without these client requests memcheck,
+/// massif and DHAT see no Rust heap blocks at all. They are compiled in with
+/// `--cfg valgrind_heap` and are free otherwise. The same runtime library
+/// serves libarena, which describes objects inside its chunks as mempools.
+#[cfg(valgrind_heap)]
+#[allow(dead_code)]
+mod valgrind {
+    use libc::{c_void, size_t};
+
+    #[link(name = "rust_valgrind", kind = "static")]
+    #[cfg(not(test))]
+    extern {}
+
+    extern {
+        fn rust_valgrind_malloclike(addr: *mut c_void, size: size_t);
+        fn rust_valgrind_freelike(addr: *mut c_void);
+        fn rust_valgrind_resize_inplace(addr: *mut c_void, old_size: size_t, new_size: size_t);
+    }
+
+    #[inline]
+    pub unsafe fn malloclike(ptr: *mut u8, size: usize) {
+        rust_valgrind_malloclike(ptr as *mut c_void, size as size_t)
+    }
+
+    #[inline]
+    pub unsafe fn freelike(ptr: *mut u8) {
+        rust_valgrind_freelike(ptr as *mut c_void)
+    }
+
+    #[inline]
+    pub unsafe fn resize_inplace(ptr: *mut u8, old_size: usize, size: usize) {
+        rust_valgrind_resize_inplace(ptr as *mut c_void, old_size as size_t, size as size_t)
+    }
+}
+
+#[cfg(not(valgrind_heap))]
+#[allow(dead_code)]
+mod valgrind {
+    #[inline(always)]
+    pub unsafe fn malloclike(_ptr: *mut u8, _size: usize) {}
+    #[inline(always)]
+    pub unsafe fn freelike(_ptr: *mut u8) {}
+    #[inline(always)]
+    pub unsafe fn resize_inplace(_ptr: *mut u8, _old_size: usize, _size: usize) {}
+}
+
 #[cfg(feature = "external_funcs")]
 mod imp {
     #[allow(improper_ctypes)]
@@ -187,11 +317,13 @@ mod imp {
           not(feature = "external_crate"),
           jemalloc))]
 mod imp {
+    use core::cmp;
     use core::option::Option;
     use core::option::Option::None;
-    use core::ptr::{null_mut, null};
+    use core::ptr::{self, null_mut, null};
     use libc::{c_char, c_int, c_void, size_t};
     use super::MIN_ALIGN;
+    use super::valgrind;
 
     #[link(name = "jemalloc", kind = "static")]
     #[cfg(not(test))]
@@ -229,25 +361,49 @@ mod imp {
     #[inline]
     pub unsafe fn allocate(size: usize, align: usize) -> *mut u8 {
         let flags = align_to_flags(align);
-        je_mallocx(size as size_t, flags) as *mut u8
+        let ptr = je_mallocx(size as size_t, flags) as *mut u8;
+        if !ptr.is_null() { valgrind::malloclike(ptr, size) }
+        ptr
     }
 
     #[inline]
-    pub unsafe fn reallocate(ptr: *mut u8, _old_size: usize, size: usize, align: usize) -> *mut u8 {
+    pub unsafe fn reallocate(ptr: *mut u8, old_size: usize, size: usize, align: usize) -> *mut u8 {
+        if cfg!(valgrind_heap) {
+            return reallocate_annotated(ptr, old_size, size, align)
+        }
         let flags = align_to_flags(align);
         je_rallocx(ptr as *mut c_void, size as size_t, flags) as *mut u8
     }
 
+    // When `rallocx` moves a block it copies the contents inside jemalloc,
+    // into memory memcheck was last told is free. With the annotations on,
+    // the move is made of separately described steps instead.
+    unsafe fn reallocate_annotated(ptr: *mut u8, old_size: usize, size: usize,
+                                   align: usize) -> *mut u8 {
+        if reallocate_inplace(ptr, old_size, size, align) >= size {
+            return ptr
+        }
+        let new = allocate(size, align);
+        if !new.is_null() {
+            ptr::copy_nonoverlapping(ptr, new, cmp::min(old_size, size));
+            deallocate(ptr, old_size, align);
+        }
+        new
+    }
+
     #[inline]
-    pub unsafe fn reallocate_inplace(ptr: *mut u8, _old_size: usize, size: usize,
+    pub unsafe fn reallocate_inplace(ptr: *mut u8, old_size: usize, size: usize,
                                      align: usize) -> usize {
         let flags = align_to_flags(align);
-        je_xallocx(ptr as *mut c_void, size as size_t, 0, flags) as usize
+        let usable = je_xallocx(ptr as *mut c_void, size as size_t, 0, flags) as usize;
+        if usable >= size { valgrind::resize_inplace(ptr, old_size, size) }
+        usable
     }
 
     #[inline]
     pub unsafe fn deallocate(ptr: *mut u8, old_size: usize, align: usize) {
         let flags = align_to_flags(align);
+        valgrind::freelike(ptr);
         je_sdallocx(ptr as *mut c_void, old_size as size_t, flags)
     }
 
@@ -81,6 +81,7 @@
 #![feature(core)]
 #![feature(unique)]
 #![cfg_attr(test, feature(test, alloc, rustc_private))]
+#![cfg_attr(all(heap_profile, target_os = "linux"), feature(thread_local))]
 #![cfg_attr(all(not(feature = "external_funcs"), not(feature = "external_crate")),
             feature(libc))]
 
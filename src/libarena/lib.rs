@@ -48,6 +48,53 @@ use std::ptr;
 use std::rc::Rc;
 use std::rt::heap::{allocate, deallocate};
 
+/// Descriptions of arena chunks as valgrind mempools, so that memcheck and
+/// the heap profilers see the individual objects rather than one block per
+/// chunk. Compiled in with `--cfg valgrind_heap`; the client requests live
+/// in the runtime library that liballoc links for the same purpose.
+#[cfg(valgrind_heap)]
+mod valgrind {
+    extern {
+        fn rust_valgrind_create_mempool(pool: *const u8, len: usize);
+        fn rust_valgrind_mempool_alloc(pool: *const u8, addr: *const u8, size: usize);
+        fn rust_valgrind_destroy_mempool(pool: *const u8);
+    }
+
+    /// Registers the `len` bytes at `pool` as a pool of not yet allocated
+    /// memory. Empty chunks share a dangling address and are left out.
+    #[inline]
+    pub unsafe fn create_mempool(pool: *const u8, len: usize) {
+        if len != 0 {
+            rust_valgrind_create_mempool(pool, len)
+        }
+    }
+
+    /// Marks the `size` bytes at `addr` as an object allocated from `pool`.
+    #[inline]
+    pub unsafe fn mempool_alloc(pool: *const u8, addr: *const u8, size: usize) {
+        if size != 0 {
+            rust_valgrind_mempool_alloc(pool, addr, size)
+        }
+    }
+
+    #[inline]
+    pub unsafe fn destroy_mempool(pool: *const u8, len: usize) {
+        if len != 0 {
+            rust_valgrind_destroy_mempool(pool)
+        }
+    }
+}
+
+#[cfg(not(valgrind_heap))]
+mod valgrind {
+    #[inline(always)]
+    pub unsafe fn create_mempool(_pool: *const u8, _len: usize) {}
+    #[inline(always)]
+    pub unsafe fn mempool_alloc(_pool: *const u8, _addr: *const u8, _size: usize) {}
+    #[inline(always)]
+    pub unsafe fn destroy_mempool(_pool: *const u8, _len: usize) {}
+}
+
 // The way arena uses arrays is really deeply awful. The arrays are
 // allocated, and have capacities reserved, but the fill for the array
 // will always stay at 0.
@@ -116,11 +163,13 @@ impl<'a> Arena<'a> {
 }
 
 fn chunk(size: usize, is_copy: bool) -> Chunk {
-    Chunk {
+    let chunk = Chunk {
         data: Rc::new(RefCell::new(Vec::with_capacity(size))),
         fill: Cell::new(0),
         is_copy: Cell::new(is_copy),
-    }
+    };
+    unsafe { valgrind::create_mempool(chunk.as_ptr(), chunk.capacity()) }
+    chunk
 }
 
 impl<'longer_than_self> Drop for Arena<'longer_than_self> {
@@ -132,6 +181,14 @@ impl<'longer_than_self> Drop for Arena<'longer_than_self> {
                     destroy_chunk(chunk);
                 }
             }
+
+            let head = self.head.borrow();
+            let copy_head = self.copy_head.borrow();
+            valgrind::destroy_mempool(head.as_ptr(), head.capacity());
+            valgrind::destroy_mempool(copy_head.as_ptr(), copy_head.capacity());
+            for chunk in &*self.chunks.borrow() {
+                valgrind::destroy_mempool(chunk.as_ptr(), chunk.capacity());
+            }
         }
     }
 }
@@ -233,7 +290,9 @@ impl<'longer_than_self> Arena<'longer_than_self> {
         copy_head.fill.set(end);
 
         unsafe {
-            copy_head.as_ptr().offset(start as isize)
+            let buf = copy_head.as_ptr();
+            valgrind::mempool_alloc(buf, buf.offset(start as isize), n_bytes);
+            buf.offset(start as isize)
         }
     }
 
@@ -287,6 +346,10 @@ impl<'longer_than_self> Arena<'longer_than_self> {
 
         unsafe {
             let buf = head.as_ptr();
+            // The type descriptor belongs to the object: it is read back
+            // when the arena is destroyed.
+            valgrind::mempool_alloc(buf, buf.offset(tydesc_start as isize),
+                                    end - tydesc_start);
             return (buf.offset(tydesc_start as isize), buf.offset(start as isize));
         }
     }
@@ -407,6 +470,8 @@ impl<T> TypedArenaChunk<T> {
         if chunk.is_null() { alloc::oom() }
         (*chunk).next = next;
         (*chunk).capacity = capacity;
+        valgrind::create_mempool((*chunk).start(),
+                                 (*chunk).end() as usize - (*chunk).start() as usize);
         chunk
     }
 
@@ -426,6 +491,7 @@ impl<T> TypedArenaChunk<T> {
         // Destroy the next chunk.
         let next = self.next;
         let size = calculate_size::<T>(self.capacity);
+        valgrind::destroy_mempool(self.start(), self.end() as usize - self.start() as usize);
         let self_ptr: *mut TypedArenaChunk<T> = self;
         deallocate(self_ptr as *mut u8, size,
                    mem::min_align_of::<TypedArenaChunk<T>>());
@@ -485,6 +551,11 @@ impl<T> TypedArena<T> {
         }
 
         let ptr: &mut T = unsafe {
+            if cfg!(valgrind_heap) {
+                let start = (**self.first.borrow()).start();
+                valgrind::mempool_alloc(start, self.ptr.get() as *const u8,
+                                        mem::size_of::<T>());
+            }
             let ptr: &mut T = mem::transmute(self.ptr.clone());
             ptr::write(ptr, object);
             self.ptr.set(self.ptr.get().offset(1));
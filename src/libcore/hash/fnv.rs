@@ -0,0 +1,65 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! An implementation of the 64-bit FNV-1a hash.
+
+#![allow(deprecated)] // until the next snapshot for inherent wrapping ops
+
+use prelude::*;
+use super::Hasher;
+
+/// An implementation of the 64-bit Fowler-Noll-Vo hash, FNV-1a.
+///
+/// See: http://www.isthe.com/chongo/tech/comp/fnv/
+///
+/// FNV does very little work per byte and none to set up or finish, so it
+/// is faster than `SipHasher` on short keys such as small strings. It is
+/// not keyed, and offers no protection at all against deliberately
+/// colliding keys, so only use it for hash maps whose keys cannot be chosen
+/// by an adversary.
+///
+/// # Examples
+///
+/// ```rust
+/// # #![feature(hash, std_misc)]
+/// use std::collections::HashMap;
+/// use std::collections::hash_state::DefaultState;
+/// use std::default::Default;
+/// use std::hash::FnvHasher;
+///
+/// let mut map: HashMap<&str, i32, DefaultState<FnvHasher>> = Default::default();
+/// map.insert("a", 1);
+/// assert_eq!(map[&"a"], 1);
+/// ```
+#[unstable(feature = "hash", reason = "recently added, may be renamed")]
+#[derive(Clone)]
+pub struct FnvHasher(u64);
+
+#[unstable(feature = "hash", reason = "recently added, may be renamed")]
+impl Default for FnvHasher {
+    #[inline]
+    fn default() -> FnvHasher { FnvHasher(0xcbf29ce484222325) }
+}
+
+#[unstable(feature = "hash", reason = "recently added, may be renamed")]
+impl Hasher for FnvHasher {
+    #[inline]
+    fn write(&mut self, bytes: &[u8]) {
+        let FnvHasher(mut hash) = *self;
+        for byte in bytes {
+            hash = hash ^ (*byte as u64);
+            hash = hash.wrapping_mul(0x100000001b3);
+        }
+        *self = FnvHasher(hash);
+    }
+
+    #[inline]
+    fn finish(&self) -> u64 { self.0 }
+}
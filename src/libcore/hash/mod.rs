@@ -65,8 +65,12 @@ use prelude::*;
 use mem;
 
 pub use self::sip::SipHasher;
+pub use self::fnv::FnvHasher;
+pub use self::mul::MulHasher;
 
 mod sip;
+mod fnv;
+mod mul;
 
 /// A hashable type.
 ///
@@ -0,0 +1,109 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! A multiplicative hash for integer keys.
+
+#![allow(deprecated)] // until the next snapshot for inherent wrapping ops
+
+use prelude::*;
+use mem;
+use ptr;
+use super::Hasher;
+
+// 2^64 divided by the golden ratio, rounded to odd.
+const SEED: u64 = 0x9e3779b97f4a7c15;
+
+/// A hash that folds each integer it is given into its state with a rotate,
+/// an xor and a single multiplication.
+///
+/// It is the cheapest of the hashers here for keys made of integers, such
+/// as ids and indices: hashing a `u64` costs two multiplications.
+/// Byte strings are folded in a word at a time. Like `FnvHasher` it is not
+/// keyed and does not resist deliberately colliding keys, so only use it
+/// for hash maps whose keys cannot be chosen by an adversary.
+///
+/// # Examples
+///
+/// ```rust
+/// # #![feature(hash, std_misc)]
+/// use std::collections::HashMap;
+/// use std::collections::hash_state::DefaultState;
+/// use std::default::Default;
+/// use std::hash::MulHasher;
+///
+/// let mut map: HashMap<u32, &str, DefaultState<MulHasher>> = Default::default();
+/// map.insert(7, "seven");
+/// assert_eq!(map[&7], "seven");
+/// ```
+#[unstable(feature = "hash", reason = "recently added, may be renamed")]
+#[derive(Clone)]
+pub struct MulHasher {
+    hash: u64,
+}
+
+impl MulHasher {
+    #[inline]
+    fn add(&mut self, word: u64) {
+        self.hash = (self.hash.rotate_left(5) ^ word).wrapping_mul(SEED);
+    }
+}
+
+#[unstable(feature = "hash", reason = "recently added, may be renamed")]
+impl Default for MulHasher {
+    #[inline]
+    fn default() -> MulHasher { MulHasher { hash: 0 } }
+}
+
+#[unstable(feature = "hash", reason = "recently added, may be renamed")]
+impl Hasher for MulHasher {
+    #[inline]
+    fn write(&mut self, bytes: &[u8]) {
+        let mut rest = bytes;
+        while rest.len() >= 8 {
+            let mut word = 0u64;
+            unsafe {
+                ptr::copy_nonoverlapping(rest.as_ptr(),
+                                         &mut word as *mut u64 as *mut u8,
+                                         mem::size_of::<u64>());
+            }
+            self.add(word.to_le());
+            rest = &rest[8..];
+        }
+        if rest.len() > 0 {
+            // The length goes in the top byte, so that trailing zeroes are
+            // not lost.
+            let mut word = (rest.len() as u64) << 56;
+            for (i, &byte) in rest.iter().enumerate() {
+                word |= (byte as u64) << (8 * i);
+            }
+            self.add(word);
+        }
+    }
+
+    #[inline]
+    fn write_u8(&mut self, i: u8) { self.add(i as u64) }
+    #[inline]
+    fn write_u16(&mut self, i: u16) { self.add(i as u64) }
+    #[inline]
+    fn write_u32(&mut self, i: u32) { self.add(i as u64) }
+    #[inline]
+    fn write_u64(&mut self, i: u64) { self.add(i) }
+    #[inline]
+    fn write_usize(&mut self, i: usize) { self.add(i as u64) }
+
+    // A multiplication only carries entropy upwards, towards the high bits,
+    // but hash tables index by the low ones. Shifting down before and after
+    // one more multiplication spreads every input bit over the whole word.
+    #[inline]
+    fn finish(&self) -> u64 {
+        let hash = (self.hash ^ (self.hash >> 32)).wrapping_mul(SEED);
+        hash ^ (hash >> 29)
+    }
+}
@@ -13,6 +13,8 @@
 #![allow(deprecated)] // until the next snapshot for inherent wrapping ops
 
 use prelude::*;
+use mem;
+use ptr;
 use super::Hasher;
 
 /// An implementation of SipHash 2-4.
@@ -45,24 +47,42 @@ pub struct SipHasher {
 // because they're needed in the following defs;
 // this design could be improved.
 
+// Loads an integer of the given type from `$buf` at `$i`, little-endian,
+// with a single unaligned load. The bytes must be in bounds.
+macro_rules! load_int_le {
+    ($buf:expr, $i:expr, $int_ty:ident) =>
+    ({
+        debug_assert!($i + mem::size_of::<$int_ty>() <= $buf.len());
+        let mut data = 0 as $int_ty;
+        ptr::copy_nonoverlapping($buf.as_ptr().offset($i as isize),
+                                 &mut data as *mut $int_ty as *mut u8,
+                                 mem::size_of::<$int_ty>());
+        data.to_le()
+    });
+}
+
+// Loads the `$len < 8` bytes of `$buf` from `$i` into a u64, little-endian,
+// with at most three loads.
 macro_rules! u8to64_le {
-    ($buf:expr, $i:expr) =>
-    ($buf[0+$i] as u64 |
-     ($buf[1+$i] as u64) << 8 |
-     ($buf[2+$i] as u64) << 16 |
-     ($buf[3+$i] as u64) << 24 |
-     ($buf[4+$i] as u64) << 32 |
-     ($buf[5+$i] as u64) << 40 |
-     ($buf[6+$i] as u64) << 48 |
-     ($buf[7+$i] as u64) << 56);
     ($buf:expr, $i:expr, $len:expr) =>
     ({
-        let mut t = 0;
+        let (buf, start, len) = ($buf, $i, $len);
+        debug_assert!(len < 8);
+        let mut i = 0;
         let mut out = 0;
-        while t < $len {
-            out |= ($buf[t+$i] as u64) << t*8;
-            t += 1;
+        if i + 3 < len {
+            out = unsafe { load_int_le!(buf, start + i, u32) } as u64;
+            i += 4;
         }
+        if i + 1 < len {
+            out |= (unsafe { load_int_le!(buf, start + i, u16) } as u64) << (i * 8);
+            i += 2;
+        }
+        if i < len {
+            out |= (buf[start + i] as u64) << (i * 8);
+            i += 1;
+        }
+        debug_assert_eq!(i, len);
         out
     });
 }
@@ -117,6 +137,7 @@ impl SipHasher {
         self.v1 = self.k1 ^ 0x646f72616e646f6d;
         self.v2 = self.k0 ^ 0x6c7967656e657261;
         self.v3 = self.k1 ^ 0x7465646279746573;
+        self.tail = 0;
         self.ntail = 0;
     }
 
@@ -151,7 +172,7 @@ impl SipHasher {
 
         let mut i = needed;
         while i < end {
-            let mi = u8to64_le!(msg, i);
+            let mi = unsafe { load_int_le!(msg, i, u64) };
 
             self.v3 ^= mi;
             compress!(self.v0, self.v1, self.v2, self.v3);
@@ -164,6 +185,32 @@ impl SipHasher {
         self.tail = u8to64_le!(msg, i, left);
         self.ntail = left;
     }
+
+    /// Writes the low `size` bytes of `x`, which must be zero above them,
+    /// as if they had been passed to `write` in little-endian order. Hashing
+    /// an integer this way skips `write`'s general loop.
+    #[inline]
+    fn short_write(&mut self, x: u64, size: usize) {
+        self.length += size;
+
+        // The bytes that do not fit in the tail are shifted out here, and
+        // picked up again below.
+        self.tail |= x << (8 * self.ntail);
+        if self.ntail + size < 8 {
+            self.ntail += size;
+            return
+        }
+
+        let m = self.tail;
+        self.v3 ^= m;
+        compress!(self.v0, self.v1, self.v2, self.v3);
+        compress!(self.v0, self.v1, self.v2, self.v3);
+        self.v0 ^= m;
+
+        let used = 8 - self.ntail;
+        self.ntail = size - used;
+        self.tail = if used < 8 { x >> (8 * used) } else { 0 };
+    }
 }
 
 #[stable(feature = "rust1", since = "1.0.0")]
@@ -173,6 +220,31 @@ impl Hasher for SipHasher {
         self.write(msg)
     }
 
+    #[inline]
+    fn write_u8(&mut self, i: u8) {
+        self.short_write(i as u64, 1)
+    }
+
+    #[inline]
+    fn write_u16(&mut self, i: u16) {
+        self.short_write(i.to_le() as u64, 2)
+    }
+
+    #[inline]
+    fn write_u32(&mut self, i: u32) {
+        self.short_write(i.to_le() as u64, 4)
+    }
+
+    #[inline]
+    fn write_u64(&mut self, i: u64) {
+        self.short_write(i.to_le(), 8)
+    }
+
+    #[inline]
+    fn write_usize(&mut self, i: usize) {
+        self.short_write(i.to_le() as u64, ::usize::BYTES)
+    }
+
     fn finish(&self) -> u64 {
         let mut v0 = self.v0;
         let mut v1 = self.v1;
@@ -9,8 +9,12 @@
 // except according to those terms.
 
 use std::mem;
-use std::hash::{Hash, Hasher};
+use std::hash::{Hash, Hasher, SipHasher, FnvHasher, MulHasher};
 use std::default::Default;
+use std::collections::HashSet;
+use test::Bencher;
+
+mod sip;
 
 struct MyHasher {
     hash: u64,
@@ -110,3 +114,65 @@ fn test_custom_state() {
 
     assert_eq!(hash(&Custom { hash: 5 }), 5);
 }
+
+fn hash_bytes<H: Hasher + Default>(bytes: &[u8]) -> u64 {
+    let mut state: H = Default::default();
+    state.write(bytes);
+    state.finish()
+}
+
+#[test]
+fn test_fnv_hasher() {
+    assert_eq!(hash_bytes::<FnvHasher>(b""), 0xcbf29ce484222325);
+    assert_eq!(hash_bytes::<FnvHasher>(b"a"), 0xaf63dc4c8601ec8c);
+    assert_eq!(hash_bytes::<FnvHasher>(b"foobar"), 0x85944171f73967e8);
+}
+
+#[test]
+fn test_mul_hasher_bytes() {
+    assert!(hash_bytes::<MulHasher>(b"\x01") != hash_bytes::<MulHasher>(b"\x01\0"));
+    assert!(hash_bytes::<MulHasher>(b"abcdefgh") != hash_bytes::<MulHasher>(b"abcdefgi"));
+    assert!(hash_bytes::<MulHasher>(b"abcdefghi") != hash_bytes::<MulHasher>(b"abcdefghj"));
+}
+
+#[test]
+fn test_mul_hasher_low_bits() {
+    // However the bits of the keys are placed, the low bits of their hashes
+    // should be about as varied as those of random numbers.
+    for shift in 0..57 {
+        let low: HashSet<u64> = (0..256u64).map(|i| {
+            ::std::hash::hash::<_, MulHasher>(&(i << shift)) & 0xffff
+        }).collect();
+        assert!(low.len() >= 250);
+    }
+}
+
+const LONG_STR: &'static str = "Lorem ipsum dolor sit amet, consectetur adipisicing elit, sed do \
+eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis \
+nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.";
+
+// The cost of hashing one key, for each hasher and a few kinds of key.
+macro_rules! bench_hashers {
+    ($($name:ident: $hasher:ty, $key:expr;)*) => {$(
+        #[bench]
+        fn $name(b: &mut Bencher) {
+            let key = $key;
+            b.iter(|| ::std::hash::hash::<_, $hasher>(&key))
+        }
+    )*}
+}
+
+bench_hashers! {
+    bench_sip_u32: SipHasher, 0xdeadbeef_u32;
+    bench_fnv_u32: FnvHasher, 0xdeadbeef_u32;
+    bench_mul_u32: MulHasher, 0xdeadbeef_u32;
+    bench_sip_u64: SipHasher, 0xdeadbeef_deadbeef_u64;
+    bench_fnv_u64: FnvHasher, 0xdeadbeef_deadbeef_u64;
+    bench_mul_u64: MulHasher, 0xdeadbeef_deadbeef_u64;
+    bench_sip_short_str: SipHasher, "foobarbaz0";
+    bench_fnv_short_str: FnvHasher, "foobarbaz0";
+    bench_mul_short_str: MulHasher, "foobarbaz0";
+    bench_sip_long_str: SipHasher, LONG_STR;
+    bench_fnv_long_str: FnvHasher, LONG_STR;
+    bench_mul_long_str: MulHasher, LONG_STR;
+}
@@ -8,30 +8,34 @@
 // option. This file may not be copied, modified, or distributed
 // except according to those terms.
 use test::Bencher;
-use std::prelude::*;
-use std::fmt;
 
-use str::Str;
-use string::String;
-use slice::{AsSlice, SlicePrelude};
-use vec::Vec;
-
-use core::hash::{Hash, Writer};
-use core::hash::sip::{SipState, hash, hash_with_keys};
+use core::hash::{Hash, Hasher, SipHasher};
 
 // Hash just the bytes of the slice, without length prefix
 struct Bytes<'a>(&'a [u8]);
 
-impl<'a, S: Writer> Hash<S> for Bytes<'a> {
-    #[allow(unused_must_use)]
-    fn hash(&self, state: &mut S) {
+impl<'a> Hash for Bytes<'a> {
+    fn hash<H: Hasher>(&self, state: &mut H) {
         let Bytes(v) = *self;
         state.write(v);
     }
 }
 
+fn hash_with_keys<T: Hash>(k0: u64, k1: u64, x: &T) -> u64 {
+    let mut st = SipHasher::new_with_keys(k0, k1);
+    x.hash(&mut st);
+    st.finish()
+}
+
+fn hash<T: Hash>(x: &T) -> u64 {
+    hash_with_keys(0, 0, x)
+}
+
+fn u8to64_le(buf: &[u8]) -> u64 {
+    buf.iter().rev().fold(0, |acc, &b| acc << 8 | b as u64)
+}
+
 #[test]
-#[allow(unused_must_use)]
 fn test_siphash() {
     let vecs : [[u8; 8]; 64] = [
         [ 0x31, 0x0e, 0x0e, 0xdd, 0x47, 0xdb, 0x6f, 0x72, ],
@@ -104,54 +108,13 @@ fn test_siphash() {
     let k1 = 0x_0f_0e_0d_0c_0b_0a_09_08;
     let mut buf = Vec::new();
     let mut t = 0;
-    let mut state_inc = SipState::new_with_keys(k0, k1);
-    let mut state_full = SipState::new_with_keys(k0, k1);
-
-    fn to_hex_str(r: &[u8; 8]) -> String {
-        let mut s = String::new();
-        for b in r {
-            s.push_str(format!("{}", fmt::radix(*b, 16)));
-        }
-        s
-    }
-
-    fn result_bytes(h: u64) -> Vec<u8> {
-        vec![(h >> 0) as u8,
-          (h >> 8) as u8,
-          (h >> 16) as u8,
-          (h >> 24) as u8,
-          (h >> 32) as u8,
-          (h >> 40) as u8,
-          (h >> 48) as u8,
-          (h >> 56) as u8,
-        ]
-    }
-
-    fn result_str(h: u64) -> String {
-        let r = result_bytes(h);
-        let mut s = String::new();
-        for b in &r {
-            s.push_str(format!("{}", fmt::radix(*b, 16)));
-        }
-        s
-    }
+    let mut state_inc = SipHasher::new_with_keys(k0, k1);
 
     while t < 64 {
-        debug!("siphash test {}: {}", t, buf);
-        let vec = u8to64_le!(vecs[t], 0);
-        let out = hash_with_keys(k0, k1, &Bytes(buf));
-        debug!("got {}, expected {}", out, vec);
+        let vec = u8to64_le(&vecs[t]);
+        let out = hash_with_keys(k0, k1, &Bytes(&buf));
         assert_eq!(vec, out);
-
-        state_full.reset();
-        state_full.write(buf);
-        let f = result_str(state_full.result());
-        let i = result_str(state_inc.result());
-        let v = to_hex_str(&vecs[t]);
-        debug!("{}: ({}) => inc={} full={}", t, v, i, f);
-
-        assert_eq!(f, i);
-        assert_eq!(f, v);
+        assert_eq!(vec, state_inc.finish());
 
         buf.push(t as u8);
         state_inc.write(&[t as u8]);
@@ -160,23 +123,54 @@ fn test_siphash() {
     }
 }
 
-#[test] #[cfg(target_arch = "arm")]
-fn test_hash_uint() {
-    let val = 0xdeadbeef_deadbeef_u64;
-    assert!(hash(&(val as u64)) != hash(&(val as uint)));
-    assert_eq!(hash(&(val as u32)), hash(&(val as uint)));
+// Integers are written into the hasher by a separate path from byte slices,
+// which must agree with it however the two are interleaved.
+#[test]
+fn test_siphash_write_ints() {
+    let k0 = 0x_07_06_05_04_03_02_01_00;
+    let k1 = 0x_0f_0e_0d_0c_0b_0a_09_08;
+    let bytes: Vec<u8> = (0..64).map(|i| (i * 37 + 11) as u8).collect();
+
+    for start in 0..9 {
+        for &size in &[1, 2, 4, 8] {
+            let mut by_bytes = SipHasher::new_with_keys(k0, k1);
+            let mut by_ints = SipHasher::new_with_keys(k0, k1);
+            by_bytes.write(&bytes[..start]);
+            by_ints.write(&bytes[..start]);
+
+            let mut i = start;
+            while i + size <= bytes.len() {
+                let chunk = &bytes[i..i + size];
+                by_bytes.write(chunk);
+                let x = u8to64_le(chunk);
+                match size {
+                    1 => by_ints.write_u8(x as u8),
+                    2 => by_ints.write_u16(u16::from_le(x as u16)),
+                    4 => by_ints.write_u32(u32::from_le(x as u32)),
+                    _ => by_ints.write_u64(u64::from_le(x)),
+                }
+                assert_eq!(by_bytes.finish(), by_ints.finish());
+                i += size;
+            }
+
+            by_bytes.write(&bytes[i..]);
+            by_ints.write(&bytes[i..]);
+            assert_eq!(by_bytes.finish(), by_ints.finish());
+        }
+    }
 }
-#[test] #[cfg(target_arch = "x86_64")]
-fn test_hash_uint() {
+
+#[test] #[cfg(target_pointer_width = "32")]
+fn test_hash_usize() {
     let val = 0xdeadbeef_deadbeef_u64;
-    assert_eq!(hash(&(val as u64)), hash(&(val as uint)));
-    assert!(hash(&(val as u32)) != hash(&(val as uint)));
+    assert!(hash(&(val as u64)) != hash(&(val as usize)));
+    assert_eq!(hash(&(val as u32)), hash(&(val as usize)));
 }
-#[test] #[cfg(target_arch = "x86")]
-fn test_hash_uint() {
+#[test] #[cfg(target_pointer_width = "64")]
+fn test_hash_usize() {
     let val = 0xdeadbeef_deadbeef_u64;
-    assert!(hash(&(val as u64)) != hash(&(val as uint)));
-    assert_eq!(hash(&(val as u32)), hash(&(val as uint)));
+    assert_eq!(hash(&(val as u64)), hash(&(val as usize)));
+    assert!(hash(&(val as u32)) != hash(&(val as usize)));
 }
 
 #[test]
@@ -200,7 +194,7 @@ fn test_hash_no_bytes_dropped_64() {
     assert!(hash(&val) != hash(&zero_byte(val, 6)));
     assert!(hash(&val) != hash(&zero_byte(val, 7)));
 
-    fn zero_byte(val: u64, byte: uint) -> u64 {
+    fn zero_byte(val: u64, byte: usize) -> u64 {
         assert!(byte < 8);
         val & !(0xff << (byte * 8))
     }
@@ -215,7 +209,7 @@ fn test_hash_no_bytes_dropped_32() {
     assert!(hash(&val) != hash(&zero_byte(val, 2)));
     assert!(hash(&val) != hash(&zero_byte(val, 3)));
 
-    fn zero_byte(val: u32, byte: uint) -> u32 {
+    fn zero_byte(val: u32, byte: usize) -> u32 {
         assert!(byte < 4);
         val & !(0xff << (byte * 8))
     }
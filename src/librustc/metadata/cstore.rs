@@ -18,12 +18,13 @@ pub use self::LinkagePreference::*;
 pub use self::NativeLibraryKind::*;
 
 use back::svh::Svh;
+use metadata::creader;
 use metadata::decoder;
 use metadata::loader;
 use session::search_paths::PathKind;
 use util::nodemap::{FnvHashMap, NodeMap};
 
-use std::cell::RefCell;
+use std::cell::{Cell, Ref, RefCell};
 use std::rc::Rc;
 use std::path::PathBuf;
 use flate::Bytes;
@@ -58,7 +59,11 @@ pub struct crate_metadata {
     pub data: MetadataBlob,
     pub cnum_map: cnum_map,
     pub cnum: ast::CrateNum,
-    pub codemap_import_info: Vec<ImportedFileMap>,
+    /// Empty until the first call to `imported_filemaps`.
+    pub codemap_import_info: RefCell<Vec<ImportedFileMap>>,
+    /// Whether `codemap_import_info` has been filled in, which a crate
+    /// without source files leaves empty.
+    pub codemap_imported: Cell<bool>,
     pub span: codemap::Span,
 }
 
@@ -240,6 +245,20 @@ impl crate_metadata {
     pub fn data<'a>(&'a self) -> &'a [u8] { self.data.as_slice() }
     pub fn name(&self) -> String { decoder::get_crate_name(self.data()) }
     pub fn hash(&self) -> Svh { decoder::get_crate_hash(self.data()) }
+
+    /// Returns the FileMaps of this crate's codemap, importing them into
+    /// `local_codemap` on first use. Importing them decodes the line tables
+    /// of every source file of the crate, which is only needed if an item
+    /// of the crate gets inlined, so it is not done when the crate is loaded.
+    pub fn imported_filemaps<'a>(&'a self, local_codemap: &codemap::CodeMap)
+                                 -> Ref<'a, Vec<ImportedFileMap>> {
+        if !self.codemap_imported.get() {
+            *self.codemap_import_info.borrow_mut() =
+                creader::import_codemap(local_codemap, &self.data);
+            self.codemap_imported.set(true);
+        }
+        self.codemap_import_info.borrow()
+    }
 }
 
 impl MetadataBlob {
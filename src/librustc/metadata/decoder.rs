@@ -34,7 +34,6 @@ use util::nodemap::FnvHashMap;
 
 use std::cell::{Cell, RefCell};
 use std::collections::HashMap;
-use std::hash::{self, Hash, SipHasher};
 use std::io::prelude::*;
 use std::io;
 use std::rc::Rc;
@@ -67,38 +66,25 @@ fn u32_from_be_bytes(bytes: &[u8]) -> u32 {
     unsafe { (*(b.as_ptr() as *const u32)).to_be() }
 }
 
-fn lookup_hash<'a, F>(d: rbml::Doc<'a>, mut eq_fn: F, hash: u64) -> Option<rbml::Doc<'a>> where
-    F: FnMut(&[u8]) -> bool,
-{
-    let index = reader::get_doc(d, tag_index);
-    let table = reader::get_doc(index, tag_index_table);
-    let hash_pos = table.start + (hash % 256 * 4) as usize;
-    let pos = u32_from_be_bytes(&d.data[hash_pos..]) as usize;
-    let tagged_doc = reader::doc_at(d.data, pos).unwrap();
-
-    let belt = tag_index_buckets_bucket_elt;
-
-    let mut ret = None;
-    reader::tagged_docs(tagged_doc.doc, belt, |elt| {
-        let pos = u32_from_be_bytes(&elt.data[elt.start..]) as usize;
-        if eq_fn(&elt.data[elt.start + 4 .. elt.end]) {
-            ret = Some(reader::doc_at(d.data, pos).unwrap().doc);
-            false
-        } else {
-            true
-        }
-    });
-    ret
-}
-
+/// Looks up `item_id` in the index of `items` (see `encoder::encode_index`).
 pub fn maybe_find_item<'a>(item_id: ast::NodeId,
                            items: rbml::Doc<'a>) -> Option<rbml::Doc<'a>> {
-    fn eq_item(bytes: &[u8], item_id: ast::NodeId) -> bool {
-        u32_from_be_bytes(bytes) == item_id
+    let index = reader::get_doc(items, tag_index);
+    if index.end - index.start < 4 {
+        return None
+    }
+    let first = u32_from_be_bytes(&index.data[index.start..]);
+    if item_id < first {
+        return None
+    }
+    let slot = index.start + 4 + 4 * (item_id - first) as usize;
+    if slot + 4 > index.end {
+        return None
+    }
+    match u32_from_be_bytes(&index.data[slot..]) {
+        0xffff_ffff => None,
+        pos => Some(reader::doc_at(items.data, pos as usize).unwrap().doc),
     }
-    lookup_hash(items,
-                |a| eq_item(a, item_id),
-                hash::hash::<i64, SipHasher>(&(item_id as i64)))
 }
 
 fn find_item<'a>(item_id: ast::NodeId, items: rbml::Doc<'a>) -> rbml::Doc<'a> {
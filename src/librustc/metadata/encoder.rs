@@ -29,9 +29,9 @@ use util::nodemap::{FnvHashMap, NodeMap, NodeSet};
 
 use serialize::Encodable;
 use std::cell::RefCell;
-use std::hash::{Hash, Hasher, SipHasher};
 use std::io::prelude::*;
 use std::io::{Cursor, SeekFrom};
+use std::iter::repeat;
 use syntax::abi;
 use syntax::ast::{self, DefId, NodeId};
 use syntax::ast_map::{self, LinkedPath, PathElem, PathElems};
@@ -297,7 +297,7 @@ fn encode_enum_variant_info(ecx: &EncodeContext,
             val: variant.node.id as i64,
             pos: rbml_w.mark_stable_position(),
         });
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         match variant.node.kind {
             ast::TupleVariantKind(_) => encode_family(rbml_w, 'v'),
@@ -321,7 +321,7 @@ fn encode_enum_variant_info(ecx: &EncodeContext,
                                                  &fields[..],
                                                  index);
                 encode_struct_fields(rbml_w, &fields[..], def_id);
-                encode_index(rbml_w, idx, write_i64);
+                encode_index(rbml_w, idx);
             }
         }
         if (*vi)[i].disr_val != disr_val {
@@ -518,7 +518,7 @@ fn encode_info_for_mod(ecx: &EncodeContext,
                        path: PathElems,
                        name: ast::Name,
                        vis: ast::Visibility) {
-    rbml_w.start_tag(tag_items_data_item);
+    rbml_w.start_indexed_tag(tag_items_data_item);
     encode_def_id(rbml_w, local_def(id));
     encode_family(rbml_w, 'm');
     encode_name(rbml_w, name);
@@ -645,7 +645,7 @@ fn encode_info_for_struct(ecx: &EncodeContext,
             val: id as i64,
             pos: pos,
         });
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         debug!("encode_info_for_struct: doing {} {}",
                token::get_name(nm), id);
         encode_struct_field_family(rbml_w, field.vis);
@@ -672,7 +672,7 @@ fn encode_info_for_struct_ctor(ecx: &EncodeContext,
         pos: rbml_w.mark_stable_position(),
     });
 
-    rbml_w.start_tag(tag_items_data_item);
+    rbml_w.start_indexed_tag(tag_items_data_item);
     encode_def_id(rbml_w, local_def(ctor_id));
     encode_family(rbml_w, 'o');
     encode_bounds_and_type_for_item(rbml_w, ecx, ctor_id);
@@ -809,7 +809,7 @@ fn encode_info_for_associated_const(ecx: &EncodeContext,
            associated_const.def_id,
            token::get_name(associated_const.name));
 
-    rbml_w.start_tag(tag_items_data_item);
+    rbml_w.start_indexed_tag(tag_items_data_item);
 
     encode_def_id(rbml_w, associated_const.def_id);
     encode_name(rbml_w, associated_const.name);
@@ -846,7 +846,7 @@ fn encode_info_for_method<'a, 'tcx>(ecx: &EncodeContext<'a, 'tcx>,
 
     debug!("encode_info_for_method: {:?} {:?}", m.def_id,
            token::get_name(m.name));
-    rbml_w.start_tag(tag_items_data_item);
+    rbml_w.start_indexed_tag(tag_items_data_item);
 
     encode_method_ty_fields(ecx, rbml_w, m);
     encode_parent_item(rbml_w, local_def(parent_id));
@@ -889,7 +889,7 @@ fn encode_info_for_associated_type(ecx: &EncodeContext,
            associated_type.def_id,
            token::get_name(associated_type.name));
 
-    rbml_w.start_tag(tag_items_data_item);
+    rbml_w.start_indexed_tag(tag_items_data_item);
 
     encode_def_id(rbml_w, associated_type.def_id);
     encode_name(rbml_w, associated_type.name);
@@ -1017,7 +1017,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
     match item.node {
       ast::ItemStatic(_, m, _) => {
         add_to_index(item, rbml_w, index);
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         if m == ast::MutMutable {
             encode_family(rbml_w, 'b');
@@ -1035,7 +1035,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
       }
       ast::ItemConst(_, _) => {
         add_to_index(item, rbml_w, index);
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, 'C');
         encode_bounds_and_type_for_item(rbml_w, ecx, item.id);
@@ -1049,7 +1049,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
       }
       ast::ItemFn(ref decl, _, _, ref generics, _) => {
         add_to_index(item, rbml_w, index);
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, FN_FAMILY);
         let tps_len = generics.ty_params.len();
@@ -1081,7 +1081,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
       }
       ast::ItemForeignMod(ref fm) => {
         add_to_index(item, rbml_w, index);
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, 'n');
         encode_name(rbml_w, item.ident.name);
@@ -1098,7 +1098,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
       }
       ast::ItemTy(..) => {
         add_to_index(item, rbml_w, index);
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, 'y');
         encode_bounds_and_type_for_item(rbml_w, ecx, item.id);
@@ -1111,7 +1111,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
       ast::ItemEnum(ref enum_definition, _) => {
         add_to_index(item, rbml_w, index);
 
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, 't');
         encode_item_variances(rbml_w, ecx, item.id);
@@ -1154,7 +1154,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
         add_to_index(item, rbml_w, index);
 
         /* Now, make an item for the class itself */
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, 'S');
         encode_bounds_and_type_for_item(rbml_w, ecx, item.id);
@@ -1178,7 +1178,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
         encode_inherent_implementations(ecx, rbml_w, def_id);
 
         /* Each class has its own index -- encode it */
-        encode_index(rbml_w, idx, write_i64);
+        encode_index(rbml_w, idx);
         rbml_w.end_tag();
 
         // If this is a tuple-like struct, encode the type of the constructor.
@@ -1192,7 +1192,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
       }
       ast::ItemDefaultImpl(unsafety, _) => {
           add_to_index(item, rbml_w, index);
-          rbml_w.start_tag(tag_items_data_item);
+          rbml_w.start_indexed_tag(tag_items_data_item);
           encode_def_id(rbml_w, def_id);
           encode_family(rbml_w, 'd');
           encode_name(rbml_w, item.ident.name);
@@ -1209,7 +1209,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
         let items = impl_items.get(&def_id).unwrap();
 
         add_to_index(item, rbml_w, index);
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, 'i');
         encode_bounds_and_type_for_item(rbml_w, ecx, item.id);
@@ -1298,7 +1298,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
       }
       ast::ItemTrait(_, _, _, ref ms) => {
         add_to_index(item, rbml_w, index);
-        rbml_w.start_tag(tag_items_data_item);
+        rbml_w.start_indexed_tag(tag_items_data_item);
         encode_def_id(rbml_w, def_id);
         encode_family(rbml_w, 'I');
         encode_item_variances(rbml_w, ecx, item.id);
@@ -1358,7 +1358,7 @@ fn encode_info_for_item(ecx: &EncodeContext,
                 pos: rbml_w.mark_stable_position(),
             });
 
-            rbml_w.start_tag(tag_items_data_item);
+            rbml_w.start_indexed_tag(tag_items_data_item);
 
             encode_parent_item(rbml_w, def_id);
 
@@ -1478,7 +1478,7 @@ fn encode_info_for_foreign_item(ecx: &EncodeContext,
         pos: rbml_w.mark_stable_position(),
     });
 
-    rbml_w.start_tag(tag_items_data_item);
+    rbml_w.start_indexed_tag(tag_items_data_item);
     encode_def_id(rbml_w, local_def(nitem.id));
     encode_visibility(rbml_w, nitem.vis);
     match nitem.node {
@@ -1597,53 +1597,39 @@ fn encode_info_for_items(ecx: &EncodeContext,
 }
 
 
-// Path and definition ID indexing
-
-fn encode_index<T, F>(rbml_w: &mut Encoder, index: Vec<entry<T>>, mut write_fn: F) where
-    F: FnMut(&mut Cursor<Vec<u8>>, &T),
-    T: Hash,
-{
-    let mut buckets: Vec<Vec<entry<T>>> = (0..256u16).map(|_| Vec::new()).collect();
-    for elt in index {
-        let mut s = SipHasher::new();
-        elt.val.hash(&mut s);
-        let h = s.finish() as usize;
-        (&mut buckets[h % 256]).push(elt);
-    }
+// Definition ID indexing
+//
+// The index of a document is a table of the positions of its items, indexed
+// directly by node ID: the first node ID in the table, then one big-endian
+// u32 position for each ID from there to the last indexed one, or
+// `0xffff_ffff` for IDs which are not indexed. It is read in place by
+// `decoder::maybe_find_item`.
 
+fn encode_index(rbml_w: &mut Encoder, index: Vec<entry<i64>>) {
     rbml_w.start_tag(tag_index);
-    let mut bucket_locs = Vec::new();
-    rbml_w.start_tag(tag_index_buckets);
-    for bucket in &buckets {
-        bucket_locs.push(rbml_w.mark_stable_position());
-        rbml_w.start_tag(tag_index_buckets_bucket);
-        for elt in bucket {
-            rbml_w.start_tag(tag_index_buckets_bucket_elt);
+    if !index.is_empty() {
+        let first = index.iter().map(|elt| elt.val).min().unwrap();
+        let last = index.iter().map(|elt| elt.val).max().unwrap();
+        assert!(first >= 0 && last < 0xffff_ffff);
+
+        let mut positions: Vec<u32> = repeat(0xffff_ffff).take((last - first + 1) as usize)
+                                                         .collect();
+        for elt in &index {
             assert!(elt.pos < 0xffff_ffff);
-            {
-                let wr: &mut Cursor<Vec<u8>> = rbml_w.writer;
-                write_be_u32(wr, elt.pos as u32);
+            // the first entry for an ID wins, as it did with the old index
+            let slot = &mut positions[(elt.val - first) as usize];
+            if *slot == 0xffff_ffff {
+                *slot = elt.pos as u32;
             }
-            write_fn(rbml_w.writer, &elt.val);
-            rbml_w.end_tag();
         }
-        rbml_w.end_tag();
-    }
-    rbml_w.end_tag();
-    rbml_w.start_tag(tag_index_table);
-    for pos in &bucket_locs {
-        assert!(*pos < 0xffff_ffff);
+
         let wr: &mut Cursor<Vec<u8>> = rbml_w.writer;
-        write_be_u32(wr, *pos as u32);
+        write_be_u32(wr, first as u32);
+        for &pos in &positions {
+            write_be_u32(wr, pos);
+        }
     }
     rbml_w.end_tag();
-    rbml_w.end_tag();
-}
-
-fn write_i64(writer: &mut Cursor<Vec<u8>>, &n: &i64) {
-    let wr: &mut Cursor<Vec<u8>> = writer;
-    assert!(n < 0x7fff_ffff);
-    write_be_u32(wr, n as u32);
 }
 
 fn write_be_u32(w: &mut Write, u: u32) {
@@ -2005,7 +1991,7 @@ fn encode_dylib_dependency_formats(rbml_w: &mut Encoder, ecx: &EncodeContext) {
 
 // NB: Increment this as you change the metadata encoding version.
 #[allow(non_upper_case_globals)]
-pub const metadata_encoding_version : &'static [u8] = &[b'r', b'u', b's', b't', 0, 0, 0, 2 ];
+pub const metadata_encoding_version : &'static [u8] = &[b'r', b'u', b's', b't', 0, 0, 0, 3 ];
 
 pub fn encode_metadata(parms: EncodeParams, krate: &ast::Crate) -> Vec<u8> {
     let mut wr = Cursor::new(Vec::new());
@@ -2162,7 +2148,7 @@ fn encode_metadata_inner(wr: &mut Cursor<Vec<u8>>,
     stats.item_bytes = rbml_w.writer.seek(SeekFrom::Current(0)).unwrap() - i;
 
     i = rbml_w.writer.seek(SeekFrom::Current(0)).unwrap();
-    encode_index(&mut rbml_w, items_index, write_i64);
+    encode_index(&mut rbml_w, items_index);
     stats.index_bytes = rbml_w.writer.seek(SeekFrom::Current(0)).unwrap() - i;
     rbml_w.end_tag();
 
@@ -715,7 +715,7 @@ impl ArchiveMetadata {
 }
 
 // Just a small wrapper to time how long reading metadata takes.
-fn get_metadata_section(is_osx: bool, filename: &Path) -> Result<MetadataBlob, String> {
+pub fn get_metadata_section(is_osx: bool, filename: &Path) -> Result<MetadataBlob, String> {
     let mut ret = None;
     let dur = Duration::span(|| {
         ret = Some(get_metadata_section_imp(is_osx, filename));
@@ -227,12 +227,13 @@ impl<'a, 'b, 'tcx> DecodeContext<'a, 'b, 'tcx> {
     }
 
     /// Translates a `Span` from an extern crate to the corresponding `Span`
-    /// within the local crate's codemap. `creader::import_codemap()` will
-    /// already have allocated any additionally needed FileMaps in the local
-    /// codemap as a side-effect of creating the crate_metadata's
-    /// `codemap_import_info`.
+    /// within the local crate's codemap. The first span translated from a
+    /// crate has `creader::import_codemap()` allocate any additionally needed
+    /// FileMaps in the local codemap, as a side-effect of filling in the
+    /// crate_metadata's `codemap_import_info`.
     pub fn tr_span(&self, span: Span) -> Span {
-        let imported_filemaps = &self.cdata.codemap_import_info[..];
+        let filemaps = self.cdata.imported_filemaps(self.tcx.sess.codemap());
+        let imported_filemaps = &filemaps[..];
 
         let span = if span.lo > span.hi {
             // Currently macro expansion sometimes produces invalid Span values
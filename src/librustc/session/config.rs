@@ -524,6 +524,10 @@ options! {CodegenOptions, CodegenSetter, basic_codegen_options,
         "print remarks for these optimization passes (space separated, or \"all\")"),
     no_stack_check: bool = (false, parse_bool,
         "disable checks for stack exhaustion (a memory-safety hazard!)"),
+    stack_probes: bool = (false, parse_bool,
+        "check for stack exhaustion with guard pages and stack probes, not __morestack; \
+         only functions with a page or more of locals are probed, so frames grown \
+         past a page by inlining or register spills can still skip the guard page"),
     debuginfo: Option<usize> = (None, parse_opt_uint,
         "debug info emission level, 0 = no debug info, 1 = line tables only, \
          2 = full debug info with variable and type information"),
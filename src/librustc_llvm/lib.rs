@@ -2027,7 +2027,6 @@ extern {
                                        Model: CodeGenModel,
                                        Reloc: RelocMode,
                                        Level: CodeGenOptLevel,
-                                       EnableSegstk: bool,
                                        UseSoftFP: bool,
                                        NoFramePointerElim: bool,
                                        PositionIndependentExecutable: bool,
@@ -23,6 +23,8 @@ use syntax::codemap;
 use syntax::diagnostic;
 use syntax::diagnostic::{Emitter, Handler, Level, mk_handler};
 
+use std::cmp;
+use std::env;
 use std::ffi::{CStr, CString};
 use std::fs;
 use std::iter::Unfold;
@@ -235,7 +237,6 @@ fn create_target_machine(sess: &Session) -> TargetMachineRef {
             code_model,
             reloc_model,
             opt_level,
-            true /* EnableSegstk */,
             use_softfp,
             no_fp_elim,
             !any_library && reloc_model == llvm::RelocPIC,
@@ -664,7 +665,10 @@ pub fn run_passes(sess: &Session,
     if sess.opts.cg.codegen_units == 1 {
         run_work_singlethreaded(sess, &trans.reachable, work_items);
     } else {
-        run_work_multithreaded(sess, work_items, sess.opts.cg.codegen_units);
+        // Workers pull items off a shared queue, so there is no point in
+        // running more of them than there are CPUs to run them on.
+        let num_workers = cmp::min(sess.opts.cg.codegen_units, env::num_cpus());
+        run_work_multithreaded(sess, work_items, num_workers);
     }
 
     // All codegen is finished.
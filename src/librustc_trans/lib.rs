@@ -39,6 +39,7 @@
 #![feature(path_ext)]
 #![feature(fs)]
 #![feature(path_relative_from)]
+#![feature(num_cpus)]
 
 #![allow(trivial_casts)]
 
@@ -1408,9 +1408,70 @@ pub fn finish_fn<'blk, 'tcx>(fcx: &'blk FunctionContext<'blk, 'tcx>,
     build_return_block(fcx, ret_cx, substd_retty, ret_debug_loc);
 
     debuginfo::clear_source_location(fcx);
+    probe_stack_frame(fcx);
     fcx.cleanup();
 }
 
+/// The distance between stack probes, which must be no more than the size of
+/// the guard page below each stack.
+const STACK_PROBE_INTERVAL: u64 = 4096;
+
+/// Without `__morestack` checks in the prologue, stack overflow is caught by
+/// the guard page below the stack. A frame bigger than a page could step
+/// right over it, though, and so the frames of such functions are read a page
+/// at a time from the top down before anything else in them runs, to make
+/// sure the guard page is hit first.
+///
+/// The frame is measured by its allocas, so only the register spills LLVM
+/// adds later are left unprobed. Probed functions are never inlined: the
+/// probes would then run only where the inlined body starts, after the caller
+/// may already have stored to its own allocas anywhere in the merged frame.
+/// Frames merged from several inlined functions of less than a page each
+/// remain unprobed.
+fn probe_stack_frame(fcx: &FunctionContext) {
+    let ccx = fcx.ccx;
+    if !ccx.uses_stack_probes() ||
+       attr::contains_name(ccx.tcx().map.attrs(fcx.id), "no_stack_check") {
+        return;
+    }
+
+    let mut size = 0;
+    let mut first_insn = None;
+    unsafe {
+        let alloca_insert_pt = fcx.alloca_insert_pt.get().unwrap();
+        let entry = llvm::LLVMGetInstructionParent(alloca_insert_pt);
+        let mut insn = llvm::LLVMGetFirstInstruction(entry);
+        while !insn.is_null() {
+            if llvm::LLVMIsAAllocaInst(insn).is_null() {
+                if first_insn.is_none() {
+                    first_insn = Some(insn);
+                }
+            } else {
+                let ty = Type::from_ref(llvm::LLVMTypeOf(insn)).element_type();
+                size += machine::llsize_of_alloc(ccx, ty);
+            }
+            insn = llvm::LLVMGetNextInstruction(insn);
+        }
+    }
+    if size < STACK_PROBE_INTERVAL {
+        return;
+    }
+
+    // Static allocas may sit anywhere in the entry block, but the probes must
+    // come before any other use of the frame.
+    let b = ccx.builder();
+    b.position_before(first_insn.unwrap());
+    let frame = b.call(ccx.get_intrinsic(&"llvm.frameaddress"), &[C_i32(ccx, 0)], None);
+    let mut offset = STACK_PROBE_INTERVAL;
+    while offset <= size {
+        b.volatile_load(b.gep(frame, &[C_int(ccx, -(offset as i64))]));
+        offset += STACK_PROBE_INTERVAL;
+    }
+
+    attributes::inline(fcx.llfn, attributes::InlineAttr::None);
+    attributes::inline(fcx.llfn, attributes::InlineAttr::Never);
+}
+
 // Builds the return block for a function.
 pub fn build_return_block<'blk, 'tcx>(fcx: &FunctionContext<'blk, 'tcx>,
                                       ret_cx: Block<'blk, 'tcx>,
@@ -523,7 +523,13 @@ impl<'b, 'tcx> CrateContext<'b, 'tcx> {
     }
 
     pub fn is_split_stack_supported(&self) -> bool {
-        self.sess().target.target.options.morestack
+        self.sess().target.target.options.morestack && !self.sess().opts.cg.stack_probes
+    }
+
+    /// Whether large stack frames should be probed, so that they cannot step
+    /// over the guard page below the stack. See `base::probe_stack_frame`.
+    pub fn uses_stack_probes(&self) -> bool {
+        self.sess().opts.cg.stack_probes && !self.sess().opts.cg.no_stack_check
     }
 
 
@@ -0,0 +1,820 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! Conversions between `f64` and the numbers of JSON text.
+//!
+//! `parse` is correctly rounded: it returns the `f64` nearest to the
+//! decimal value, ties to even. Most numbers take Clinger's fast path, a
+//! single exact multiplication or division. The Eisel-Lemire algorithm
+//! handles most of the others by scaling the leading 19 digits by a 128-bit
+//! power of five. The few numbers it cannot round with certainty fall back
+//! to exact big integer arithmetic.
+//!
+//! `format` writes the shortest decimal that parses back to the same `f64`.
+//! It finds the digits with the Ryu algorithm.
+
+use std::cmp;
+use std::fmt;
+use std::mem;
+use std::str;
+
+use self::table::{POW5_128, POW5_128_MIN, POW5_128_MAX, POW5_BITS, POW5_SPLIT, POW5_INV_SPLIT};
+
+mod table;
+
+/// Explicit bits of the significand.
+const MANTISSA_BITS: u32 = 52;
+/// Exponent bias.
+const BIAS: i32 = 1023;
+/// The biased exponent of infinities and NaNs.
+const INFINITE_EXP: i32 = 0x7ff;
+/// The bits of positive infinity.
+const INFINITY: u64 = 0x7ff0_0000_0000_0000;
+/// The most decimal digits which always fit in a `u64`.
+const MAX_DIGITS: usize = 19;
+/// Significant digits kept by the slow path. A number halfway between two
+/// adjacent `f64`s has at most 767, so the remaining digits only need to
+/// be checked for zeros.
+const SLOW_DIGITS: usize = 800;
+
+/// Powers of ten exactly representable as `f64`.
+static POW10: [f64; 23] = [1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22];
+
+/// Powers of ten which fit in a `u32`.
+static POW10_U32: [u32; 10] = [1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+                               100000000, 1000000000];
+
+fn from_bits(bits: u64) -> f64 {
+    unsafe { mem::transmute(bits) }
+}
+
+fn to_bits(v: f64) -> u64 {
+    unsafe { mem::transmute(v) }
+}
+
+/// Returns the low and high words of `a * b`.
+#[inline]
+fn mul_128(a: u64, b: u64) -> (u64, u64) {
+    let (a0, a1) = (a & 0xffff_ffff, a >> 32);
+    let (b0, b1) = (b & 0xffff_ffff, b >> 32);
+    let p00 = a0 * b0;
+    let p01 = a0 * b1;
+    let p10 = a1 * b0;
+    let p11 = a1 * b1;
+    let mid = (p00 >> 32) + (p01 & 0xffff_ffff) + (p10 & 0xffff_ffff);
+    ((p00 & 0xffff_ffff) | (mid << 32), p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32))
+}
+
+fn is_digit(c: u8) -> bool {
+    c >= b'0' && c <= b'9'
+}
+
+/// Converts the JSON number `s` to the nearest `f64`.
+///
+/// `s` must follow the JSON grammar for numbers, which the parsers check
+/// before calling this.
+pub fn parse(s: &[u8]) -> f64 {
+    if s[0] == b'-' {
+        -parse_unsigned(&s[1..])
+    } else {
+        parse_unsigned(s)
+    }
+}
+
+fn parse_unsigned(s: &[u8]) -> f64 {
+    // The number is `w * 10^q`, give or take the digits after the first
+    // MAX_DIGITS significant ones, which only set `truncated`.
+    let mut w = 0u64;
+    let mut q = 0i64;
+    let mut digits = 0;
+    let mut truncated = false;
+
+    let mut i = 0;
+    while i < s.len() && is_digit(s[i]) {
+        let d = (s[i] - b'0') as u64;
+        if digits < MAX_DIGITS {
+            w = w * 10 + d;
+            if w != 0 { digits += 1; }
+        } else {
+            q += 1;
+            truncated |= d != 0;
+        }
+        i += 1;
+    }
+    if i < s.len() && s[i] == b'.' {
+        i += 1;
+        while i < s.len() && is_digit(s[i]) {
+            let d = (s[i] - b'0') as u64;
+            if digits < MAX_DIGITS {
+                w = w * 10 + d;
+                q -= 1;
+                if w != 0 { digits += 1; }
+            } else {
+                truncated |= d != 0;
+            }
+            i += 1;
+        }
+    }
+    let mantissa_end = i;
+
+    // Exponents too large for any f64 saturate rather than overflow.
+    let mut exp = 0i64;
+    if i < s.len() {
+        i += 1;
+        let neg = s[i] == b'-';
+        if neg || s[i] == b'+' { i += 1; }
+        while i < s.len() {
+            if exp < 1 << 32 {
+                exp = exp * 10 + (s[i] - b'0') as i64;
+            }
+            i += 1;
+        }
+        if neg { exp = -exp; }
+    }
+    q += exp;
+
+    if w == 0 {
+        return 0.0
+    }
+    if !truncated {
+        if let Some(v) = clinger(w, q) {
+            return v
+        }
+    }
+    // Truncated digits put the number between `w` and `w + 1`, so it rounds
+    // as they do if they agree.
+    if let Some(bits) = eisel_lemire(w, q) {
+        if !truncated || eisel_lemire(w + 1, q) == Some(bits) {
+            return from_bits(bits)
+        }
+    }
+    slow_path(&s[..mantissa_end], exp)
+}
+
+/// Converts `w * 10^q` with a single correctly rounded operation, if both
+/// operands are exact.
+fn clinger(w: u64, q: i64) -> Option<f64> {
+    if w > 1 << 53 {
+        return None
+    }
+    if q >= 0 && q <= 22 {
+        Some(w as f64 * POW10[q as usize])
+    } else if q < 0 && q >= -22 {
+        Some(w as f64 / POW10[-q as usize])
+    } else if q > 22 && q <= 22 + 15 {
+        // Moves the excess of the exponent into `w`, if it still fits.
+        match w.checked_mul(10u64.pow((q - 22) as u32)) {
+            Some(w) if w <= 1 << 53 => Some(w as f64 * 1e22),
+            _ => None,
+        }
+    } else {
+        None
+    }
+}
+
+/// `floor(log2(10^q)) + 63`, for `q` in the range of `POW5_128`.
+fn power(q: i32) -> i32 {
+    (q.wrapping_mul(152170 + 65536) >> 16) + 63
+}
+
+/// Returns the bits of the `f64` nearest to `w * 10^q`, or `None` if the
+/// 128-bit approximation of `10^q` cannot tell which that is.
+fn eisel_lemire(w: u64, q: i64) -> Option<u64> {
+    if q < POW5_128_MIN {
+        return Some(0)
+    }
+    if q > POW5_128_MAX {
+        return Some(INFINITY)
+    }
+    let lz = w.leading_zeros();
+    let w = w << lz;
+    let (hi5, lo5) = POW5_128[(q - POW5_128_MIN) as usize];
+
+    // The leading 55 bits of the product give the significand, the rounding
+    // bit and room for a leading zero. The low word of `5^q` is only needed
+    // when the bits below them are all ones, as its carry could reach them.
+    let (mut lo, mut hi) = mul_128(w, hi5);
+    let mask = !0u64 >> (MANTISSA_BITS + 3);
+    if hi & mask == mask {
+        let (_, hi2) = mul_128(w, lo5);
+        lo = lo.wrapping_add(hi2);
+        if hi2 > lo { hi += 1; }
+    }
+    // Outside of this range `5^q` is inexact in 128 bits, and the truncated
+    // part of the product could still carry.
+    if lo == !0 && (q < -27 || q > 55) {
+        return None
+    }
+
+    let upper = (hi >> 63) as u32;
+    let shift = upper + 64 - MANTISSA_BITS - 3;
+    let mut m = hi >> shift;
+    let mut e = power(q as i32) + upper as i32 - lz as i32 + BIAS;
+    if e <= 0 {
+        // Subnormal, or zero.
+        if -e + 1 >= 64 {
+            return Some(0)
+        }
+        m >>= (-e + 1) as u32;
+        m += m & 1;
+        m >>= 1;
+        // Rounding up may have reached the least normal number.
+        let e = (m >= 1 << MANTISSA_BITS) as u64;
+        return Some(m | e << MANTISSA_BITS)
+    }
+    // An exact product halfway between two `f64`s rounds to even, which only
+    // `5^q` small enough to be exact in 64 bits can produce.
+    if lo <= 1 && q >= -4 && q <= 23 && m & 3 == 1 && m << shift == hi {
+        m &= !1;
+    }
+    m += m & 1;
+    m >>= 1;
+    if m >= 2 << MANTISSA_BITS {
+        m = 1 << MANTISSA_BITS;
+        e += 1;
+    }
+    m &= !(1 << MANTISSA_BITS);
+    if e >= INFINITE_EXP {
+        return Some(INFINITY)
+    }
+    Some(m | (e as u64) << MANTISSA_BITS)
+}
+
+/// An arbitrary precision unsigned integer, as little endian 32-bit limbs
+/// with no leading zero limbs.
+struct Big {
+    limbs: Vec<u32>,
+}
+
+impl Big {
+    /// `self = self * m + a`
+    fn mul_add(&mut self, m: u32, a: u32) {
+        let mut carry = a as u64;
+        for limb in &mut self.limbs {
+            let t = *limb as u64 * m as u64 + carry;
+            *limb = t as u32;
+            carry = t >> 32;
+        }
+        if carry != 0 {
+            self.limbs.push(carry as u32);
+        }
+    }
+
+    /// `self = self << n`
+    fn shl(&mut self, n: usize) {
+        let bits = n % 32;
+        if bits != 0 {
+            let mut carry = 0;
+            for limb in &mut self.limbs {
+                let t = (*limb as u64) << bits | carry;
+                *limb = t as u32;
+                carry = t >> 32;
+            }
+            if carry != 0 {
+                self.limbs.push(carry as u32);
+            }
+        }
+        let mut limbs = vec![0; n / 32];
+        limbs.extend(self.limbs.iter().cloned());
+        self.limbs = limbs;
+    }
+
+    /// `self = self / d`, returning the remainder.
+    fn div_rem(&mut self, d: u32) -> u32 {
+        let mut rem = 0u64;
+        for limb in self.limbs.iter_mut().rev() {
+            let t = rem << 32 | *limb as u64;
+            *limb = (t / d as u64) as u32;
+            rem = t % d as u64;
+        }
+        while self.limbs.last() == Some(&0) {
+            self.limbs.pop();
+        }
+        rem as u32
+    }
+
+    fn bit_len(&self) -> usize {
+        match self.limbs.last() {
+            Some(&top) => self.limbs.len() * 32 - top.leading_zeros() as usize,
+            None => 0,
+        }
+    }
+
+    fn bit(&self, i: usize) -> bool {
+        i / 32 < self.limbs.len() && self.limbs[i / 32] >> (i % 32) & 1 != 0
+    }
+
+    /// Returns bits `start..start + 64`.
+    fn bits(&self, start: usize) -> u64 {
+        (0..64).fold(0, |acc, i| acc | (self.bit(start + i) as u64) << i)
+    }
+
+    /// Whether any of the bits below `i` is set.
+    fn any_below(&self, i: usize) -> bool {
+        let limb = cmp::min(i / 32, self.limbs.len());
+        self.limbs[..limb].iter().any(|&l| l != 0) ||
+            (limb < self.limbs.len() && self.limbs[limb] & ((1 << (i % 32)) - 1) != 0)
+    }
+}
+
+/// Rounds `big * 2^e2` to the nearest `f64`. `sticky` tells that the value
+/// is a little more than that, by less than `2^e2`.
+fn round(big: &Big, sticky: bool, e2: i64) -> f64 {
+    let len = big.bit_len() as i64;
+    let mut lsb = cmp::max(len + e2 - MANTISSA_BITS as i64 - 1, 1 - BIAS as i64 - 52);
+    let shift = lsb - e2;
+    let mut m = if shift <= 0 {
+        big.bits(0) << -shift
+    } else {
+        let shift = shift as usize;
+        let m = big.bits(shift);
+        let up = big.bit(shift - 1) && (sticky || big.any_below(shift - 1) || m & 1 != 0);
+        m + up as u64
+    };
+    if m == 1 << (MANTISSA_BITS + 1) {
+        m >>= 1;
+        lsb += 1;
+    }
+    if m < 1 << MANTISSA_BITS {
+        // Subnormal: `lsb` is the least exponent.
+        return from_bits(m)
+    }
+    let e = lsb + BIAS as i64 + MANTISSA_BITS as i64;
+    if e >= INFINITE_EXP as i64 {
+        return from_bits(INFINITY)
+    }
+    from_bits((e as u64) << MANTISSA_BITS | m & ((1 << MANTISSA_BITS) - 1))
+}
+
+/// Converts the digits of `s`, times `10^exp`, with exact arithmetic.
+fn slow_path(s: &[u8], exp: i64) -> f64 {
+    let mut big = Big { limbs: Vec::new() };
+    let mut digits = 0;
+    let mut exp = exp;
+    let mut sticky = false;
+    let mut frac = false;
+    for &c in s {
+        if c == b'.' {
+            frac = true;
+        } else if digits < SLOW_DIGITS {
+            if digits > 0 || c != b'0' {
+                big.mul_add(10, (c - b'0') as u32);
+                digits += 1;
+            }
+            if frac { exp -= 1; }
+        } else {
+            sticky |= c != b'0';
+            if !frac { exp += 1; }
+        }
+    }
+
+    // The number is at least `10^(magnitude - 1)` and less than
+    // `10^magnitude`.
+    let magnitude = digits as i64 + exp;
+    if magnitude > 310 {
+        return from_bits(INFINITY)
+    }
+    if magnitude < -324 {
+        return 0.0
+    }
+    if exp >= 0 {
+        for _ in 0..exp {
+            big.mul_add(10, 0);
+        }
+        return round(&big, sticky, 0)
+    }
+
+    // Scales the number up before dividing so that at least 55 bits are
+    // left, enough to round. `3402 / 1024` is a little over `log2(10)`.
+    let mut d = -exp as usize;
+    let k = cmp::max(0, 57 + (d * 3402 / 1024) as i64 - big.bit_len() as i64) as usize;
+    big.shl(k);
+    while d > 0 {
+        let n = cmp::min(d, 9);
+        sticky |= big.div_rem(POW10_U32[n]) != 0;
+        d -= n;
+    }
+    round(&big, sticky, -(k as i64))
+}
+
+/// A number formatted by `format`.
+pub struct Formatted {
+    buf: [u8; 32],
+    len: usize,
+}
+
+impl Formatted {
+    fn push(&mut self, s: &[u8]) {
+        for &c in s {
+            self.buf[self.len] = c;
+            self.len += 1;
+        }
+    }
+
+    pub fn as_str(&self) -> &str {
+        unsafe { str::from_utf8_unchecked(&self.buf[..self.len]) }
+    }
+}
+
+impl fmt::Display for Formatted {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str(self.as_str())
+    }
+}
+
+/// Formats `v` as a JSON number, with the fewest digits which parse back to
+/// `v`. Infinities and NaNs, which JSON cannot represent, become `null`.
+///
+/// Numbers from `1e-6` up to `1e21` are written out in full, with a
+/// fractional part even if it is zero; the others have an exponent.
+pub fn format(v: f64) -> Formatted {
+    let mut out = Formatted { buf: [0; 32], len: 0 };
+    let bits = to_bits(v);
+    let ieee_m = bits & ((1 << MANTISSA_BITS) - 1);
+    let ieee_e = (bits >> MANTISSA_BITS) as u32 & INFINITE_EXP as u32;
+    if ieee_e == INFINITE_EXP as u32 {
+        out.push(b"null");
+        return out
+    }
+    if bits >> 63 != 0 {
+        out.push(b"-");
+    }
+    if ieee_m == 0 && ieee_e == 0 {
+        out.push(b"0.0");
+        return out
+    }
+
+    let (mut m, mut e) = shortest(ieee_m, ieee_e);
+    while m % 10 == 0 {
+        m /= 10;
+        e += 1;
+    }
+    let mut digits = [0u8; 17];
+    let mut start = digits.len();
+    while m > 0 {
+        start -= 1;
+        digits[start] = b'0' + (m % 10) as u8;
+        m /= 10;
+    }
+    let digits = &digits[start..];
+    let n = digits.len() as i32;
+
+    // The decimal point goes after the first `point` digits.
+    let point = n + e;
+    if point > 0 && point <= 21 {
+        if point >= n {
+            out.push(digits);
+            for _ in n..point {
+                out.push(b"0");
+            }
+            out.push(b".0");
+        } else {
+            out.push(&digits[..point as usize]);
+            out.push(b".");
+            out.push(&digits[point as usize..]);
+        }
+    } else if point <= 0 && point > -6 {
+        out.push(b"0.");
+        for _ in point..0 {
+            out.push(b"0");
+        }
+        out.push(digits);
+    } else {
+        out.push(&digits[..1]);
+        if n > 1 {
+            out.push(b".");
+            out.push(&digits[1..]);
+        }
+        out.push(b"e");
+        let mut exp = point - 1;
+        if exp < 0 {
+            out.push(b"-");
+            exp = -exp;
+        }
+        let exp = [b'0' + (exp / 100) as u8, b'0' + (exp / 10 % 10) as u8,
+                   b'0' + (exp % 10) as u8];
+        let skip = if point - 1 >= 100 || point - 1 <= -100 { 0 }
+                   else if point - 1 >= 10 || point - 1 <= -10 { 1 }
+                   else { 2 };
+        out.push(&exp[skip..]);
+    }
+    out
+}
+
+/// `ceil(log2(5^e))`, or 1 for `e` of 0.
+fn pow5_bits(e: i32) -> i32 {
+    (((e as u32) * 1217359) >> 19) as i32 + 1
+}
+
+/// `floor(log10(2^e))`
+fn log10_pow2(e: i32) -> u32 {
+    ((e as u32) * 78913) >> 18
+}
+
+/// `floor(log10(5^e))`
+fn log10_pow5(e: i32) -> u32 {
+    ((e as u32) * 732923) >> 20
+}
+
+fn pow5_factor(mut v: u64) -> u32 {
+    let mut count = 0;
+    while v % 5 == 0 {
+        v /= 5;
+        count += 1;
+    }
+    count
+}
+
+fn multiple_of_pow5(v: u64, p: u32) -> bool {
+    pow5_factor(v) >= p
+}
+
+fn multiple_of_pow2(v: u64, p: u32) -> bool {
+    v & ((1 << p) - 1) == 0
+}
+
+/// `(m * mul) >> j`, where `mul` is a 128-bit `(low, high)` and `j` is more
+/// than 64.
+fn mul_shift(m: u64, mul: (u64, u64), j: i32) -> u64 {
+    let (_, high0) = mul_128(m, mul.0);
+    let (low1, mut high1) = mul_128(m, mul.1);
+    let sum = high0.wrapping_add(low1);
+    if sum < high0 { high1 += 1; }
+    let dist = (j - 64) as u32;
+    (high1 << (64 - dist)) | (sum >> dist)
+}
+
+/// Returns the shortest decimal `m * 10^e` in the interval of numbers which
+/// round to the finite, nonzero `f64` of the given fields. Of several such
+/// decimals, the one closest to the `f64` is chosen.
+fn shortest(ieee_m: u64, ieee_e: u32) -> (u64, i32) {
+    // The bounds of the interval are halfway to the neighbouring `f64`s,
+    // which is where the 2 extra bits go.
+    let (m2, e2) = if ieee_e == 0 {
+        (ieee_m, 1 - BIAS - MANTISSA_BITS as i32 - 2)
+    } else {
+        (ieee_m | 1 << MANTISSA_BITS, ieee_e as i32 - BIAS - MANTISSA_BITS as i32 - 2)
+    };
+    let accept_bounds = m2 & 1 == 0;
+    let mv = 4 * m2;
+    // The lower neighbour is closer at powers of two.
+    let mm_shift = (ieee_m != 0 || ieee_e <= 1) as u64;
+
+    // Scales the interval `[mv - 1 - mm_shift, mv + 2]` to base ten, keeping
+    // track of whether the scaled values dropped only zeros.
+    let mut vr;
+    let mut vp;
+    let mut vm;
+    let e10;
+    let mut vm_trailing_zeros = false;
+    let mut vr_trailing_zeros = false;
+    if e2 >= 0 {
+        let q = log10_pow2(e2) - (e2 > 3) as u32;
+        e10 = q as i32;
+        let k = POW5_BITS + pow5_bits(q as i32) - 1;
+        let i = -e2 + q as i32 + k;
+        let mul = POW5_INV_SPLIT[q as usize];
+        vr = mul_shift(mv, mul, i);
+        vp = mul_shift(mv + 2, mul, i);
+        vm = mul_shift(mv - 1 - mm_shift, mul, i);
+        if q <= 21 {
+            // At most one of the three can be a multiple of 5.
+            if mv % 5 == 0 {
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            } else if accept_bounds {
+                vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            } else {
+                vp -= multiple_of_pow5(mv + 2, q) as u64;
+            }
+        }
+    } else {
+        let q = log10_pow5(-e2) - (-e2 > 1) as u32;
+        e10 = q as i32 + e2;
+        let i = -e2 - q as i32;
+        let k = pow5_bits(i) - POW5_BITS;
+        let j = q as i32 - k;
+        let mul = POW5_SPLIT[i as usize];
+        vr = mul_shift(mv, mul, j);
+        vp = mul_shift(mv + 2, mul, j);
+        vm = mul_shift(mv - 1 - mm_shift, mul, j);
+        if q <= 1 {
+            // `mv` has at least two trailing zero bits, `mv + 2` one, and
+            // `mv - 1 - mm_shift` one if `mm_shift` is.
+            vr_trailing_zeros = true;
+            if accept_bounds {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp -= 1;
+            }
+        } else if q < 63 {
+            vr_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    // Drops digits while the interval still holds a number with fewer.
+    let mut removed = 0;
+    let mut last_removed = 0;
+    let m = if vm_trailing_zeros || vr_trailing_zeros {
+        // The bounds or the value may be exact, which takes more care.
+        while vp / 10 > vm / 10 {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed += 1;
+        }
+        if vm_trailing_zeros {
+            while vm % 10 == 0 {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed += 1;
+            }
+        }
+        if vr_trailing_zeros && last_removed == 5 && vr % 2 == 0 {
+            // Exactly halfway: round to even.
+            last_removed = 4;
+        }
+        let outside = vr == vm && (!accept_bounds || !vm_trailing_zeros);
+        vr + (outside || last_removed >= 5) as u64
+    } else {
+        let mut round_up = false;
+        if vp / 100 > vm / 100 {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while vp / 10 > vm / 10 {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed += 1;
+        }
+        vr + (vr == vm || round_up) as u64
+    };
+    (m, e10 + removed)
+}
+
+#[cfg(test)]
+mod tests {
+    extern crate test;
+    use self::test::Bencher;
+    use super::{parse, format};
+    use std::f64;
+    use std::mem;
+
+    fn roundtrip(v: f64) {
+        let s = format(v).to_string();
+        let back = parse(s.as_bytes());
+        assert!(unsafe { mem::transmute::<f64, u64>(back) == mem::transmute::<f64, u64>(v) },
+                "{:?} formatted as {} parses back as {:?}", v, s, back);
+    }
+
+    #[test]
+    fn test_parse() {
+        let p = |s: &str| parse(s.as_bytes());
+        assert_eq!(p("0"), 0.0);
+        assert_eq!(p("-0.0e10"), 0.0);
+        assert_eq!(p("1"), 1.0);
+        assert_eq!(p("-1.5"), -1.5);
+        assert_eq!(p("0.1"), 0.1);
+        assert_eq!(p("3.1415926535897932384626"), 3.141592653589793);
+        assert_eq!(p("0.30000000000000004"), 0.1 + 0.2);
+        assert_eq!(p("1e23"), 1e23);
+        assert_eq!(p("8.988465674311579e307"), 8.988465674311579e307);
+        assert_eq!(p("1.7976931348623157e308"), f64::MAX);
+        assert_eq!(p("1.7976931348623159e308"), f64::INFINITY);
+        assert_eq!(p("1e400"), f64::INFINITY);
+        assert_eq!(p("2.2250738585072014e-308"), f64::MIN_POSITIVE);
+        assert_eq!(p("4.9406564584124654e-324"), 5e-324);
+        assert_eq!(p("2.4703282292062327e-324"), 0.0);
+        assert_eq!(p("2.4703282292062328e-324"), 5e-324);
+        assert_eq!(p("1e-400"), 0.0);
+        assert_eq!(p("123456789012345678901234567890"), 1.2345678901234568e29);
+        assert_eq!(p("0.000000000000000000000000000001e30"), 1.0);
+        assert_eq!(p("1e99999999999999999999"), f64::INFINITY);
+        assert_eq!(p("1e-99999999999999999999"), 0.0);
+    }
+
+    #[test]
+    fn test_parse_halfway() {
+        let p = |s: &str| parse(s.as_bytes());
+        // 2^53 + 1 lies halfway between two doubles and rounds to even.
+        assert_eq!(p("9007199254740993"), 9007199254740992.0);
+        assert_eq!(p("9007199254740993.0000000000000000000000001"), 9007199254740994.0);
+        assert_eq!(p("9007199254740995"), 9007199254740996.0);
+        // Either side of halfway between the largest subnormal and the least
+        // normal double.
+        assert_eq!(p("2.2250738585072011e-308"), 2.225073858507201e-308);
+        assert_eq!(p("2.2250738585072012e-308"), f64::MIN_POSITIVE);
+        let mut s = "1".to_string();
+        for _ in 0..999 { s.push('0'); }
+        s.push_str("1e-1000");
+        assert_eq!(p(&s[..]), 1.0);
+    }
+
+    #[test]
+    fn test_format() {
+        let f = |v: f64| format(v).to_string();
+        assert_eq!(f(0.0), "0.0");
+        assert_eq!(f(-0.0), "-0.0");
+        assert_eq!(f(1.0), "1.0");
+        assert_eq!(f(-1.5), "-1.5");
+        assert_eq!(f(0.1), "0.1");
+        assert_eq!(f(0.1 + 0.2), "0.30000000000000004");
+        assert_eq!(f(100.0), "100.0");
+        assert_eq!(f(123456.789), "123456.789");
+        assert_eq!(f(1e20), "100000000000000000000.0");
+        assert_eq!(f(1e21), "1e21");
+        assert_eq!(f(0.000001), "0.000001");
+        assert_eq!(f(0.0000012), "0.0000012");
+        assert_eq!(f(1e-7), "1e-7");
+        assert_eq!(f(f64::MAX), "1.7976931348623157e308");
+        assert_eq!(f(f64::MIN_POSITIVE), "2.2250738585072014e-308");
+        assert_eq!(f(5e-324), "5e-324");
+        assert_eq!(f(f64::NAN), "null");
+        assert_eq!(f(f64::INFINITY), "null");
+        assert_eq!(f(f64::NEG_INFINITY), "null");
+    }
+
+    #[test]
+    fn test_roundtrip() {
+        for &v in &[0.1, 1.0 / 3.0, 2.0 / 3.0, 1e23, 5e-324, 1e-323, f64::MAX,
+                    f64::MIN_POSITIVE, 9007199254740993.0, 4.35, 0.1 + 0.7] {
+            roundtrip(v);
+            roundtrip(-v);
+        }
+        // Every exponent, with mantissas from a xorshift generator.
+        let mut x = 0x2545f4914f6cdd1du64;
+        for _ in 0..100000 {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            let v: f64 = unsafe { mem::transmute(x & !(1 << 63)) };
+            if v.is_finite() {
+                roundtrip(v);
+            }
+        }
+    }
+
+    fn numbers() -> Vec<String> {
+        let mut x = 0x9e3779b97f4a7c15u64;
+        (0..1000).map(|i| {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            match i % 3 {
+                0 => format!("{}.{}", x % 1000, x % 1000000),
+                1 => format!("{}", (x >> 11) as f64 / (1u64 << 53) as f64),
+                _ => format!("{}e{}", x % 100000, (x % 40) as i32 - 20),
+            }
+        }).collect()
+    }
+
+    #[bench]
+    fn bench_parse(b: &mut Bencher) {
+        let numbers = numbers();
+        b.iter(|| {
+            numbers.iter().map(|s| parse(s.as_bytes())).fold(0.0, |a, v| a + v)
+        });
+    }
+
+    #[bench]
+    fn bench_parse_std(b: &mut Bencher) {
+        let numbers = numbers();
+        b.iter(|| {
+            numbers.iter().map(|s| s.parse::<f64>().unwrap()).fold(0.0, |a, v| a + v)
+        });
+    }
+
+    #[bench]
+    fn bench_format(b: &mut Bencher) {
+        let numbers: Vec<f64> = numbers().iter().map(|s| parse(s.as_bytes())).collect();
+        b.iter(|| {
+            numbers.iter().map(|&v| format(v).as_str().len()).fold(0, |a, n| a + n)
+        });
+    }
+
+    #[bench]
+    fn bench_format_std(b: &mut Bencher) {
+        let numbers: Vec<f64> = numbers().iter().map(|s| parse(s.as_bytes())).collect();
+        b.iter(|| {
+            numbers.iter().map(|&v| v.to_string().len()).fold(0, |a, n| a + n)
+        });
+    }
+}
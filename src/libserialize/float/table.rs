@@ -0,0 +1,1352 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// NOTE: The following code was generated by "src/etc/float_tables.py", do not edit directly
+
+/// The least power of ten in `POW5_128`.
+pub const POW5_128_MIN: i64 = -342;
+/// The greatest power of ten in `POW5_128`.
+pub const POW5_128_MAX: i64 = 308;
+
+/// `5^q` for `q` in `POW5_128_MIN...POW5_128_MAX`, normalized to 128 bits
+/// as `(high, low)`. Positive powers are truncated; negative ones are
+/// reciprocals rounded up.
+pub static POW5_128: [(u64, u64); 651] = [
+    (0xeef453d6923bd65a, 0x113faa2906a13b3f),
+    (0x9558b4661b6565f8, 0x4ac7ca59a424c507),
+    (0xbaaee17fa23ebf76, 0x5d79bcf00d2df649),
+    (0xe95a99df8ace6f53, 0xf4d82c2c107973dc),
+    (0x91d8a02bb6c10594, 0x79071b9b8a4be869),
+    (0xb64ec836a47146f9, 0x9748e2826cdee284),
+    (0xe3e27a444d8d98b7, 0xfd1b1b2308169b25),
+    (0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7),
+    (0xb208ef855c969f4f, 0xbdbd2d335e51a935),
+    (0xde8b2b66b3bc4723, 0xad2c788035e61382),
+    (0x8b16fb203055ac76, 0x4c3bcb5021afcc31),
+    (0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d),
+    (0xd953e8624b85dd78, 0xd71d6dad34a2af0d),
+    (0x87d4713d6f33aa6b, 0x8672648c40e5ad68),
+    (0xa9c98d8ccb009506, 0x680efdaf511f18c2),
+    (0xd43bf0effdc0ba48, 0x0212bd1b2566def2),
+    (0x84a57695fe98746d, 0x014bb630f7604b57),
+    (0xa5ced43b7e3e9188, 0x419ea3bd35385e2d),
+    (0xcf42894a5dce35ea, 0x52064cac828675b9),
+    (0x818995ce7aa0e1b2, 0x7343efebd1940993),
+    (0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8),
+    (0xca66fa129f9b60a6, 0xd41a26e077774ef6),
+    (0xfd00b897478238d0, 0x8920b098955522b4),
+    (0x9e20735e8cb16382, 0x55b46e5f5d5535b0),
+    (0xc5a890362fddbc62, 0xeb2189f734aa831d),
+    (0xf712b443bbd52b7b, 0xa5e9ec7501d523e4),
+    (0x9a6bb0aa55653b2d, 0x47b233c92125366e),
+    (0xc1069cd4eabe89f8, 0x999ec0bb696e840a),
+    (0xf148440a256e2c76, 0xc00670ea43ca250d),
+    (0x96cd2a865764dbca, 0x380406926a5e5728),
+    (0xbc807527ed3e12bc, 0xc605083704f5ecf2),
+    (0xeba09271e88d976b, 0xf7864a44c633682e),
+    (0x93445b8731587ea3, 0x7ab3ee6afbe0211d),
+    (0xb8157268fdae9e4c, 0x5960ea05bad82964),
+    (0xe61acf033d1a45df, 0x6fb92487298e33bd),
+    (0x8fd0c16206306bab, 0xa5d3b6d479f8e056),
+    (0xb3c4f1ba87bc8696, 0x8f48a4899877186c),
+    (0xe0b62e2929aba83c, 0x331acdabfe94de87),
+    (0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14),
+    (0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9),
+    (0xdb71e91432b1a24a, 0xc9e82cd9f69d6150),
+    (0x892731ac9faf056e, 0xbe311c083a225cd2),
+    (0xab70fe17c79ac6ca, 0x6dbd630a48aaf406),
+    (0xd64d3d9db981787d, 0x092cbbccdad5b108),
+    (0x85f0468293f0eb4e, 0x25bbf56008c58ea5),
+    (0xa76c582338ed2621, 0xaf2af2b80af6f24e),
+    (0xd1476e2c07286faa, 0x1af5af660db4aee1),
+    (0x82cca4db847945ca, 0x50d98d9fc890ed4d),
+    (0xa37fce126597973c, 0xe50ff107bab528a0),
+    (0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8),
+    (0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a),
+    (0x9faacf3df73609b1, 0x77b191618c54e9ac),
+    (0xc795830d75038c1d, 0xd59df5b9ef6a2417),
+    (0xf97ae3d0d2446f25, 0x4b0573286b44ad1d),
+    (0x9becce62836ac577, 0x4ee367f9430aec32),
+    (0xc2e801fb244576d5, 0x229c41f793cda73f),
+    (0xf3a20279ed56d48a, 0x6b43527578c1110f),
+    (0x9845418c345644d6, 0x830a13896b78aaa9),
+    (0xbe5691ef416bd60c, 0x23cc986bc656d553),
+    (0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8),
+    (0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9),
+    (0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53),
+    (0xe858ad248f5c22c9, 0xd1b3400f8f9cff68),
+    (0x91376c36d99995be, 0x23100809b9c21fa1),
+    (0xb58547448ffffb2d, 0xabd40a0c2832a78a),
+    (0xe2e69915b3fff9f9, 0x16c90c8f323f516c),
+    (0x8dd01fad907ffc3b, 0xae3da7d97f6792e3),
+    (0xb1442798f49ffb4a, 0x99cd11cfdf41779c),
+    (0xdd95317f31c7fa1d, 0x40405643d711d583),
+    (0x8a7d3eef7f1cfc52, 0x482835ea666b2572),
+    (0xad1c8eab5ee43b66, 0xda3243650005eecf),
+    (0xd863b256369d4a40, 0x90bed43e40076a82),
+    (0x873e4f75e2224e68, 0x5a7744a6e804a291),
+    (0xa90de3535aaae202, 0x711515d0a205cb36),
+    (0xd3515c2831559a83, 0x0d5a5b44ca873e03),
+    (0x8412d9991ed58091, 0xe858790afe9486c2),
+    (0xa5178fff668ae0b6, 0x626e974dbe39a872),
+    (0xce5d73ff402d98e3, 0xfb0a3d212dc8128f),
+    (0x80fa687f881c7f8e, 0x7ce66634bc9d0b99),
+    (0xa139029f6a239f72, 0x1c1fffc1ebc44e80),
+    (0xc987434744ac874e, 0xa327ffb266b56220),
+    (0xfbe9141915d7a922, 0x4bf1ff9f0062baa8),
+    (0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9),
+    (0xc4ce17b399107c22, 0xcb550fb4384d21d3),
+    (0xf6019da07f549b2b, 0x7e2a53a146606a48),
+    (0x99c102844f94e0fb, 0x2eda7444cbfc426d),
+    (0xc0314325637a1939, 0xfa911155fefb5308),
+    (0xf03d93eebc589f88, 0x793555ab7eba27ca),
+    (0x96267c7535b763b5, 0x4bc1558b2f3458de),
+    (0xbbb01b9283253ca2, 0x9eb1aaedfb016f16),
+    (0xea9c227723ee8bcb, 0x465e15a979c1cadc),
+    (0x92a1958a7675175f, 0x0bfacd89ec191ec9),
+    (0xb749faed14125d36, 0xcef980ec671f667b),
+    (0xe51c79a85916f484, 0x82b7e12780e7401a),
+    (0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810),
+    (0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15),
+    (0xdfbdcece67006ac9, 0x67a791e093e1d49a),
+    (0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0),
+    (0xaecc49914078536d, 0x58fae9f773886e18),
+    (0xda7f5bf590966848, 0xaf39a475506a899e),
+    (0x888f99797a5e012d, 0x6d8406c952429603),
+    (0xaab37fd7d8f58178, 0xc8e5087ba6d33b83),
+    (0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64),
+    (0x855c3be0a17fcd26, 0x5cf2eea09a55067f),
+    (0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e),
+    (0xd0601d8efc57b08b, 0xf13b94daf124da26),
+    (0x823c12795db6ce57, 0x76c53d08d6b70858),
+    (0xa2cb1717b52481ed, 0x54768c4b0c64ca6e),
+    (0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09),
+    (0xfe5d54150b090b02, 0xd3f93b35435d7c4c),
+    (0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf),
+    (0xc6b8e9b0709f109a, 0x359ab6419ca1091b),
+    (0xf867241c8cc6d4c0, 0xc30163d203c94b62),
+    (0x9b407691d7fc44f8, 0x79e0de63425dcf1d),
+    (0xc21094364dfb5636, 0x985915fc12f542e4),
+    (0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d),
+    (0x979cf3ca6cec5b5a, 0xa705992ceecf9c42),
+    (0xbd8430bd08277231, 0x50c6ff782a838353),
+    (0xece53cec4a314ebd, 0xa4f8bf5635246428),
+    (0x940f4613ae5ed136, 0x871b7795e136be99),
+    (0xb913179899f68584, 0x28e2557b59846e3f),
+    (0xe757dd7ec07426e5, 0x331aeada2fe589cf),
+    (0x9096ea6f3848984f, 0x3ff0d2c85def7621),
+    (0xb4bca50b065abe63, 0x0fed077a756b53a9),
+    (0xe1ebce4dc7f16dfb, 0xd3e8495912c62894),
+    (0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c),
+    (0xb080392cc4349dec, 0xbd8d794d96aacfb3),
+    (0xdca04777f541c567, 0xecf0d7a0fc5583a0),
+    (0x89e42caaf9491b60, 0xf41686c49db57244),
+    (0xac5d37d5b79b6239, 0x311c2875c522ced5),
+    (0xd77485cb25823ac7, 0x7d633293366b828b),
+    (0x86a8d39ef77164bc, 0xae5dff9c02033197),
+    (0xa8530886b54dbdeb, 0xd9f57f830283fdfc),
+    (0xd267caa862a12d66, 0xd072df63c324fd7b),
+    (0x8380dea93da4bc60, 0x4247cb9e59f71e6d),
+    (0xa46116538d0deb78, 0x52d9be85f074e608),
+    (0xcd795be870516656, 0x67902e276c921f8b),
+    (0x806bd9714632dff6, 0x00ba1cd8a3db53b6),
+    (0xa086cfcd97bf97f3, 0x80e8a40eccd228a4),
+    (0xc8a883c0fdaf7df0, 0x6122cd128006b2cd),
+    (0xfad2a4b13d1b5d6c, 0x796b805720085f81),
+    (0x9cc3a6eec6311a63, 0xcbe3303674053bb0),
+    (0xc3f490aa77bd60fc, 0xbedbfc4411068a9c),
+    (0xf4f1b4d515acb93b, 0xee92fb5515482d44),
+    (0x991711052d8bf3c5, 0x751bdd152d4d1c4a),
+    (0xbf5cd54678eef0b6, 0xd262d45a78a0635d),
+    (0xef340a98172aace4, 0x86fb897116c87c34),
+    (0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0),
+    (0xbae0a846d2195712, 0x8974836059cca109),
+    (0xe998d258869facd7, 0x2bd1a438703fc94b),
+    (0x91ff83775423cc06, 0x7b6306a34627ddcf),
+    (0xb67f6455292cbf08, 0x1a3bc84c17b1d542),
+    (0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93),
+    (0x8e938662882af53e, 0x547eb47b7282ee9c),
+    (0xb23867fb2a35b28d, 0xe99e619a4f23aa43),
+    (0xdec681f9f4c31f31, 0x6405fa00e2ec94d4),
+    (0x8b3c113c38f9f37e, 0xde83bc408dd3dd04),
+    (0xae0b158b4738705e, 0x9624ab50b148d445),
+    (0xd98ddaee19068c76, 0x3badd624dd9b0957),
+    (0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6),
+    (0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c),
+    (0xd47487cc8470652b, 0x7647c3200069671f),
+    (0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073),
+    (0xa5fb0a17c777cf09, 0xf468107100525890),
+    (0xcf79cc9db955c2cc, 0x7182148d4066eeb4),
+    (0x81ac1fe293d599bf, 0xc6f14cd848405530),
+    (0xa21727db38cb002f, 0xb8ada00e5a506a7c),
+    (0xca9cf1d206fdc03b, 0xa6d90811f0e4851c),
+    (0xfd442e4688bd304a, 0x908f4a166d1da663),
+    (0x9e4a9cec15763e2e, 0x9a598e4e043287fe),
+    (0xc5dd44271ad3cdba, 0x40eff1e1853f29fd),
+    (0xf7549530e188c128, 0xd12bee59e68ef47c),
+    (0x9a94dd3e8cf578b9, 0x82bb74f8301958ce),
+    (0xc13a148e3032d6e7, 0xe36a52363c1faf01),
+    (0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1),
+    (0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9),
+    (0xbcb2b812db11a5de, 0x7415d448f6b6f0e7),
+    (0xebdf661791d60f56, 0x111b495b3464ad21),
+    (0x936b9fcebb25c995, 0xcab10dd900beec34),
+    (0xb84687c269ef3bfb, 0x3d5d514f40eea742),
+    (0xe65829b3046b0afa, 0x0cb4a5a3112a5112),
+    (0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab),
+    (0xb3f4e093db73a093, 0x59ed216765690f56),
+    (0xe0f218b8d25088b8, 0x306869c13ec3532c),
+    (0x8c974f7383725573, 0x1e414218c73a13fb),
+    (0xafbd2350644eeacf, 0xe5d1929ef90898fa),
+    (0xdbac6c247d62a583, 0xdf45f746b74abf39),
+    (0x894bc396ce5da772, 0x6b8bba8c328eb783),
+    (0xab9eb47c81f5114f, 0x066ea92f3f326564),
+    (0xd686619ba27255a2, 0xc80a537b0efefebd),
+    (0x8613fd0145877585, 0xbd06742ce95f5f36),
+    (0xa798fc4196e952e7, 0x2c48113823b73704),
+    (0xd17f3b51fca3a7a0, 0xf75a15862ca504c5),
+    (0x82ef85133de648c4, 0x9a984d73dbe722fb),
+    (0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba),
+    (0xcc963fee10b7d1b3, 0x318df905079926a8),
+    (0xffbbcfe994e5c61f, 0xfdf17746497f7052),
+    (0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633),
+    (0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0),
+    (0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0),
+    (0x9c1661a651213e2d, 0x06bea10ca65c084e),
+    (0xc31bfa0fe5698db8, 0x486e494fcff30a62),
+    (0xf3e2f893dec3f126, 0x5a89dba3c3efccfa),
+    (0x986ddb5c6b3a76b7, 0xf89629465a75e01c),
+    (0xbe89523386091465, 0xf6bbb397f1135823),
+    (0xee2ba6c0678b597f, 0x746aa07ded582e2c),
+    (0x94db483840b717ef, 0xa8c2a44eb4571cdc),
+    (0xba121a4650e4ddeb, 0x92f34d62616ce413),
+    (0xe896a0d7e51e1566, 0x77b020baf9c81d17),
+    (0x915e2486ef32cd60, 0x0ace1474dc1d122e),
+    (0xb5b5ada8aaff80b8, 0x0d819992132456ba),
+    (0xe3231912d5bf60e6, 0x10e1fff697ed6c69),
+    (0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1),
+    (0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2),
+    (0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde),
+    (0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b),
+    (0xad4ab7112eb3929d, 0x86c16c98d2c953c6),
+    (0xd89d64d57a607744, 0xe871c7bf077ba8b7),
+    (0x87625f056c7c4a8b, 0x11471cd764ad4972),
+    (0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf),
+    (0xd389b47879823479, 0x4aff1d108d4ec2c3),
+    (0x843610cb4bf160cb, 0xcedf722a585139ba),
+    (0xa54394fe1eedb8fe, 0xc2974eb4ee658828),
+    (0xce947a3da6a9273e, 0x733d226229feea32),
+    (0x811ccc668829b887, 0x0806357d5a3f525f),
+    (0xa163ff802a3426a8, 0xca07c2dcb0cf26f7),
+    (0xc9bcff6034c13052, 0xfc89b393dd02f0b5),
+    (0xfc2c3f3841f17c67, 0xbbac2078d443ace2),
+    (0x9d9ba7832936edc0, 0xd54b944b84aa4c0d),
+    (0xc5029163f384a931, 0x0a9e795e65d4df11),
+    (0xf64335bcf065d37d, 0x4d4617b5ff4a16d5),
+    (0x99ea0196163fa42e, 0x504bced1bf8e4e45),
+    (0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6),
+    (0xf07da27a82c37088, 0x5d767327bb4e5a4c),
+    (0x964e858c91ba2655, 0x3a6a07f8d510f86f),
+    (0xbbe226efb628afea, 0x890489f70a55368b),
+    (0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e),
+    (0x92c8ae6b464fc96f, 0x3b0b8bc90012929d),
+    (0xb77ada0617e3bbcb, 0x09ce6ebb40173744),
+    (0xe55990879ddcaabd, 0xcc420a6a101d0515),
+    (0x8f57fa54c2a9eab6, 0x9fa946824a12232d),
+    (0xb32df8e9f3546564, 0x47939822dc96abf9),
+    (0xdff9772470297ebd, 0x59787e2b93bc56f7),
+    (0x8bfbea76c619ef36, 0x57eb4edb3c55b65a),
+    (0xaefae51477a06b03, 0xede622920b6b23f1),
+    (0xdab99e59958885c4, 0xe95fab368e45eced),
+    (0x88b402f7fd75539b, 0x11dbcb0218ebb414),
+    (0xaae103b5fcd2a881, 0xd652bdc29f26a119),
+    (0xd59944a37c0752a2, 0x4be76d3346f0495f),
+    (0x857fcae62d8493a5, 0x6f70a4400c562ddb),
+    (0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952),
+    (0xd097ad07a71f26b2, 0x7e2000a41346a7a7),
+    (0x825ecc24c873782f, 0x8ed400668c0c28c8),
+    (0xa2f67f2dfa90563b, 0x728900802f0f32fa),
+    (0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9),
+    (0xfea126b7d78186bc, 0xe2f610c84987bfa8),
+    (0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9),
+    (0xc6ede63fa05d3143, 0x91503d1c79720dbb),
+    (0xf8a95fcf88747d94, 0x75a44c6397ce912a),
+    (0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba),
+    (0xc24452da229b021b, 0xfbe85badce996168),
+    (0xf2d56790ab41c2a2, 0xfae27299423fb9c3),
+    (0x97c560ba6b0919a5, 0xdccd879fc967d41a),
+    (0xbdb6b8e905cb600f, 0x5400e987bbc1c920),
+    (0xed246723473e3813, 0x290123e9aab23b68),
+    (0x9436c0760c86e30b, 0xf9a0b6720aaf6521),
+    (0xb94470938fa89bce, 0xf808e40e8d5b3e69),
+    (0xe7958cb87392c2c2, 0xb60b1d1230b20e04),
+    (0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2),
+    (0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3),
+    (0xe2280b6c20dd5232, 0x25c6da63c38de1b0),
+    (0x8d590723948a535f, 0x579c487e5a38ad0e),
+    (0xb0af48ec79ace837, 0x2d835a9df0c6d851),
+    (0xdcdb1b2798182244, 0xf8e431456cf88e65),
+    (0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff),
+    (0xac8b2d36eed2dac5, 0xe272467e3d222f3f),
+    (0xd7adf884aa879177, 0x5b0ed81dcc6abb0f),
+    (0x86ccbb52ea94baea, 0x98e947129fc2b4e9),
+    (0xa87fea27a539e9a5, 0x3f2398d747b36224),
+    (0xd29fe4b18e88640e, 0x8eec7f0d19a03aad),
+    (0x83a3eeeef9153e89, 0x1953cf68300424ac),
+    (0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7),
+    (0xcdb02555653131b6, 0x3792f412cb06794d),
+    (0x808e17555f3ebf11, 0xe2bbd88bbee40bd0),
+    (0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4),
+    (0xc8de047564d20a8b, 0xf245825a5a445275),
+    (0xfb158592be068d2e, 0xeed6e2f0f0d56712),
+    (0x9ced737bb6c4183d, 0x55464dd69685606b),
+    (0xc428d05aa4751e4c, 0xaa97e14c3c26b886),
+    (0xf53304714d9265df, 0xd53dd99f4b3066a8),
+    (0x993fe2c6d07b7fab, 0xe546a8038efe4029),
+    (0xbf8fdb78849a5f96, 0xde98520472bdd033),
+    (0xef73d256a5c0f77c, 0x963e66858f6d4440),
+    (0x95a8637627989aad, 0xdde7001379a44aa8),
+    (0xbb127c53b17ec159, 0x5560c018580d5d52),
+    (0xe9d71b689dde71af, 0xaab8f01e6e10b4a6),
+    (0x9226712162ab070d, 0xcab3961304ca70e8),
+    (0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22),
+    (0xe45c10c42a2b3b05, 0x8cb89a7db77c506a),
+    (0x8eb98a7a9a5b04e3, 0x77f3608e92adb242),
+    (0xb267ed1940f1c61c, 0x55f038b237591ed3),
+    (0xdf01e85f912e37a3, 0x6b6c46dec52f6688),
+    (0x8b61313bbabce2c6, 0x2323ac4b3b3da015),
+    (0xae397d8aa96c1b77, 0xabec975e0a0d081a),
+    (0xd9c7dced53c72255, 0x96e7bd358c904a21),
+    (0x881cea14545c7575, 0x7e50d64177da2e54),
+    (0xaa242499697392d2, 0xdde50bd1d5d0b9e9),
+    (0xd4ad2dbfc3d07787, 0x955e4ec64b44e864),
+    (0x84ec3c97da624ab4, 0xbd5af13bef0b113e),
+    (0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e),
+    (0xcfb11ead453994ba, 0x67de18eda5814af2),
+    (0x81ceb32c4b43fcf4, 0x80eacf948770ced7),
+    (0xa2425ff75e14fc31, 0xa1258379a94d028d),
+    (0xcad2f7f5359a3b3e, 0x096ee45813a04330),
+    (0xfd87b5f28300ca0d, 0x8bca9d6e188853fc),
+    (0x9e74d1b791e07e48, 0x775ea264cf55347e),
+    (0xc612062576589dda, 0x95364afe032a819e),
+    (0xf79687aed3eec551, 0x3a83ddbd83f52205),
+    (0x9abe14cd44753b52, 0xc4926a9672793543),
+    (0xc16d9a0095928a27, 0x75b7053c0f178294),
+    (0xf1c90080baf72cb1, 0x5324c68b12dd6339),
+    (0x971da05074da7bee, 0xd3f6fc16ebca5e04),
+    (0xbce5086492111aea, 0x88f4bb1ca6bcf585),
+    (0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6),
+    (0x9392ee8e921d5d07, 0x3aff322e62439fd0),
+    (0xb877aa3236a4b449, 0x09befeb9fad487c3),
+    (0xe69594bec44de15b, 0x4c2ebe687989a9b4),
+    (0x901d7cf73ab0acd9, 0x0f9d37014bf60a11),
+    (0xb424dc35095cd80f, 0x538484c19ef38c95),
+    (0xe12e13424bb40e13, 0x2865a5f206b06fba),
+    (0x8cbccc096f5088cb, 0xf93f87b7442e45d4),
+    (0xafebff0bcb24aafe, 0xf78f69a51539d749),
+    (0xdbe6fecebdedd5be, 0xb573440e5a884d1c),
+    (0x89705f4136b4a597, 0x31680a88f8953031),
+    (0xabcc77118461cefc, 0xfdc20d2b36ba7c3e),
+    (0xd6bf94d5e57a42bc, 0x3d32907604691b4d),
+    (0x8637bd05af6c69b5, 0xa63f9a49c2c1b110),
+    (0xa7c5ac471b478423, 0x0fcf80dc33721d54),
+    (0xd1b71758e219652b, 0xd3c36113404ea4a9),
+    (0x83126e978d4fdf3b, 0x645a1cac083126ea),
+    (0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4),
+    (0xcccccccccccccccc, 0xcccccccccccccccd),
+    (0x8000000000000000, 0x0000000000000000),
+    (0xa000000000000000, 0x0000000000000000),
+    (0xc800000000000000, 0x0000000000000000),
+    (0xfa00000000000000, 0x0000000000000000),
+    (0x9c40000000000000, 0x0000000000000000),
+    (0xc350000000000000, 0x0000000000000000),
+    (0xf424000000000000, 0x0000000000000000),
+    (0x9896800000000000, 0x0000000000000000),
+    (0xbebc200000000000, 0x0000000000000000),
+    (0xee6b280000000000, 0x0000000000000000),
+    (0x9502f90000000000, 0x0000000000000000),
+    (0xba43b74000000000, 0x0000000000000000),
+    (0xe8d4a51000000000, 0x0000000000000000),
+    (0x9184e72a00000000, 0x0000000000000000),
+    (0xb5e620f480000000, 0x0000000000000000),
+    (0xe35fa931a0000000, 0x0000000000000000),
+    (0x8e1bc9bf04000000, 0x0000000000000000),
+    (0xb1a2bc2ec5000000, 0x0000000000000000),
+    (0xde0b6b3a76400000, 0x0000000000000000),
+    (0x8ac7230489e80000, 0x0000000000000000),
+    (0xad78ebc5ac620000, 0x0000000000000000),
+    (0xd8d726b7177a8000, 0x0000000000000000),
+    (0x878678326eac9000, 0x0000000000000000),
+    (0xa968163f0a57b400, 0x0000000000000000),
+    (0xd3c21bcecceda100, 0x0000000000000000),
+    (0x84595161401484a0, 0x0000000000000000),
+    (0xa56fa5b99019a5c8, 0x0000000000000000),
+    (0xcecb8f27f4200f3a, 0x0000000000000000),
+    (0x813f3978f8940984, 0x4000000000000000),
+    (0xa18f07d736b90be5, 0x5000000000000000),
+    (0xc9f2c9cd04674ede, 0xa400000000000000),
+    (0xfc6f7c4045812296, 0x4d00000000000000),
+    (0x9dc5ada82b70b59d, 0xf020000000000000),
+    (0xc5371912364ce305, 0x6c28000000000000),
+    (0xf684df56c3e01bc6, 0xc732000000000000),
+    (0x9a130b963a6c115c, 0x3c7f400000000000),
+    (0xc097ce7bc90715b3, 0x4b9f100000000000),
+    (0xf0bdc21abb48db20, 0x1e86d40000000000),
+    (0x96769950b50d88f4, 0x1314448000000000),
+    (0xbc143fa4e250eb31, 0x17d955a000000000),
+    (0xeb194f8e1ae525fd, 0x5dcfab0800000000),
+    (0x92efd1b8d0cf37be, 0x5aa1cae500000000),
+    (0xb7abc627050305ad, 0xf14a3d9e40000000),
+    (0xe596b7b0c643c719, 0x6d9ccd05d0000000),
+    (0x8f7e32ce7bea5c6f, 0xe4820023a2000000),
+    (0xb35dbf821ae4f38b, 0xdda2802c8a800000),
+    (0xe0352f62a19e306e, 0xd50b2037ad200000),
+    (0x8c213d9da502de45, 0x4526f422cc340000),
+    (0xaf298d050e4395d6, 0x9670b12b7f410000),
+    (0xdaf3f04651d47b4c, 0x3c0cdd765f114000),
+    (0x88d8762bf324cd0f, 0xa5880a69fb6ac800),
+    (0xab0e93b6efee0053, 0x8eea0d047a457a00),
+    (0xd5d238a4abe98068, 0x72a4904598d6d880),
+    (0x85a36366eb71f041, 0x47a6da2b7f864750),
+    (0xa70c3c40a64e6c51, 0x999090b65f67d924),
+    (0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d),
+    (0x82818f1281ed449f, 0xbff8f10e7a8921a4),
+    (0xa321f2d7226895c7, 0xaff72d52192b6a0d),
+    (0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490),
+    (0xfee50b7025c36a08, 0x02f236d04753d5b4),
+    (0x9f4f2726179a2245, 0x01d762422c946590),
+    (0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5),
+    (0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2),
+    (0x9b934c3b330c8577, 0x63cc55f49f88eb2f),
+    (0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb),
+    (0xf316271c7fc3908a, 0x8bef464e3945ef7a),
+    (0x97edd871cfda3a56, 0x97758bf0e3cbb5ac),
+    (0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317),
+    (0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd),
+    (0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a),
+    (0xb975d6b6ee39e436, 0xb3e2fd538e122b44),
+    (0xe7d34c64a9c85d44, 0x60dbbca87196b616),
+    (0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd),
+    (0xb51d13aea4a488dd, 0x6babab6398bdbe41),
+    (0xe264589a4dcdab14, 0xc696963c7eed2dd1),
+    (0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2),
+    (0xb0de65388cc8ada8, 0x3b25a55f43294bcb),
+    (0xdd15fe86affad912, 0x49ef0eb713f39ebe),
+    (0x8a2dbf142dfcc7ab, 0x6e3569326c784337),
+    (0xacb92ed9397bf996, 0x49c2c37f07965404),
+    (0xd7e77a8f87daf7fb, 0xdc33745ec97be906),
+    (0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3),
+    (0xa8acd7c0222311bc, 0xc40832ea0d68ce0c),
+    (0xd2d80db02aabd62b, 0xf50a3fa490c30190),
+    (0x83c7088e1aab65db, 0x792667c6da79e0fa),
+    (0xa4b8cab1a1563f52, 0x577001b891185938),
+    (0xcde6fd5e09abcf26, 0xed4c0226b55e6f86),
+    (0x80b05e5ac60b6178, 0x544f8158315b05b4),
+    (0xa0dc75f1778e39d6, 0x696361ae3db1c721),
+    (0xc913936dd571c84c, 0x03bc3a19cd1e38e9),
+    (0xfb5878494ace3a5f, 0x04ab48a04065c723),
+    (0x9d174b2dcec0e47b, 0x62eb0d64283f9c76),
+    (0xc45d1df942711d9a, 0x3ba5d0bd324f8394),
+    (0xf5746577930d6500, 0xca8f44ec7ee36479),
+    (0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb),
+    (0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e),
+    (0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e),
+    (0x95d04aee3b80ece5, 0xbba1f1d158724a12),
+    (0xbb445da9ca61281f, 0x2a8a6e45ae8edc97),
+    (0xea1575143cf97226, 0xf52d09d71a3293bd),
+    (0x924d692ca61be758, 0x593c2626705f9c56),
+    (0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c),
+    (0xe498f455c38b997a, 0x0b6dfb9c0f956447),
+    (0x8edf98b59a373fec, 0x4724bd4189bd5eac),
+    (0xb2977ee300c50fe7, 0x58edec91ec2cb657),
+    (0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed),
+    (0x8b865b215899f46c, 0xbd79e0d20082ee74),
+    (0xae67f1e9aec07187, 0xecd8590680a3aa11),
+    (0xda01ee641a708de9, 0xe80e6f4820cc9495),
+    (0x884134fe908658b2, 0x3109058d147fdcdd),
+    (0xaa51823e34a7eede, 0xbd4b46f0599fd415),
+    (0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a),
+    (0x850fadc09923329e, 0x03e2cf6bc604ddb0),
+    (0xa6539930bf6bff45, 0x84db8346b786151c),
+    (0xcfe87f7cef46ff16, 0xe612641865679a63),
+    (0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e),
+    (0xa26da3999aef7749, 0xe3be5e330f38f09d),
+    (0xcb090c8001ab551c, 0x5cadf5bfd3072cc5),
+    (0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6),
+    (0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa),
+    (0xc646d63501a1511d, 0xb281e1fd541501b8),
+    (0xf7d88bc24209a565, 0x1f225a7ca91a4226),
+    (0x9ae757596946075f, 0x3375788de9b06958),
+    (0xc1a12d2fc3978937, 0x0052d6b1641c83ae),
+    (0xf209787bb47d6b84, 0xc0678c5dbd23a49a),
+    (0x9745eb4d50ce6332, 0xf840b7ba963646e0),
+    (0xbd176620a501fbff, 0xb650e5a93bc3d898),
+    (0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe),
+    (0x93ba47c980e98cdf, 0xc66f336c36b10137),
+    (0xb8a8d9bbe123f017, 0xb80b0047445d4184),
+    (0xe6d3102ad96cec1d, 0xa60dc059157491e5),
+    (0x9043ea1ac7e41392, 0x87c89837ad68db2f),
+    (0xb454e4a179dd1877, 0x29babe4598c311fb),
+    (0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a),
+    (0x8ce2529e2734bb1d, 0x1899e4a65f58660c),
+    (0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f),
+    (0xdc21a1171d42645d, 0x76707543f4fa1f73),
+    (0x899504ae72497eba, 0x6a06494a791c53a8),
+    (0xabfa45da0edbde69, 0x0487db9d17636892),
+    (0xd6f8d7509292d603, 0x45a9d2845d3c42b6),
+    (0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2),
+    (0xa7f26836f282b732, 0x8e6cac7768d7141e),
+    (0xd1ef0244af2364ff, 0x3207d795430cd926),
+    (0x8335616aed761f1f, 0x7f44e6bd49e807b8),
+    (0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6),
+    (0xcd036837130890a1, 0x36dba887c37a8c0f),
+    (0x802221226be55a64, 0xc2494954da2c9789),
+    (0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c),
+    (0xc83553c5c8965d3d, 0x6f92829494e5acc7),
+    (0xfa42a8b73abbf48c, 0xcb772339ba1f17f9),
+    (0x9c69a97284b578d7, 0xff2a760414536efb),
+    (0xc38413cf25e2d70d, 0xfef5138519684aba),
+    (0xf46518c2ef5b8cd1, 0x7eb258665fc25d69),
+    (0x98bf2f79d5993802, 0xef2f773ffbd97a61),
+    (0xbeeefb584aff8603, 0xaafb550ffacfd8fa),
+    (0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38),
+    (0x952ab45cfa97a0b2, 0xdd945a747bf26183),
+    (0xba756174393d88df, 0x94f971119aeef9e4),
+    (0xe912b9d1478ceb17, 0x7a37cd5601aab85d),
+    (0x91abb422ccb812ee, 0xac62e055c10ab33a),
+    (0xb616a12b7fe617aa, 0x577b986b314d6009),
+    (0xe39c49765fdf9d94, 0xed5a7e85fda0b80b),
+    (0x8e41ade9fbebc27d, 0x14588f13be847307),
+    (0xb1d219647ae6b31c, 0x596eb2d8ae258fc8),
+    (0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb),
+    (0x8aec23d680043bee, 0x25de7bb9480d5854),
+    (0xada72ccc20054ae9, 0xaf561aa79a10ae6a),
+    (0xd910f7ff28069da4, 0x1b2ba1518094da04),
+    (0x87aa9aff79042286, 0x90fb44d2f05d0842),
+    (0xa99541bf57452b28, 0x353a1607ac744a53),
+    (0xd3fa922f2d1675f2, 0x42889b8997915ce8),
+    (0x847c9b5d7c2e09b7, 0x69956135febada11),
+    (0xa59bc234db398c25, 0x43fab9837e699095),
+    (0xcf02b2c21207ef2e, 0x94f967e45e03f4bb),
+    (0x8161afb94b44f57d, 0x1d1be0eebac278f5),
+    (0xa1ba1ba79e1632dc, 0x6462d92a69731732),
+    (0xca28a291859bbf93, 0x7d7b8f7503cfdcfe),
+    (0xfcb2cb35e702af78, 0x5cda735244c3d43e),
+    (0x9defbf01b061adab, 0x3a0888136afa64a7),
+    (0xc56baec21c7a1916, 0x088aaa1845b8fdd0),
+    (0xf6c69a72a3989f5b, 0x8aad549e57273d45),
+    (0x9a3c2087a63f6399, 0x36ac54e2f678864b),
+    (0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd),
+    (0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5),
+    (0x969eb7c47859e743, 0x9f644ae5a4b1b325),
+    (0xbc4665b596706114, 0x873d5d9f0dde1fee),
+    (0xeb57ff22fc0c7959, 0xa90cb506d155a7ea),
+    (0x9316ff75dd87cbd8, 0x09a7f12442d588f2),
+    (0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f),
+    (0xe5d3ef282a242e81, 0x8f1668c8a86da5fa),
+    (0x8fa475791a569d10, 0xf96e017d694487bc),
+    (0xb38d92d760ec4455, 0x37c981dcc395a9ac),
+    (0xe070f78d3927556a, 0x85bbe253f47b1417),
+    (0x8c469ab843b89562, 0x93956d7478ccec8e),
+    (0xaf58416654a6babb, 0x387ac8d1970027b2),
+    (0xdb2e51bfe9d0696a, 0x06997b05fcc0319e),
+    (0x88fcf317f22241e2, 0x441fece3bdf81f03),
+    (0xab3c2fddeeaad25a, 0xd527e81cad7626c3),
+    (0xd60b3bd56a5586f1, 0x8a71e223d8d3b074),
+    (0x85c7056562757456, 0xf6872d5667844e49),
+    (0xa738c6bebb12d16c, 0xb428f8ac016561db),
+    (0xd106f86e69d785c7, 0xe13336d701beba52),
+    (0x82a45b450226b39c, 0xecc0024661173473),
+    (0xa34d721642b06084, 0x27f002d7f95d0190),
+    (0xcc20ce9bd35c78a5, 0x31ec038df7b441f4),
+    (0xff290242c83396ce, 0x7e67047175a15271),
+    (0x9f79a169bd203e41, 0x0f0062c6e984d386),
+    (0xc75809c42c684dd1, 0x52c07b78a3e60868),
+    (0xf92e0c3537826145, 0xa7709a56ccdf8a82),
+    (0x9bbcc7a142b17ccb, 0x88a66076400bb691),
+    (0xc2abf989935ddbfe, 0x6acff893d00ea435),
+    (0xf356f7ebf83552fe, 0x0583f6b8c4124d43),
+    (0x98165af37b2153de, 0xc3727a337a8b704a),
+    (0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c),
+    (0xeda2ee1c7064130c, 0x1162def06f79df73),
+    (0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8),
+    (0xb9a74a0637ce2ee1, 0x6d953e2bd7173692),
+    (0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437),
+    (0x910ab1d4db9914a0, 0x1d9c9892400a22a2),
+    (0xb54d5e4a127f59c8, 0x2503beb6d00cab4b),
+    (0xe2a0b5dc971f303a, 0x2e44ae64840fd61d),
+    (0x8da471a9de737e24, 0x5ceaecfed289e5d2),
+    (0xb10d8e1456105dad, 0x7425a83e872c5f47),
+    (0xdd50f1996b947518, 0xd12f124e28f77719),
+    (0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f),
+    (0xace73cbfdc0bfb7b, 0x636cc64d1001550b),
+    (0xd8210befd30efa5a, 0x3c47f7e05401aa4e),
+    (0x8714a775e3e95c78, 0x65acfaec34810a71),
+    (0xa8d9d1535ce3b396, 0x7f1839a741a14d0d),
+    (0xd31045a8341ca07c, 0x1ede48111209a050),
+    (0x83ea2b892091e44d, 0x934aed0aab460432),
+    (0xa4e4b66b68b65d60, 0xf81da84d5617853f),
+    (0xce1de40642e3f4b9, 0x36251260ab9d668e),
+    (0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019),
+    (0xa1075a24e4421730, 0xb24cf65b8612f81f),
+    (0xc94930ae1d529cfc, 0xdee033f26797b627),
+    (0xfb9b7cd9a4a7443c, 0x169840ef017da3b1),
+    (0x9d412e0806e88aa5, 0x8e1f289560ee864e),
+    (0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2),
+    (0xf5b5d7ec8acb58a2, 0xae10af696774b1db),
+    (0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29),
+    (0xbff610b0cc6edd3f, 0x17fd090a58d32af3),
+    (0xeff394dcff8a948e, 0xddfc4b4cef07f5b0),
+    (0x95f83d0a1fb69cd9, 0x4abdaf101564f98e),
+    (0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1),
+    (0xea53df5fd18d5513, 0x84c86189216dc5ed),
+    (0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4),
+    (0xb7118682dbb66a77, 0x3fbc8c33221dc2a1),
+    (0xe4d5e82392a40515, 0x0fabaf3feaa5334a),
+    (0x8f05b1163ba6832d, 0x29cb4d87f2a7400e),
+    (0xb2c71d5bca9023f8, 0x743e20e9ef511012),
+    (0xdf78e4b2bd342cf6, 0x914da9246b255416),
+    (0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e),
+    (0xae9672aba3d0c320, 0xa184ac2473b529b1),
+    (0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e),
+    (0x8865899617fb1871, 0x7e2fa67c7a658892),
+    (0xaa7eebfb9df9de8d, 0xddbb901b98feeab7),
+    (0xd51ea6fa85785631, 0x552a74227f3ea565),
+    (0x8533285c936b35de, 0xd53a88958f87275f),
+    (0xa67ff273b8460356, 0x8a892abaf368f137),
+    (0xd01fef10a657842c, 0x2d2b7569b0432d85),
+    (0x8213f56a67f6b29b, 0x9c3b29620e29fc73),
+    (0xa298f2c501f45f42, 0x8349f3ba91b47b8f),
+    (0xcb3f2f7642717713, 0x241c70a936219a73),
+    (0xfe0efb53d30dd4d7, 0xed238cd383aa0110),
+    (0x9ec95d1463e8a506, 0xf4363804324a40aa),
+    (0xc67bb4597ce2ce48, 0xb143c6053edcd0d5),
+    (0xf81aa16fdc1b81da, 0xdd94b7868e94050a),
+    (0x9b10a4e5e9913128, 0xca7cf2b4191c8326),
+    (0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0),
+    (0xf24a01a73cf2dccf, 0xbc633b39673c8cec),
+    (0x976e41088617ca01, 0xd5be0503e085d813),
+    (0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18),
+    (0xec9c459d51852ba2, 0xddf8e7d60ed1219e),
+    (0x93e1ab8252f33b45, 0xcabb90e5c942b503),
+    (0xb8da1662e7b00a17, 0x3d6a751f3b936243),
+    (0xe7109bfba19c0c9d, 0x0cc512670a783ad4),
+    (0x906a617d450187e2, 0x27fb2b80668b24c5),
+    (0xb484f9dc9641e9da, 0xb1f9f660802dedf6),
+    (0xe1a63853bbd26451, 0x5e7873f8a0396973),
+    (0x8d07e33455637eb2, 0xdb0b487b6423e1e8),
+    (0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62),
+    (0xdc5c5301c56b75f7, 0x7641a140cc7810fb),
+    (0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d),
+    (0xac2820d9623bf429, 0x546345fa9fbdcd44),
+    (0xd732290fbacaf133, 0xa97c177947ad4095),
+    (0x867f59a9d4bed6c0, 0x49ed8eabcccc485d),
+    (0xa81f301449ee8c70, 0x5c68f256bfff5a74),
+    (0xd226fc195c6a2f8c, 0x73832eec6fff3111),
+    (0x83585d8fd9c25db7, 0xc831fd53c5ff7eab),
+    (0xa42e74f3d032f525, 0xba3e7ca8b77f5e55),
+    (0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb),
+    (0x80444b5e7aa7cf85, 0x7980d163cf5b81b3),
+    (0xa0555e361951c366, 0xd7e105bcc332621f),
+    (0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7),
+    (0xfa856334878fc150, 0xb14f98f6f0feb951),
+    (0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3),
+    (0xc3b8358109e84f07, 0x0a862f80ec4700c8),
+    (0xf4a642e14c6262c8, 0xcd27bb612758c0fa),
+    (0x98e7e9cccfbd7dbd, 0x8038d51cb897789c),
+    (0xbf21e44003acdd2c, 0xe0470a63e6bd56c3),
+    (0xeeea5d5004981478, 0x1858ccfce06cac74),
+    (0x95527a5202df0ccb, 0x0f37801e0c43ebc8),
+    (0xbaa718e68396cffd, 0xd30560258f54e6ba),
+    (0xe950df20247c83fd, 0x47c6b82ef32a2069),
+    (0x91d28b7416cdd27e, 0x4cdc331d57fa5441),
+    (0xb6472e511c81471d, 0xe0133fe4adf8e952),
+    (0xe3d8f9e563a198e5, 0x58180fddd97723a6),
+    (0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648),
+];
+
+/// Bits in the entries of `POW5_SPLIT` and `POW5_INV_SPLIT`.
+pub const POW5_BITS: i32 = 125;
+
+/// `5^i` truncated to `POW5_BITS` bits, as `(low, high)`.
+pub static POW5_SPLIT: [(u64, u64); 326] = [
+    (0x0000000000000000, 0x1000000000000000),
+    (0x0000000000000000, 0x1400000000000000),
+    (0x0000000000000000, 0x1900000000000000),
+    (0x0000000000000000, 0x1f40000000000000),
+    (0x0000000000000000, 0x1388000000000000),
+    (0x0000000000000000, 0x186a000000000000),
+    (0x0000000000000000, 0x1e84800000000000),
+    (0x0000000000000000, 0x1312d00000000000),
+    (0x0000000000000000, 0x17d7840000000000),
+    (0x0000000000000000, 0x1dcd650000000000),
+    (0x0000000000000000, 0x12a05f2000000000),
+    (0x0000000000000000, 0x174876e800000000),
+    (0x0000000000000000, 0x1d1a94a200000000),
+    (0x0000000000000000, 0x12309ce540000000),
+    (0x0000000000000000, 0x16bcc41e90000000),
+    (0x0000000000000000, 0x1c6bf52634000000),
+    (0x0000000000000000, 0x11c37937e0800000),
+    (0x0000000000000000, 0x16345785d8a00000),
+    (0x0000000000000000, 0x1bc16d674ec80000),
+    (0x0000000000000000, 0x1158e460913d0000),
+    (0x0000000000000000, 0x15af1d78b58c4000),
+    (0x0000000000000000, 0x1b1ae4d6e2ef5000),
+    (0x0000000000000000, 0x10f0cf064dd59200),
+    (0x0000000000000000, 0x152d02c7e14af680),
+    (0x0000000000000000, 0x1a784379d99db420),
+    (0x0000000000000000, 0x108b2a2c28029094),
+    (0x0000000000000000, 0x14adf4b7320334b9),
+    (0x4000000000000000, 0x19d971e4fe8401e7),
+    (0x8800000000000000, 0x1027e72f1f128130),
+    (0xaa00000000000000, 0x1431e0fae6d7217c),
+    (0xd480000000000000, 0x193e5939a08ce9db),
+    (0xc9a0000000000000, 0x1f8def8808b02452),
+    (0xbe04000000000000, 0x13b8b5b5056e16b3),
+    (0xad85000000000000, 0x18a6e32246c99c60),
+    (0xd8e6400000000000, 0x1ed09bead87c0378),
+    (0x878fe80000000000, 0x13426172c74d822b),
+    (0x6973e20000000000, 0x1812f9cf7920e2b6),
+    (0x03d0da8000000000, 0x1e17b84357691b64),
+    (0x8262889000000000, 0x12ced32a16a1b11e),
+    (0x22fb2ab400000000, 0x178287f49c4a1d66),
+    (0xabb9f56100000000, 0x1d6329f1c35ca4bf),
+    (0xcb54395ca0000000, 0x125dfa371a19e6f7),
+    (0xbe2947b3c8000000, 0x16f578c4e0a060b5),
+    (0x2db399a0ba000000, 0x1cb2d6f618c878e3),
+    (0xfc90400474400000, 0x11efc659cf7d4b8d),
+    (0x7bb4500591500000, 0x166bb7f0435c9e71),
+    (0xdaa16406f5a40000, 0x1c06a5ec5433c60d),
+    (0xa8a4de8459868000, 0x118427b3b4a05bc8),
+    (0xd2ce16256fe82000, 0x15e531a0a1c872ba),
+    (0x87819baecbe22800, 0x1b5e7e08ca3a8f69),
+    (0xf4b1014d3f6d5900, 0x111b0ec57e6499a1),
+    (0x71dd41a08f48af40, 0x1561d276ddfdc00a),
+    (0x0e549208b31adb10, 0x1aba4714957d300d),
+    (0x28f4db456ff0c8ea, 0x10b46c6cdd6e3e08),
+    (0x33321216cbecfb24, 0x14e1878814c9cd8a),
+    (0xbffe969c7ee839ed, 0x1a19e96a19fc40ec),
+    (0xf7ff1e21cf512434, 0x105031e2503da893),
+    (0xf5fee5aa43256d41, 0x14643e5ae44d12b8),
+    (0x337e9f14d3eec892, 0x197d4df19d605767),
+    (0x005e46da08ea7ab6, 0x1fdca16e04b86d41),
+    (0xa03aec4845928cb2, 0x13e9e4e4c2f34448),
+    (0xc849a75a56f72fde, 0x18e45e1df3b0155a),
+    (0x7a5c1130ecb4fbd6, 0x1f1d75a5709c1ab1),
+    (0xec798abe93f11d65, 0x13726987666190ae),
+    (0xa797ed6e38ed64bf, 0x184f03e93ff9f4da),
+    (0x517de8c9c728bdef, 0x1e62c4e38ff87211),
+    (0xd2eeb17e1c7976b5, 0x12fdbb0e39fb474a),
+    (0x87aa5ddda397d462, 0x17bd29d1c87a191d),
+    (0xe994f5550c7dc97b, 0x1dac74463a989f64),
+    (0x11fd195527ce9ded, 0x128bc8abe49f639f),
+    (0xd67c5faa71c24568, 0x172ebad6ddc73c86),
+    (0x8c1b77950e32d6c2, 0x1cfa698c95390ba8),
+    (0x57912abd28dfc639, 0x121c81f7dd43a749),
+    (0xad75756c7317b7c8, 0x16a3a275d494911b),
+    (0x98d2d2c78fdda5ba, 0x1c4c8b1349b9b562),
+    (0x9f83c3bcb9ea8794, 0x11afd6ec0e14115d),
+    (0x0764b4abe8652979, 0x161bcca7119915b5),
+    (0x493de1d6e27e73d7, 0x1ba2bfd0d5ff5b22),
+    (0x6dc6ad264d8f0866, 0x1145b7e285bf98f5),
+    (0xc938586fe0f2ca80, 0x159725db272f7f32),
+    (0x7b866e8bd92f7d20, 0x1afcef51f0fb5eff),
+    (0xad34051767bdae34, 0x10de1593369d1b5f),
+    (0x9881065d41ad19c1, 0x15159af804446237),
+    (0x7ea147f492186032, 0x1a5b01b605557ac5),
+    (0x6f24ccf8db4f3c1f, 0x1078e111c3556cbb),
+    (0x4aee003712230b27, 0x14971956342ac7ea),
+    (0xdda98044d6abcdf0, 0x19bcdfabc13579e4),
+    (0x0a89f02b062b60b6, 0x10160bcb58c16c2f),
+    (0xcd2c6c35c7b638e4, 0x141b8ebe2ef1c73a),
+    (0x8077874339a3c71d, 0x1922726dbaae3909),
+    (0xe0956914080cb8e4, 0x1f6b0f092959c74b),
+    (0x6c5d61ac8507f38e, 0x13a2e965b9d81c8f),
+    (0x4774ba17a649f072, 0x188ba3bf284e23b3),
+    (0x1951e89d8fdc6c8f, 0x1eae8caef261aca0),
+    (0x0fd3316279e9c3d9, 0x132d17ed577d0be4),
+    (0x13c7fdbb186434cf, 0x17f85de8ad5c4edd),
+    (0x58b9fd29de7d4203, 0x1df67562d8b36294),
+    (0xb7743e3a2b0e4942, 0x12ba095dc7701d9c),
+    (0xe5514dc8b5d1db92, 0x17688bb5394c2503),
+    (0xdea5a13ae3465277, 0x1d42aea2879f2e44),
+    (0x0b2784c4ce0bf38a, 0x1249ad2594c37ceb),
+    (0xcdf165f6018ef06d, 0x16dc186ef9f45c25),
+    (0x416dbf7381f2ac88, 0x1c931e8ab871732f),
+    (0x88e497a83137abd5, 0x11dbf316b346e7fd),
+    (0xeb1dbd923d8596ca, 0x1652efdc6018a1fc),
+    (0x25e52cf6cce6fc7d, 0x1be7abd3781eca7c),
+    (0x97af3c1a40105dce, 0x1170cb642b133e8d),
+    (0xfd9b0b20d0147542, 0x15ccfe3d35d80e30),
+    (0x3d01cde904199292, 0x1b403dcc834e11bd),
+    (0x462120b1a28ffb9b, 0x1108269fd210cb16),
+    (0xd7a968de0b33fa82, 0x154a3047c694fddb),
+    (0xcd93c3158e00f923, 0x1a9cbc59b83a3d52),
+    (0xc07c59ed78c09bb6, 0x10a1f5b813246653),
+    (0xb09b7068d6f0c2a3, 0x14ca732617ed7fe8),
+    (0xdcc24c830cacf34c, 0x19fd0fef9de8dfe2),
+    (0xc9f96fd1e7ec180f, 0x103e29f5c2b18bed),
+    (0x3c77cbc661e71e13, 0x144db473335deee9),
+    (0x8b95beb7fa60e598, 0x1961219000356aa3),
+    (0x6e7b2e65f8f91efe, 0x1fb969f40042c54c),
+    (0xc50cfcffbb9bb35f, 0x13d3e2388029bb4f),
+    (0xb6503c3faa82a037, 0x18c8dac6a0342a23),
+    (0xa3e44b4f95234844, 0x1efb1178484134ac),
+    (0xe66eaf11bd360d2b, 0x135ceaeb2d28c0eb),
+    (0xe00a5ad62c839075, 0x183425a5f872f126),
+    (0x980cf18bb7a47493, 0x1e412f0f768fad70),
+    (0x5f0816f752c6c8dc, 0x12e8bd69aa19cc66),
+    (0xf6ca1cb527787b13, 0x17a2ecc414a03f7f),
+    (0xf47ca3e2715699d7, 0x1d8ba7f519c84f5f),
+    (0xf8cde66d86d62026, 0x127748f9301d319b),
+    (0xf7016008e88ba830, 0x17151b377c247e02),
+    (0xb4c1b80b22ae923c, 0x1cda62055b2d9d83),
+    (0x50f91306f5ad1b65, 0x12087d4358fc8272),
+    (0xe53757c8b318623f, 0x168a9c942f3ba30e),
+    (0x9e852dbadfde7acf, 0x1c2d43b93b0a8bd2),
+    (0xa3133c94cbeb0cc1, 0x119c4a53c4e69763),
+    (0x8bd80bb9fee5cff1, 0x16035ce8b6203d3c),
+    (0xaece0ea87e9f43ee, 0x1b843422e3a84c8b),
+    (0x4d40c9294f238a75, 0x1132a095ce492fd7),
+    (0x2090fb73a2ec6d12, 0x157f48bb41db7bcd),
+    (0x68b53a508ba78856, 0x1adf1aea12525ac0),
+    (0x417144725748b536, 0x10cb70d24b7378b8),
+    (0x51cd958eed1ae283, 0x14fe4d06de5056e6),
+    (0xe640faf2a8619b24, 0x1a3de04895e46c9f),
+    (0xefe89cd7a93d00f7, 0x1066ac2d5daec3e3),
+    (0xebe2c40d938c4134, 0x14805738b51a74dc),
+    (0x26db7510f86f5181, 0x19a06d06e2611214),
+    (0x9849292a9b4592f1, 0x100444244d7cab4c),
+    (0xbe5b73754216f7ad, 0x1405552d60dbd61f),
+    (0xadf25052929cb598, 0x1906aa78b912cba7),
+    (0x996ee4673743e2ff, 0x1f485516e7577e91),
+    (0xffe54ec0828a6ddf, 0x138d352e5096af1a),
+    (0xbfdea270a32d0957, 0x18708279e4bc5ae1),
+    (0x2fd64b0ccbf84bad, 0x1e8ca3185deb719a),
+    (0x5de5eee7ff7b2f4c, 0x1317e5ef3ab32700),
+    (0x755f6aa1ff59fb1f, 0x17dddf6b095ff0c0),
+    (0x92b7454a7f3079e7, 0x1dd55745cbb7ecf0),
+    (0x5bb28b4e8f7e4c30, 0x12a5568b9f52f416),
+    (0xf29f2e22335ddf3c, 0x174eac2e8727b11b),
+    (0xef46f9aac035570b, 0x1d22573a28f19d62),
+    (0xd58c5c0ab8215667, 0x123576845997025d),
+    (0x4aef730d6629ac01, 0x16c2d4256ffcc2f5),
+    (0x9dab4fd0bfb41701, 0x1c73892ecbfbf3b2),
+    (0xa28b11e277d08e60, 0x11c835bd3f7d784f),
+    (0x8b2dd65b15c4b1f9, 0x163a432c8f5cd663),
+    (0x6df94bf1db35de77, 0x1bc8d3f7b3340bfc),
+    (0xc4bbcf772901ab0a, 0x115d847ad000877d),
+    (0x35eac354f34215cd, 0x15b4e5998400a95d),
+    (0x8365742a30129b40, 0x1b221effe500d3b4),
+    (0xd21f689a5e0ba108, 0x10f5535fef208450),
+    (0x06a742c0f58e894a, 0x1532a837eae8a565),
+    (0x4851137132f22b9d, 0x1a7f5245e5a2cebe),
+    (0xed32ac26bfd75b42, 0x108f936baf85c136),
+    (0xa87f57306fcd3212, 0x14b378469b673184),
+    (0xd29f2cfc8bc07e97, 0x19e056584240fde5),
+    (0xa3a37c1dd7584f1e, 0x102c35f729689eaf),
+    (0x8c8c5b254d2e62e6, 0x14374374f3c2c65b),
+    (0x6faf71eea079fb9f, 0x1945145230b377f2),
+    (0x0b9b4e6a48987a87, 0x1f965966bce055ef),
+    (0x674111026d5f4c94, 0x13bdf7e0360c35b5),
+    (0xc111554308b71fba, 0x18ad75d8438f4322),
+    (0x7155aa93cae4e7a8, 0x1ed8d34e547313eb),
+    (0x26d58a9c5ecf10c9, 0x13478410f4c7ec73),
+    (0xf08aed437682d4fb, 0x1819651531f9e78f),
+    (0xecada89454238a3a, 0x1e1fbe5a7e786173),
+    (0x73ec895cb4963664, 0x12d3d6f88f0b3ce8),
+    (0x90e7abb3e1bbc3fd, 0x1788ccb6b2ce0c22),
+    (0x352196a0da2ab4fd, 0x1d6affe45f818f2b),
+    (0x0134fe24885ab11e, 0x1262dfeebbb0f97b),
+    (0xc1823dadaa715d65, 0x16fb97ea6a9d37d9),
+    (0x31e2cd19150db4bf, 0x1cba7de5054485d0),
+    (0x1f2dc02fad2890f7, 0x11f48eaf234ad3a2),
+    (0xa6f9303b9872b535, 0x1671b25aec1d888a),
+    (0x50b77c4a7e8f6282, 0x1c0e1ef1a724eaad),
+    (0x5272adae8f199d91, 0x1188d357087712ac),
+    (0x670f591a32e004f6, 0x15eb082cca94d757),
+    (0x40d32f60bf980633, 0x1b65ca37fd3a0d2d),
+    (0x4883fd9c77bf03e0, 0x111f9e62fe44483c),
+    (0x5aa4fd0395aec4d8, 0x156785fbbdd55a4b),
+    (0x314e3c447b1a760e, 0x1ac1677aad4ab0de),
+    (0xded0e5aaccf089c9, 0x10b8e0acac4eae8a),
+    (0x96851f15802cac3b, 0x14e718d7d7625a2d),
+    (0xfc2666dae037d74a, 0x1a20df0dcd3af0b8),
+    (0x9d980048cc22e68e, 0x10548b68a044d673),
+    (0x84fe005aff2ba032, 0x1469ae42c8560c10),
+    (0xa63d8071bef6883e, 0x198419d37a6b8f14),
+    (0xcfcce08e2eb42a4e, 0x1fe52048590672d9),
+    (0x21e00c58dd309a70, 0x13ef342d37a407c8),
+    (0x2a580f6f147cc10d, 0x18eb0138858d09ba),
+    (0xb4ee134ad99bf150, 0x1f25c186a6f04c28),
+    (0x7114cc0ec80176d2, 0x137798f428562f99),
+    (0xcd59ff127a01d486, 0x18557f31326bbb7f),
+    (0xc0b07ed7188249a8, 0x1e6adefd7f06aa5f),
+    (0xd86e4f466f516e09, 0x1302cb5e6f642a7b),
+    (0xce89e3180b25c98b, 0x17c37e360b3d351a),
+    (0x822c5bde0def3bee, 0x1db45dc38e0c8261),
+    (0xf15bb96ac8b58575, 0x1290ba9a38c7d17c),
+    (0x2db2a7c57ae2e6d2, 0x1734e940c6f9c5dc),
+    (0x391f51b6d99ba086, 0x1d022390f8b83753),
+    (0x03b3931248014454, 0x1221563a9b732294),
+    (0x04a077d6da019569, 0x16a9abc9424feb39),
+    (0x45c895cc9081fac3, 0x1c5416bb92e3e607),
+    (0x8b9d5d9fda513cba, 0x11b48e353bce6fc4),
+    (0xae84b507d0e58be8, 0x1621b1c28ac20bb5),
+    (0x1a25e249c51eeee3, 0x1baa1e332d728ea3),
+    (0xf057ad6e1b33554d, 0x114a52dffc679925),
+    (0x6c6d98c9a2002aa1, 0x159ce797fb817f6f),
+    (0x4788fefc0a803549, 0x1b04217dfa61df4b),
+    (0x0cb59f5d8690214e, 0x10e294eebc7d2b8f),
+    (0xcfe30734e83429a1, 0x151b3a2a6b9c7672),
+    (0x83dbc9022241340a, 0x1a6208b50683940f),
+    (0xb2695da15568c086, 0x107d457124123c89),
+    (0x1f03b509aac2f0a7, 0x149c96cd6d16cbac),
+    (0x26c4a24c1573acd1, 0x19c3bc80c85c7e97),
+    (0x783ae56f8d684c03, 0x101a55d07d39cf1e),
+    (0x16499ecb70c25f03, 0x1420eb449c8842e6),
+    (0x9bdc067e4cf2f6c4, 0x19292615c3aa539f),
+    (0x82d3081de02fb476, 0x1f736f9b3494e887),
+    (0xb1c3e512ac1dd0c9, 0x13a825c100dd1154),
+    (0xde34de57572544fc, 0x18922f31411455a9),
+    (0x55c215ed2cee963b, 0x1eb6bafd91596b14),
+    (0xb5994db43c151de5, 0x133234de7ad7e2ec),
+    (0xe2ffa1214b1a655e, 0x17fec216198ddba7),
+    (0xdbbf89699de0feb6, 0x1dfe729b9ff15291),
+    (0x2957b5e202ac9f31, 0x12bf07a143f6d39b),
+    (0xf3ada35a8357c6fe, 0x176ec98994f48881),
+    (0x70990c31242db8bd, 0x1d4a7bebfa31aaa2),
+    (0x865fa79eb69c9376, 0x124e8d737c5f0aa5),
+    (0xe7f791866443b854, 0x16e230d05b76cd4e),
+    (0xa1f575e7fd54a669, 0x1c9abd04725480a2),
+    (0xa53969b0fe54e801, 0x11e0b622c774d065),
+    (0x0e87c41d3dea2202, 0x1658e3ab7952047f),
+    (0xd229b5248d64aa82, 0x1bef1c9657a6859e),
+    (0x435a1136d85eea91, 0x117571ddf6c81383),
+    (0x143095848e76a536, 0x15d2ce55747a1864),
+    (0x193cbae5b2144e83, 0x1b4781ead1989e7d),
+    (0x2fc5f4cf8f4cb112, 0x110cb132c2ff630e),
+    (0xbbb77203731fdd56, 0x154fdd7f73bf3bd1),
+    (0x2aa54e844fe7d4ac, 0x1aa3d4df50af0ac6),
+    (0xdaa75112b1f0e4eb, 0x10a6650b926d66bb),
+    (0xd15125575e6d1e26, 0x14cffe4e7708c06a),
+    (0x85a56ead360865b0, 0x1a03fde214caf085),
+    (0x7387652c41c53f8e, 0x10427ead4cfed653),
+    (0x50693e7752368f71, 0x14531e58a03e8be8),
+    (0x64838e1526c4334e, 0x1967e5eec84e2ee2),
+    (0xfda4719a70754022, 0x1fc1df6a7a61ba9a),
+    (0xde86c70086494815, 0x13d92ba28c7d14a0),
+    (0x162878c0a7db9a1a, 0x18cf768b2f9c59c9),
+    (0x5bb296f0d1d280a1, 0x1f03542dfb83703b),
+    (0x194f9e5683239064, 0x1362149cbd322625),
+    (0x5fa385ec23ec747e, 0x183a99c3ec7eafae),
+    (0xf78c67672ce7919d, 0x1e494034e79e5b99),
+    (0x3ab7c0a07c10bb02, 0x12edc82110c2f940),
+    (0x4965b0c89b14e9c3, 0x17a93a2954f3b790),
+    (0x5bbf1cfac1da2433, 0x1d9388b3aa30a574),
+    (0xb957721cb92856a0, 0x127c35704a5e6768),
+    (0xe7ad4ea3e7726c48, 0x171b42cc5cf60142),
+    (0xa198a24ce14f075a, 0x1ce2137f74338193),
+    (0x44ff65700cd16498, 0x120d4c2fa8a030fc),
+    (0x563f3ecc1005bdbe, 0x16909f3b92c83d3b),
+    (0x2bcf0e7f14072d2e, 0x1c34c70a777a4c8a),
+    (0x5b61690f6c847c3d, 0x11a0fc668aac6fd6),
+    (0xf239c35347a59b4c, 0x16093b802d578bcb),
+    (0xeec83428198f021f, 0x1b8b8a6038ad6ebe),
+    (0x553d20990ff96153, 0x1137367c236c6537),
+    (0x2a8c68bf53f7b9a8, 0x1585041b2c477e85),
+    (0x752f82ef28f5a812, 0x1ae64521f7595e26),
+    (0x093db1d57999890b, 0x10cfeb353a97dad8),
+    (0x0b8d1e4ad7ffeb4e, 0x1503e602893dd18e),
+    (0x8e7065dd8dffe622, 0x1a44df832b8d45f1),
+    (0xf9063faa78bfefd5, 0x106b0bb1fb384bb6),
+    (0xb747cf9516efebca, 0x1485ce9e7a065ea4),
+    (0xe519c37a5cabe6bd, 0x19a742461887f64d),
+    (0xaf301a2c79eb7036, 0x1008896bcf54f9f0),
+    (0xdafc20b798664c43, 0x140aabc6c32a386c),
+    (0x11bb28e57e7fdf54, 0x190d56b873f4c688),
+    (0x1629f31ede1fd72a, 0x1f50ac6690f1f82a),
+    (0x4dda37f34ad3e67a, 0x13926bc01a973b1a),
+    (0xe150c5f01d88e019, 0x187706b0213d09e0),
+    (0x19a4f76c24eb181f, 0x1e94c85c298c4c59),
+    (0xb0071aa39712ef13, 0x131cfd3999f7afb7),
+    (0x9c08e14c7cd7aad8, 0x17e43c8800759ba5),
+    (0x030b199f9c0d958e, 0x1ddd4baa0093028f),
+    (0x61e6f003c1887d79, 0x12aa4f4a405be199),
+    (0xba60ac04b1ea9cd7, 0x1754e31cd072d9ff),
+    (0xa8f8d705de65440d, 0x1d2a1be4048f907f),
+    (0xc99b8663aaff4a88, 0x123a516e82d9ba4f),
+    (0xbc0267fc95bf1d2a, 0x16c8e5ca239028e3),
+    (0xab0301fbbb2ee474, 0x1c7b1f3cac74331c),
+    (0xeae1e13d54fd4ec9, 0x11ccf385ebc89ff1),
+    (0x659a598caa3ca27b, 0x1640306766bac7ee),
+    (0xff00efefd4cbcb1a, 0x1bd03c81406979e9),
+    (0x3f6095f5e4ff5ef0, 0x116225d0c841ec32),
+    (0xcf38bb735e3f36ac, 0x15baaf44fa52673e),
+    (0x8306ea5035cf0457, 0x1b295b1638e7010e),
+    (0x11e4527221a162b6, 0x10f9d8ede39060a9),
+    (0x565d670eaa09bb64, 0x15384f295c7478d3),
+    (0x2bf4c0d2548c2a3d, 0x1a8662f3b3919708),
+    (0x1b78f88374d79a66, 0x1093fdd8503afe65),
+    (0x625736a4520d8100, 0x14b8fd4e6449bdfe),
+    (0xfaed044d6690e140, 0x19e73ca1fd5c2d7d),
+    (0xbcd422b0601a8cc8, 0x103085e53e599c6e),
+    (0x6c092b5c78212ffa, 0x143ca75e8df0038a),
+    (0x070b763396297bf8, 0x194bd136316c046d),
+    (0x48ce53c07bb3daf6, 0x1f9ec583bdc70588),
+    (0x2d80f4584d5068da, 0x13c33b72569c6375),
+    (0x78e1316e60a48310, 0x18b40a4eec437c52),
+];
+
+/// `2^(bits(5^i) - 1 + POW5_BITS) / 5^i`, rounded up, as `(low, high)`.
+pub static POW5_INV_SPLIT: [(u64, u64); 342] = [
+    (0x0000000000000001, 0x2000000000000000),
+    (0x999999999999999a, 0x1999999999999999),
+    (0x47ae147ae147ae15, 0x147ae147ae147ae1),
+    (0x6c8b4395810624de, 0x10624dd2f1a9fbe7),
+    (0x7a786c226809d496, 0x1a36e2eb1c432ca5),
+    (0x61f9f01b866e43ab, 0x14f8b588e368f084),
+    (0xb4c7f34938583622, 0x10c6f7a0b5ed8d36),
+    (0x87a6520ec08d236a, 0x1ad7f29abcaf4857),
+    (0x9fb841a566d74f88, 0x15798ee2308c39df),
+    (0xe62d01511f12a607, 0x112e0be826d694b2),
+    (0xd6ae6881cb5109a4, 0x1b7cdfd9d7bdbab7),
+    (0xdef1ed34a2a73aea, 0x15fd7fe17964955f),
+    (0x7f27f0f6e885c8bb, 0x119799812dea1119),
+    (0x650cb4be40d60df8, 0x1c25c268497681c2),
+    (0xea70909833de7193, 0x16849b86a12b9b01),
+    (0x21f3a6e0297ec143, 0x1203af9ee756159b),
+    (0x6985d7cd0f313537, 0x1cd2b297d889bc2b),
+    (0x2137dfd73f5a90f9, 0x170ef54646d49689),
+    (0xe75fe645cc4873fa, 0x12725dd1d243aba0),
+    (0xa5663d3c7a0d865d, 0x1d83c94fb6d2ac34),
+    (0x511e976394d79eb1, 0x179ca10c9242235d),
+    (0xda7edf82dd794bc1, 0x12e3b40a0e9b4f7d),
+    (0x2a6498d1625bac68, 0x1e392010175ee596),
+    (0xeeb6e0a781e2f053, 0x182db34012b25144),
+    (0x58924d52ce4f26a9, 0x1357c299a88ea76a),
+    (0x27507bb7b07ea441, 0x1ef2d0f5da7dd8aa),
+    (0x52a6c95fc0655034, 0x18c240c4aecb13bb),
+    (0x0eebd44c99eaa690, 0x13ce9a36f23c0fc9),
+    (0xb17953adc3110a80, 0x1fb0f6be50601941),
+    (0xc12ddc8b02740867, 0x195a5efea6b34767),
+    (0x3424b06f3529a052, 0x14484bfeebc29f86),
+    (0x901d59f290ee19db, 0x1039d66589687f9e),
+    (0x4cfbc31db4b0295f, 0x19f623d5a8a73297),
+    (0x3d9635b15d59bab2, 0x14c4e977ba1f5bac),
+    (0x97ab5e277de16228, 0x109d8792fb4c4956),
+    (0xf2abc9d8c9689d0d, 0x1a95a5b7f87a0ef0),
+    (0x5bbca17a3aba173e, 0x154484932d2e725a),
+    (0xafca1ac82efb45cb, 0x11039d428a8b8eae),
+    (0xb2dcf7a6b1920945, 0x1b38fb9daa78e44a),
+    (0xf57d92ebc141a104, 0x15c72fb1552d836e),
+    (0xc46475896767b403, 0x116c262777579c58),
+    (0x6d6d88dbd8a5ecd2, 0x1be03d0bf225c6f4),
+    (0x8abe071646eb23db, 0x164cfda3281e38c3),
+    (0x6efe6c11d255b649, 0x11d7314f534b609c),
+    (0xb197134fb6ef8a0e, 0x1c8b821885456760),
+    (0x27ac0f72f8bfa1a5, 0x16d601ad376ab91a),
+    (0xb95672c260994e1e, 0x1244ce242c5560e1),
+    (0xf5571e03cdc21695, 0x1d3ae36d13bbce35),
+    (0x2aac18030b01abab, 0x17624f8a762fd82b),
+    (0xbbbce0026f348956, 0x12b50c6ec4f31355),
+    (0x92c7ccd0b1eda889, 0x1dee7a4ad4b81eef),
+    (0xdbd30a408e57ba07, 0x17f1fb6f10934bf2),
+    (0x7ca8d50071dfc806, 0x1327fc58da0f6ff5),
+    (0xfaa7bb33e9660cd6, 0x1ea6608e29b24cbb),
+    (0x9552fc298784d711, 0x18851a0b548ea3c9),
+    (0xaaa8c9bad2d0ac0e, 0x139dae6f76d88307),
+    (0xdddadc5e1e1aace3, 0x1f62b0b257c0d1a5),
+    (0x7e48b04b4b488a4f, 0x191bc08eac9a4151),
+    (0xcb6d59d5d5d3a1d9, 0x141633a556e1cdda),
+    (0x3c577b1177dc817b, 0x1011c2eaabe7d7e2),
+    (0xc6f25e825960cf2a, 0x19b604aaaca62636),
+    (0x6bf518684780a5bb, 0x14919d5556eb51c5),
+    (0x232a79ed06008496, 0x10747ddddf22a7d1),
+    (0xd1dd8fe1a3340756, 0x1a53fc9631d10c81),
+    (0xa7e4731ae8f66c45, 0x150ffd44f4a73d34),
+    (0x531d28e253f8569e, 0x10d9976a5d52975d),
+    (0xeb61db03b98d5762, 0x1af5bf109550f22e),
+    (0xbc4e48cfc7a445e8, 0x159165a6ddda5b58),
+    (0x6371d3d96c836b20, 0x11411e1f17e1e2ad),
+    (0x9f1c8628ad9f11cd, 0x1b9b6364f3030448),
+    (0xe5b06b53be18db0b, 0x1615e91d8f359d06),
+    (0xeaf3890fcb4715a2, 0x11ab20e472914a6b),
+    (0x44b8db4c7871bc37, 0x1c45016d841baa46),
+    (0x03c715d6c6c1635f, 0x169d9abe03495505),
+    (0x3638de456bcde919, 0x1217aefe69077737),
+    (0x56c163a2461641c1, 0x1cf2b1970e725858),
+    (0xdf011c81d1ab67ce, 0x17288e1271f51379),
+    (0x7f3416ce4155eca5, 0x1286d80ec190dc61),
+    (0x6520247d3556476e, 0x1da48ce468e7c702),
+    (0xea801d30f7783925, 0x17b6d71d20b96c01),
+    (0xbb99b0f3f92cfa84, 0x12f8ac174d612334),
+    (0x5f5c4e532847f739, 0x1e5aacf215683854),
+    (0x7f7d0b75b9d32c2e, 0x18488a5b44536043),
+    (0x9930d5f7c7dc2358, 0x136d3b7c36a919cf),
+    (0x8eb4898c72f9d226, 0x1f152bf9f10e8fb2),
+    (0x722a07a38f2e41b8, 0x18ddbcc7f40ba628),
+    (0xc1bb394fa5be9afa, 0x13e497065cd61e86),
+    (0x9c5ec2190930f7f6, 0x1fd424d6faf030d7),
+    (0x49e56814075a5ff8, 0x197683df2f268d79),
+    (0x6e51201005e1e660, 0x145ecfe5bf520ac7),
+    (0xf1da800cd181851a, 0x104bd984990e6f05),
+    (0x4fc400148268d4f5, 0x1a12f5a0f4e3e4d6),
+    (0xd96999aa01ed772b, 0x14dbf7b3f71cb711),
+    (0xadee1488018ac5bc, 0x10aff95cc5b09274),
+    (0x497ceda668de092c, 0x1ab328946f80ea54),
+    (0x3aca57b853e4d424, 0x155c2076bf9a5510),
+    (0x623b7960431d7683, 0x1116805effaeaa73),
+    (0x9d2bf566d1c8bd9e, 0x1b5733cb32b110b8),
+    (0x7dbcc452416d647f, 0x15df5ca28ef40d60),
+    (0xcafd69db678ab6cc, 0x117f7d4ed8c33de6),
+    (0xab2f0fc572778adf, 0x1bff2ee48e052fd7),
+    (0x88f273045b92d580, 0x1665bf1d3e6a8cac),
+    (0xd3f528d049424466, 0x11eaff4a98553d56),
+    (0xb988414d4203a0a3, 0x1cab3210f3bb9557),
+    (0x6139cdd76802e6e9, 0x16ef5b40c2fc7779),
+    (0xe761717920025254, 0x125915cd68c9f92d),
+    (0xa568b58e999d5086, 0x1d5b561574765b7c),
+    (0x5120913ee14aa6d2, 0x177c44ddf6c515fd),
+    (0xa74d40ff1aa21f0e, 0x12c9d0b1923744ca),
+    (0x0baece64f769cb4a, 0x1e0fb44f50586e11),
+    (0x3c8bd850c5ee3c3b, 0x180c903f7379f1a7),
+    (0xca0979da37f1c9c9, 0x133d4032c2c7f485),
+    (0xa9a8c2f6bfe942db, 0x1ec866b79e0cba6f),
+    (0x2153cf2bccba9be3, 0x18a0522c7e709526),
+    (0x1aa9728970954982, 0x13b374f06526ddb8),
+    (0xf775840f1a88759d, 0x1f8587e7083e2f8c),
+    (0x5f9136727ba05e17, 0x19379fec0698260a),
+    (0x1940f85b9619e4df, 0x142c7ff0054684d5),
+    (0xe100c6afab47ea4c, 0x1023998cd1053710),
+    (0xce67a44c453fdd47, 0x19d28f47b4d524e7),
+    (0xd852e9d69dccb106, 0x14a8729fc3ddb71f),
+    (0x79dbee454b0a2738, 0x1086c219697e2c19),
+    (0x295fe3a211a9d859, 0x1a71368f0f30468f),
+    (0xbab31c81a7bb137a, 0x15275ed8d8f36ba5),
+    (0x6228e39aec95a92f, 0x10ec4be0ad8f8951),
+    (0x9d0e38f7e0ef7517, 0x1b13ac9aaf4c0ee8),
+    (0xb0d82d931a592a79, 0x15a956e225d67253),
+    (0x8d79be0f4847552e, 0x11544581b7dec1dc),
+    (0x158f967eda0bbb7c, 0x1bba08cf8c979c94),
+    (0x77a611ff14d62f97, 0x162e6d72d6dfb076),
+    (0xf951a7ff43de8c79, 0x11bebdf578b2f391),
+    (0xc21c3ffed2fdad8e, 0x1c6463225ab7ec1c),
+    (0x01b0333242648ad8, 0x16b6b5b5155ff017),
+    (0x0159c28e9b83a246, 0x122bc490dde659ac),
+    (0xcef604175f3903a3, 0x1d12d41afca3c2ac),
+    (0x725e69ac4c2d9c83, 0x17424348ca1c9bbd),
+    (0xf5185489d68ae39c, 0x129b69070816e2fd),
+    (0xee8d540fbdab05c6, 0x1dc574d80cf16b2f),
+    (0xbed77672fe226b05, 0x17d12a4670c1228c),
+    (0xff12c528cb4ebc04, 0x130dbb6b8d674ed6),
+    (0xcb513b74787df9a0, 0x1e7c5f127bd87e24),
+    (0x090dc929f9fe614d, 0x18637f41fcad31b7),
+    (0xa0d7d42194cb810a, 0x1382cc34ca2427c5),
+    (0x67bfb9cf5478ce77, 0x1f37ad21436d0c6f),
+    (0x1fcc94a5dd2d71f9, 0x18f9574dcf8a7059),
+    (0x7fd6dd517dbdf4c7, 0x13faac3e3fa1f37a),
+    (0xffbe2ee8c92fee0b, 0x1ff779fd329cb8c3),
+    (0x6631bf20a0f324d6, 0x1992c7fdc216fa36),
+    (0xb827cc1a1a5c1d78, 0x14756ccb01abfb5e),
+    (0x935309ae7b7ce460, 0x105df0a267bcc918),
+    (0x1eeb42b0c594a099, 0x1a2fe76a3f9474f4),
+    (0xe58902270476e6e1, 0x14f31f8832dd2a5c),
+    (0xb7a0ce859d2bebe7, 0x10c27fa028b0eeb0),
+    (0x59014a6f61dfdfd8, 0x1ad0cc33744e4ab4),
+    (0xe0cdd525e7e64cad, 0x1573d68f903ea229),
+    (0x4d7177518651d6f1, 0x11297872d9cbb4ee),
+    (0x7be8bee8d6e957e8, 0x1b758d848fac54b0),
+    (0xfcba3253df211320, 0x15f7a46a0c89dd59),
+    (0x63c8284318e74280, 0x1192e9ee706e4aae),
+    (0x060d0d3827d86a66, 0x1c1e43171a4a1117),
+    (0x6b3da42cecad21eb, 0x167e9c127b6e7412),
+    (0x88fe1cf0bd574e56, 0x11fee341fc585cdb),
+    (0x419694b462254a23, 0x1ccb0536608d615f),
+    (0x67abaa29e81dd4e9, 0x1708d0f84d3de77f),
+    (0xb95621bb2017dd87, 0x126d73f9d764b932),
+    (0xc223692b668c95a5, 0x1d7becc2f23ac1ea),
+    (0xce82ba891ed6de1d, 0x179657025b6234bb),
+    (0xa53562074bdf1818, 0x12deac01e2b4f6fc),
+    (0x3b889cd87964f359, 0x1e3113363787f194),
+    (0xfc6d4a46c783f5e1, 0x18274291c6065adc),
+    (0x30576e9f06032b1a, 0x13529ba7d19eaf17),
+    (0x1a257dcb3cd1de90, 0x1eea92a61c311825),
+    (0x481dfe3c30a7e540, 0x18bba884e35a79b7),
+    (0xd34b31c9c0865100, 0x13c9539d82aec7c5),
+    (0x5211e942cda3b4cd, 0x1fa885c8d117a609),
+    (0x74db21023e1c90a4, 0x19539e3a40dfb807),
+    (0xf715b401cb4a0d50, 0x1442e4fb67196005),
+    (0xf8de299b09080aa7, 0x103583fc527ab337),
+    (0x8e304291a80cddd7, 0x19ef3993b72ab859),
+    (0x3e8d020e200a4b13, 0x14bf6142f8eef9e1),
+    (0x653d9b3e80083c0f, 0x10991a9bfa58c7e7),
+    (0x6ec8f864000d2ce4, 0x1a8e90f9908e0ca5),
+    (0x8bd3f9e999a423ea, 0x153eda614071a3b7),
+    (0x3ca994bae1501cbb, 0x10ff151a99f482f9),
+    (0xc775bac49bb3612b, 0x1b31bb5dc320d18e),
+    (0xd2c4956a16291a89, 0x15c162b168e70e0b),
+    (0xdbd0778811ba7ba1, 0x11678227871f3e6f),
+    (0x2c80bf401c5d929b, 0x1bd8d03f3e9863e6),
+    (0xbd33cc3349e47549, 0x16470cff6546b651),
+    (0xca8fd68f6e505dd4, 0x11d270cc51055ea7),
+    (0x4419574be3b3c953, 0x1c83e7ad4e6efdd9),
+    (0x0347790982f63aa9, 0x16cfec8aa52597e1),
+    (0xcf6c60d468c4fbba, 0x123ff06eea847980),
+    (0xe57a34870e07f92a, 0x1d331a4b10d3f59a),
+    (0x512e906c0b399422, 0x175c1508da432ae2),
+    (0xda8ba6bcd5c7a9b5, 0x12b010d3e1cf5581),
+    (0x90df712e22d90f87, 0x1de6815302e5559c),
+    (0xda4c5a8b4f140c6c, 0x17eb9aa8cf1dde16),
+    (0xaea37ba2a5a9a38a, 0x1322e220a5b17e78),
+    (0x7dd25f6aa2a905a9, 0x1e9e369aa2b59727),
+    (0x97db7f888220d154, 0x187e92154ef7ac1f),
+    (0x797c6606ce80a777, 0x139874ddd8c6234c),
+    (0x8f2d700ae4010bf1, 0x1f5a549627a36bad),
+    (0x0c2459a25000d65a, 0x191510781fb5efbe),
+    (0x701d1481d99a4515, 0x1410d9f9b2f7f2fe),
+    (0xc017439b147b6a77, 0x100d7b2e28c65bfe),
+    (0xccf205c4ed9243f2, 0x19af2b7d0e0a2cca),
+    (0x0a5b37d0be0e9cc2, 0x148c22ca71a1bd6f),
+    (0x0848f973cb3ee3ce, 0x10701bd527b4978c),
+    (0xda0e5bec78649fb0, 0x1a4cf9550c5425ac),
+    (0x7b3eaff060507fc0, 0x150a6110d6a9b7bd),
+    (0x95cbbff380406633, 0x10d51a73deee2c97),
+    (0xefac665266cd7052, 0x1aee90b964b04758),
+    (0x2623850eb8a459db, 0x158ba6fab6f36c47),
+    (0x1e82d0d893b6ae49, 0x113c85955f29236c),
+    (0xfd9e1af41f8ab075, 0x1b9408eefea838ac),
+    (0x97b1af29b2d559f7, 0x16100725988693bd),
+    (0xac8e25baf5777b2c, 0x11a66c1e139edc97),
+    (0x7a7d092b2258c513, 0x1c3d79c9b8fe2dbf),
+    (0x61fda0ef4ead6a76, 0x169794a160cb57cc),
+    (0xe7fe1a590bbdeec5, 0x1212dd4de7091309),
+    (0xa6635d5b45fcb13a, 0x1ceafbafd80e84dc),
+    (0x851c4aaf6b308dc8, 0x172262f3133ed0b0),
+    (0xd0e36ef2bc26d7d4, 0x1281e8c275cbda26),
+    (0xb49f17eac6a48c86, 0x1d9ca79d894629d7),
+    (0x2a18dfef0550706b, 0x17b08617a104ee46),
+    (0x54e0b3259dd9f389, 0x12f39e794d9d8b6b),
+    (0x87cdeb6f62f65274, 0x1e5297287c2f4578),
+    (0xd30b22bf825ea85d, 0x18421286c9bf6ac6),
+    (0x0f3c1bcc684bb9e4, 0x13680ed23aff889f),
+    (0x18602c7a4079296d, 0x1f0ce4839198da98),
+    (0x46b356c833942124, 0x18d71d360e13e213),
+    (0x388f78a029434db6, 0x13df4a91a4dcb4dc),
+    (0x5a7f2766a86baf8a, 0x1fcbaa82a1612160),
+    (0x153285ebb9efbfa2, 0x196fbb9bb44db44d),
+    (0xaa8ed189618c994e, 0x145962e2f6a4903d),
+    (0xeed8a7a11ad6e10c, 0x1047824f2bb6d9ca),
+    (0x7e27729b5e249b45, 0x1a0c03b1df8af611),
+    (0xfe85f549181d4904, 0x14d6695b193bf80d),
+    (0xcb9e5dd4134aa0d0, 0x10ab877c142ff9a4),
+    (0xdf63c9535211014d, 0x1aac0bf9b9e65c3a),
+    (0x191ca10f74da6771, 0x15566ffafb1eb02f),
+    (0xadb080d92a4852c1, 0x1111f32f2f4bc025),
+    (0x15e7348eaa0d5134, 0x1b4feb7eb212cd09),
+    (0xab1f5d3eee710dc4, 0x15d98932280f0a6d),
+    (0xbc1917658b8da49d, 0x117ad428200c0857),
+    (0x2cf4f23c127c3a94, 0x1bf7b9d9cce00d59),
+    (0xf0c3f4fcdb969543, 0x165fc7e170b33de0),
+    (0x5a365d9716121103, 0x11e6398126f5cb1a),
+    (0x9056fc24f01ce804, 0x1ca38f350b22de90),
+    (0xd9df301d8ce3ecd0, 0x16e93f5da2824ba6),
+    (0xe17f59b13d8323da, 0x125432b14ecea2eb),
+    (0x68cbc2b52f38395c, 0x1d53844ee47dd179),
+    (0x53d6355dbf602de3, 0x177603725064a794),
+    (0xa9782ab165e68b1c, 0x12c4cf8ea6b6ec76),
+    (0x0f26aab56fd744fa, 0x1e07b27dd78b13f1),
+    (0x3f52222abfdf6a62, 0x18062864ac6f4327),
+    (0x65db4e88997f884e, 0x1338205089f29c1f),
+    (0x6fc54a7428cc0d4a, 0x1ec033b40fea9365),
+    (0x596aa1f68709a43b, 0x1899c2f673220f84),
+    (0xadeee7f86c07b696, 0x13ae3591f5b4d936),
+    (0x497e3ff3e00c5756, 0x1f7d228322baf524),
+    (0xd464fff64cd6ac45, 0x1930e868e89590e9),
+    (0x4383fff83d7889d1, 0x14272053ed4473ee),
+    (0xcf9cccc69793a174, 0x101f4d0ff1038ff1),
+    (0x7f6147a425b90252, 0x19cbae7fe805b31c),
+    (0xcc4dd2e9b7c7350f, 0x14a2f1ffecd15c16),
+    (0x3d0b0f215fd290d9, 0x10825b3323dab012),
+    (0x61ab4b689950e7c1, 0x1a6a2b85062ab350),
+    (0x4e22a2ba1440b967, 0x1521bc6a6b555c40),
+    (0x0b4ee894dd009453, 0x10e7c9eebc4449cd),
+    (0x1217da87c800ed51, 0x1b0c764ac6d3a948),
+    (0xdb46486ca000bdda, 0x15a391d56bdc876c),
+    (0x490506bd4ccd64af, 0x114fa7ddefe39f8a),
+    (0xa8080ac87ae23ab1, 0x1bb2a62fe638ff43),
+    (0x5339a239fbe82ef4, 0x162884f31e93ff69),
+    (0x75c7b4fb2fecf25d, 0x11ba03f5b20fff87),
+    (0x22d92191e647ea2e, 0x1c5cd322b67fff3f),
+    (0xb57a8141850654f2, 0x16b0a8e891ffff65),
+    (0xc4620101373843f5, 0x1226ed86db3332b7),
+    (0x3a366801f1f39fee, 0x1d0b15a491eb8459),
+    (0xfb5eb99b27f6198b, 0x173c115074bc69e0),
+    (0x2f7efae2865e7ad6, 0x129674405d6387e7),
+    (0xe597f7d0d6fd9156, 0x1dbd86cd6238d971),
+    (0x8479930d78cadaab, 0x17cad23de82d7ac1),
+    (0xd06142712d6f1556, 0x1308a831868ac89a),
+    (0x4d686a4eaf182222, 0x1e74404f3daada91),
+    (0xa453883ef279b4e8, 0x185d003f6488aeda),
+    (0xe9dc6cff28615d87, 0x137d99cc506d58ae),
+    (0xa960ae650d6895a4, 0x1f2f5c7a1a488de4),
+    (0xbab3beb73ded4483, 0x18f2b061aea07183),
+    (0x2ef6322c318a9d36, 0x13f559e7bee6c136),
+    (0xe4bd1d13827761f0, 0x1feef63f97d79b89),
+    (0x83ca7da9352c4e5a, 0x198bf832dfdfafa1),
+    (0x9ca1fe20f756a515, 0x146ff9c24cb2f2e7),
+    (0x4a1b31b3f9121daa, 0x1059949b708f28b9),
+    (0x435eb5ecc1b695dd, 0x1a28edc580e50df5),
+    (0x35e55e57015ede4a, 0x14ed8b04671da4c4),
+    (0xc4b77eac0118b1d5, 0x10be08d0527e1d69),
+    (0xa12597799b5ab622, 0x1ac9a7b3b7302f0f),
+    (0x4db7ac6149155e81, 0x156e1fc2f8f358d9),
+    (0xd7c6238107444b9b, 0x1124e63593f5e0ad),
+    (0x593d059b3ed3ac2b, 0x1b6e3d2286563449),
+    (0xe0fd9e15cbdc89bc, 0x15f1ca820511c36d),
+    (0xb3fe18116fe3a163, 0x118e3b9b37416924),
+    (0x866359b57fd29bd1, 0x1c16c5c525357507),
+    (0xd1e91491330ee30e, 0x16789e3750f790d2),
+    (0x74ba76da8f3f1c0b, 0x11fa182c40c60d75),
+    (0xedf72490e531c678, 0x1cc359e067a348bb),
+    (0x8b2c1d40b75b052d, 0x1702ae4d1fb5d3c9),
+    (0x6f567dcd5f7c0424, 0x12688b70e62b0fd4),
+    (0x7ef0c94898c66d06, 0x1d74124e3d11b2ed),
+    (0x98c0a106e09ebd9f, 0x17900ea4fda7c257),
+    (0x470080d24d4bcae6, 0x12d9a550caec9b79),
+    (0xd800ce1d487944a2, 0x1e29088144adc58e),
+    (0x1333d8176d2dd082, 0x1820d39a9d57d13f),
+    (0xa8f646792424a6ce, 0x134d76154aaca765),
+    (0x74bd3d8ea03aa47d, 0x1ee25688777aa56f),
+    (0x5d64313ee6955064, 0x18b51206c5fbb78c),
+    (0x4ab68dcbebaaa6b7, 0x13c40e6bd1962c70),
+    (0x1124161312aaa457, 0x1fa01712e8f0471a),
+    (0xda8344dc0eeee9df, 0x194cdf4253f36c14),
+    (0xe2029d7cd8bf2180, 0x143d7f6843292343),
+    (0x4e687dfd7a328133, 0x103132b9cf541c36),
+    (0x4a40c9959050ceb8, 0x19e851294bb9c6bd),
+    (0x0833d477a6a70bc6, 0x14b9da876fc7d231),
+    (0xa02976c61eec096b, 0x1094aed2bfd30e8d),
+    (0x004257a364acdbdf, 0x1a877e1dffb81749),
+    (0xcd01dfb5ea23e319, 0x153931b1996012a0),
+    (0x70ce4c91881cb5ae, 0x10fa8e27ade6754d),
+    (0x1ae3adb5a69455e2, 0x1b2a7d0c4970bbaf),
+    (0x7be957c4854377e8, 0x15bb973d078d62f2),
+    (0xc987796a0435f987, 0x1162df64060ab58e),
+    (0x75a58f1006bcc271, 0x1bd1656cd67788e4),
+    (0xf7b7a5a66bca3527, 0x16411df0ab92d3e9),
+    (0x5fc61e1ebca1c41f, 0x11cdb18d560f0fee),
+    (0xffa363646102d365, 0x1c7c4f4889b1b316),
+    (0x32e91c504d9bdc51, 0x16c9d906d48e28df),
+    (0x8f20e37371497d0e, 0x123b140576d820b2),
+    (0x7e9b0585820f2e7c, 0x1d2b533bf159cdea),
+    (0xcbaf379e01a5beca, 0x1755dc2ff447d7ee),
+    (0x0958f94b348498a1, 0x12ab168cc36cacbf),
+];
@@ -69,6 +69,10 @@
 //!
 //! When using `ToJson` the `RustcEncodable` trait implementation is not mandatory.
 //!
+//! `json::decode` parses the whole input into a `json::Json` value before decoding it. For large
+//! inputs, `json::decode_stream` decodes straight from the events of `json::StreamParser`, a pull
+//! parser borrowing from the input which hands out strings without escapes as slices of it.
+//!
 //! # Examples of use
 //!
 //! ## Using Autoserialization
@@ -199,20 +203,23 @@ use self::DecoderError::*;
 use self::ParserState::*;
 use self::InternalStackElement::*;
 
+use std::borrow::Cow;
 use std::collections::{HashMap, BTreeMap};
 use std::io::prelude::*;
 use std::io;
-use std::mem::swap;
+use std::mem::{self, swap};
 use std::num::FpCategory as Fp;
 use std::ops::Index;
 use std::str::FromStr;
 use std::string;
-use std::{char, f64, fmt, str};
+use std::{char, f64, fmt, i64, str};
 use std;
 use rustc_unicode::str as unicode_str;
 use rustc_unicode::str::Utf16Item;
 
 use Encodable;
+use float;
+use scan;
 
 /// Represents a json value
 #[derive(Clone, PartialEq, PartialOrd, Debug)]
@@ -316,6 +323,15 @@ pub fn decode<T: ::Decodable>(s: &str) -> DecodeResult<T> {
     ::Decodable::decode(&mut decoder)
 }
 
+/// Shortcut function to decode a JSON `&str` into an object without building
+/// a `Json` value first (see `StreamDecoder`)
+pub fn decode_stream<T: ::Decodable>(s: &str) -> DecodeResult<T> {
+    let mut decoder = StreamDecoder::new(s);
+    let value = try!(::Decodable::decode(&mut decoder));
+    try!(decoder.finish());
+    Ok(value)
+}
+
 /// Shortcut function to encode a `T` into a JSON `String`
 pub fn encode<T: ::Encodable>(object: &T) -> Result<string::String, EncoderError> {
     let mut s = String::new();
@@ -375,10 +391,17 @@ pub type DecodeResult<T> = Result<T, DecoderError>;
 fn escape_str(wr: &mut fmt::Write, v: &str) -> EncodeResult {
     try!(wr.write_str("\""));
 
+    let bytes = v.as_bytes();
     let mut start = 0;
+    let mut i = 0;
+
+    loop {
+        i += scan::clean_run(&bytes[i..]);
+        if i == bytes.len() {
+            break;
+        }
 
-    for (i, byte) in v.bytes().enumerate() {
-        let escaped = match byte {
+        let escaped = match bytes[i] {
             b'"' => "\\\"",
             b'\\' => "\\\\",
             b'\x00' => "\\u0000",
@@ -414,7 +437,7 @@ fn escape_str(wr: &mut fmt::Write, v: &str) -> EncodeResult {
             b'\x1e' => "\\u001e",
             b'\x1f' => "\\u001f",
             b'\x7f' => "\\u007f",
-            _ => { continue; }
+            _ => unreachable!(),
         };
 
         if start < i {
@@ -423,7 +446,8 @@ fn escape_str(wr: &mut fmt::Write, v: &str) -> EncodeResult {
 
         try!(wr.write_str(escaped));
 
-        start = i + 1;
+        i += 1;
+        start = i;
     }
 
     if start != v.len() {
@@ -455,14 +479,6 @@ fn spaces(wr: &mut fmt::Write, mut n: usize) -> EncodeResult {
     Ok(())
 }
 
-fn fmt_number_or_null(v: f64) -> string::String {
-    match v.classify() {
-        Fp::Nan | Fp::Infinite => string::String::from_str("null"),
-        _ if v.fract() != 0f64 => v.to_string(),
-        _ => v.to_string() + ".0",
-    }
-}
-
 /// A structure for implementing serialization to JSON.
 pub struct Encoder<'a> {
     writer: &'a mut (fmt::Write+'a),
@@ -521,7 +537,7 @@ impl<'a> ::Encoder for Encoder<'a> {
     }
 
     fn emit_f64(&mut self, v: f64) -> EncodeResult {
-        emit_enquoted_if_mapkey!(self, fmt_number_or_null(v))
+        emit_enquoted_if_mapkey!(self, float::format(v))
     }
     fn emit_f32(&mut self, v: f32) -> EncodeResult {
         self.emit_f64(v as f64)
@@ -769,7 +785,7 @@ impl<'a> ::Encoder for PrettyEncoder<'a> {
     }
 
     fn emit_f64(&mut self, v: f64) -> EncodeResult {
-        emit_enquoted_if_mapkey!(self, fmt_number_or_null(v))
+        emit_enquoted_if_mapkey!(self, float::format(v))
     }
     fn emit_f32(&mut self, v: f32) -> EncodeResult {
         self.emit_f64(v as f64)
@@ -1423,6 +1439,8 @@ pub struct Parser<T> {
     stack: Stack,
     // A state machine is kept to make it possible to interrupt and resume parsing.
     state: ParserState,
+    // The text of the number being parsed, converted by `float::parse`.
+    num: Vec<u8>,
 }
 
 impl<T: Iterator<Item=char>> Iterator for Parser<T> {
@@ -1458,6 +1476,7 @@ impl<T: Iterator<Item=char>> Parser<T> {
             col: 0,
             stack: Stack::new(),
             state: ParseStart,
+            num: Vec::new(),
         };
         p.bump();
         return p;
@@ -1503,8 +1522,10 @@ impl<T: Iterator<Item=char>> Parser<T> {
 
     fn parse_number(&mut self) -> JsonEvent {
         let mut neg = false;
+        self.num.clear();
 
         if self.ch_is('-') {
+            self.num.push(b'-');
             self.bump();
             neg = true;
         }
@@ -1515,27 +1536,21 @@ impl<T: Iterator<Item=char>> Parser<T> {
         };
 
         if self.ch_is('.') || self.ch_is('e') || self.ch_is('E') {
-            let mut res = res as f64;
-
             if self.ch_is('.') {
-                res = match self.parse_decimal(res) {
-                    Ok(res) => res,
+                match self.parse_decimal() {
+                    Ok(()) => (),
                     Err(e) => { return Error(e); }
-                };
+                }
             }
 
             if self.ch_is('e') || self.ch_is('E') {
-                res = match self.parse_exponent(res) {
-                    Ok(res) => res,
+                match self.parse_exponent() {
+                    Ok(()) => (),
                     Err(e) => { return Error(e); }
-                };
-            }
-
-            if neg {
-                res *= -1.0;
+                }
             }
 
-            F64Value(res)
+            F64Value(float::parse(&self.num))
         } else {
             if neg {
                 let res = (res as i64).wrapping_neg();
@@ -1552,13 +1567,15 @@ impl<T: Iterator<Item=char>> Parser<T> {
         }
     }
 
-    #[allow(deprecated)] // possible resolve bug is mapping these to traits
+    // Parses the integer part of a number. One too large for a u64 is only an
+    // error if no fractional part or exponent makes it a float.
     fn parse_u64(&mut self) -> Result<u64, ParserError> {
         let mut accum = 0u64;
-        let last_accum = 0; // necessary to detect overflow.
+        let mut overflow = None;
 
         match self.ch_or_null() {
             '0' => {
+                self.num.push(b'0');
                 self.bump();
 
                 // A leading '0' must be the only digit before the decimal point.
@@ -1571,11 +1588,15 @@ impl<T: Iterator<Item=char>> Parser<T> {
                 while !self.eof() {
                     match self.ch_or_null() {
                         c @ '0' ... '9' => {
-                            accum = accum.wrapping_mul(10);
-                            accum = accum.wrapping_add((c as u64) - ('0' as u64));
-
-                            // Detect overflow by comparing to the last value.
-                            if accum <= last_accum { return self.error(InvalidNumber); }
+                            self.num.push(c as u8);
+                            let digit = (c as u64) - ('0' as u64);
+                            match accum.checked_mul(10).and_then(|a| a.checked_add(digit)) {
+                                Some(a) => accum = a,
+                                None => if overflow.is_none() {
+                                    overflow = Some(SyntaxError(InvalidNumber,
+                                                                self.line, self.col));
+                                },
+                            }
 
                             self.bump();
                         }
@@ -1586,10 +1607,14 @@ impl<T: Iterator<Item=char>> Parser<T> {
             _ => return self.error(InvalidNumber),
         }
 
-        Ok(accum)
+        match overflow {
+            Some(e) if !(self.ch_is('.') || self.ch_is('e') || self.ch_is('E')) => Err(e),
+            _ => Ok(accum),
+        }
     }
 
-    fn parse_decimal(&mut self, mut res: f64) -> Result<f64, ParserError> {
+    fn parse_decimal(&mut self) -> Result<(), ParserError> {
+        self.num.push(b'.');
         self.bump();
 
         // Make sure a digit follows the decimal place.
@@ -1598,32 +1623,28 @@ impl<T: Iterator<Item=char>> Parser<T> {
              _ => return self.error(InvalidNumber)
         }
 
-        let mut dec = 1.0;
         while !self.eof() {
             match self.ch_or_null() {
                 c @ '0' ... '9' => {
-                    dec /= 10.0;
-                    res += (((c as isize) - ('0' as isize)) as f64) * dec;
+                    self.num.push(c as u8);
                     self.bump();
                 }
                 _ => break,
             }
         }
 
-        Ok(res)
+        Ok(())
     }
 
-    fn parse_exponent(&mut self, mut res: f64) -> Result<f64, ParserError> {
+    fn parse_exponent(&mut self) -> Result<(), ParserError> {
+        self.num.push(b'e');
         self.bump();
 
-        let mut exp = 0;
-        let mut neg_exp = false;
-
         if self.ch_is('+') {
             self.bump();
         } else if self.ch_is('-') {
+            self.num.push(b'-');
             self.bump();
-            neg_exp = true;
         }
 
         // Make sure a digit follows the exponent place.
@@ -1634,23 +1655,14 @@ impl<T: Iterator<Item=char>> Parser<T> {
         while !self.eof() {
             match self.ch_or_null() {
                 c @ '0' ... '9' => {
-                    exp *= 10;
-                    exp += (c as usize) - ('0' as usize);
-
+                    self.num.push(c as u8);
                     self.bump();
                 }
                 _ => break
             }
         }
 
-        let exp = 10_f64.powi(exp as i32);
-        if neg_exp {
-            res /= exp;
-        } else {
-            res *= exp;
-        }
-
-        Ok(res)
+        Ok(())
     }
 
     fn decode_hex_escape(&mut self) -> Result<u16, ParserError> {
@@ -2078,6 +2090,436 @@ pub fn from_str(s: &str) -> Result<Json, BuilderError> {
     builder.build()
 }
 
+/// The output of the borrowing streaming parser, `StreamParser`.
+///
+/// Unlike `JsonEvent`, object keys are events of their own, each followed by
+/// the events of its value. Strings without escapes are slices of the input;
+/// only strings with escapes are copied.
+#[derive(PartialEq, Clone, Debug)]
+pub enum StreamEvent<'a> {
+    ObjectStart,
+    ObjectEnd,
+    ArrayStart,
+    ArrayEnd,
+    Key(Cow<'a, str>),
+    BooleanValue(bool),
+    I64Value(i64),
+    U64Value(u64),
+    F64Value(f64),
+    StringValue(Cow<'a, str>),
+    NullValue,
+    Error(ParserError),
+}
+
+#[derive(PartialEq, Clone, Copy, Debug)]
+enum StreamState {
+    // A value: the top-level one, the value of a key, or an array element
+    // after a ','.
+    StreamValue,
+    // A value or ']' just after '['.
+    StreamArrayFirst,
+    // A key or '}' just after '{'.
+    StreamObjectFirst,
+    // A key after a ',' in an object.
+    StreamKey,
+    // ',', the end of the enclosing array or object, or the end of the input.
+    StreamAfterValue,
+    // Parsing can't continue.
+    StreamFinished,
+}
+
+/// A streaming JSON parser implemented as an iterator of StreamEvent,
+/// borrowing from a `&str`.
+///
+/// Working on the bytes of the input directly, rather than on an iterator
+/// of char as `Parser` does, lets strings be sliced out of the input and
+/// skipped in runs. Line and column numbers of errors count bytes, and are
+/// only worked out when an error is reported.
+pub struct StreamParser<'a> {
+    src: &'a str,
+    pos: usize,
+    // One element per enclosing array (false) or object (true).
+    stack: Vec<bool>,
+    state: StreamState,
+    // Whether input may follow the top-level value, for a parser reading a
+    // single value out of a larger document.
+    nested: bool,
+}
+
+impl<'a> Iterator for StreamParser<'a> {
+    type Item = StreamEvent<'a>;
+
+    fn next(&mut self) -> Option<StreamEvent<'a>> {
+        match self.parse() {
+            Ok(evt) => evt,
+            Err(reason) => {
+                self.state = StreamState::StreamFinished;
+                Some(StreamEvent::Error(self.syntax_error(reason)))
+            }
+        }
+    }
+}
+
+impl<'a> StreamParser<'a> {
+    /// Creates the JSON parser.
+    pub fn new(src: &'a str) -> StreamParser<'a> {
+        StreamParser {
+            src: src,
+            pos: 0,
+            stack: Vec::new(),
+            state: StreamState::StreamValue,
+            nested: false,
+        }
+    }
+
+    /// Creates a parser for the single value at byte offset `pos` of `src`,
+    /// ignoring whatever follows it.
+    fn value_at(src: &'a str, pos: usize) -> StreamParser<'a> {
+        StreamParser {
+            src: src,
+            pos: pos,
+            stack: Vec::new(),
+            state: StreamState::StreamValue,
+            nested: true,
+        }
+    }
+
+    /// The number of arrays and objects the parser is in.
+    pub fn depth(&self) -> usize {
+        self.stack.len()
+    }
+
+    fn syntax_error(&self, reason: ErrorCode) -> ParserError {
+        let before = &self.src.as_bytes()[..self.pos];
+        let line_start = before.iter().rposition(|&b| b == b'\n').map_or(0, |i| i + 1);
+        let line = before.iter().filter(|&&b| b == b'\n').count() + 1;
+        SyntaxError(reason, line, self.pos - line_start + 1)
+    }
+
+    fn peek_byte(&self) -> Option<u8> {
+        self.src.as_bytes().get(self.pos).cloned()
+    }
+
+    fn parse_whitespace(&mut self) {
+        let src = self.src;
+        let bytes = src.as_bytes();
+        while self.pos < bytes.len() {
+            match bytes[self.pos] {
+                b' ' | b'\n' | b'\t' | b'\r' => self.pos += 1,
+                _ => break,
+            }
+        }
+    }
+
+    fn parse(&mut self) -> Result<Option<StreamEvent<'a>>, ErrorCode> {
+        loop {
+            self.parse_whitespace();
+            match self.state {
+                StreamState::StreamValue => return self.parse_value().map(Some),
+                StreamState::StreamArrayFirst => {
+                    if self.peek_byte() == Some(b']') {
+                        return Ok(Some(self.parse_end()));
+                    }
+                    return self.parse_value().map(Some);
+                }
+                StreamState::StreamObjectFirst => {
+                    if self.peek_byte() == Some(b'}') {
+                        return Ok(Some(self.parse_end()));
+                    }
+                    return self.parse_key().map(Some);
+                }
+                StreamState::StreamKey => {
+                    if self.peek_byte() == Some(b'}') {
+                        return Err(TrailingComma);
+                    }
+                    return self.parse_key().map(Some);
+                }
+                StreamState::StreamAfterValue => {
+                    let in_object = match self.stack.last() {
+                        Some(&in_object) => in_object,
+                        None => {
+                            // Make sure there is no trailing characters.
+                            if !self.nested && self.pos != self.src.len() {
+                                return Err(TrailingCharacters);
+                            }
+                            self.state = StreamState::StreamFinished;
+                            return Ok(None);
+                        }
+                    };
+                    match self.peek_byte() {
+                        Some(b',') => {
+                            self.pos += 1;
+                            self.state = if in_object {
+                                StreamState::StreamKey
+                            } else {
+                                StreamState::StreamValue
+                            };
+                        }
+                        Some(b']') if !in_object => return Ok(Some(self.parse_end())),
+                        Some(b'}') if in_object => return Ok(Some(self.parse_end())),
+                        None if in_object => return Err(EOFWhileParsingObject),
+                        None => return Err(EOFWhileParsingArray),
+                        _ => return Err(InvalidSyntax),
+                    }
+                }
+                StreamState::StreamFinished => return Ok(None),
+            }
+        }
+    }
+
+    // Consumes the ']' or '}' closing the innermost array or object.
+    fn parse_end(&mut self) -> StreamEvent<'a> {
+        self.pos += 1;
+        self.state = StreamState::StreamAfterValue;
+        if self.stack.pop().unwrap() {
+            StreamEvent::ObjectEnd
+        } else {
+            StreamEvent::ArrayEnd
+        }
+    }
+
+    fn parse_key(&mut self) -> Result<StreamEvent<'a>, ErrorCode> {
+        match self.peek_byte() {
+            Some(b'"') => {}
+            None => return Err(EOFWhileParsingObject),
+            _ => return Err(KeyMustBeAString),
+        }
+        let key = try!(self.parse_str());
+        self.parse_whitespace();
+        match self.peek_byte() {
+            Some(b':') => self.pos += 1,
+            None => return Err(EOFWhileParsingObject),
+            _ => return Err(ExpectedColon),
+        }
+        self.state = StreamState::StreamValue;
+        Ok(StreamEvent::Key(key))
+    }
+
+    fn parse_value(&mut self) -> Result<StreamEvent<'a>, ErrorCode> {
+        let c = match self.peek_byte() {
+            Some(c) => c,
+            None => return Err(EOFWhileParsingValue),
+        };
+        self.state = StreamState::StreamAfterValue;
+        match c {
+            b'n' => self.parse_ident("null", StreamEvent::NullValue),
+            b't' => self.parse_ident("true", StreamEvent::BooleanValue(true)),
+            b'f' => self.parse_ident("false", StreamEvent::BooleanValue(false)),
+            b'0' ... b'9' | b'-' => self.parse_number(),
+            b'"' => self.parse_str().map(StreamEvent::StringValue),
+            b'[' => {
+                self.pos += 1;
+                self.stack.push(false);
+                self.state = StreamState::StreamArrayFirst;
+                Ok(StreamEvent::ArrayStart)
+            }
+            b'{' => {
+                self.pos += 1;
+                self.stack.push(true);
+                self.state = StreamState::StreamObjectFirst;
+                Ok(StreamEvent::ObjectStart)
+            }
+            _ => Err(InvalidSyntax),
+        }
+    }
+
+    fn parse_ident(&mut self, ident: &str, value: StreamEvent<'a>)
+                   -> Result<StreamEvent<'a>, ErrorCode> {
+        if self.src.as_bytes()[self.pos..].starts_with(ident.as_bytes()) {
+            self.pos += ident.len();
+            Ok(value)
+        } else {
+            Err(InvalidSyntax)
+        }
+    }
+
+    fn parse_number(&mut self) -> Result<StreamEvent<'a>, ErrorCode> {
+        let src = self.src;
+        let bytes = src.as_bytes();
+        let start = self.pos;
+        let neg = bytes[start] == b'-';
+        let digits_start = if neg { start + 1 } else { start };
+        let is_digit = |i: usize| match bytes.get(i).cloned() {
+            Some(b'0' ... b'9') => true,
+            _ => false,
+        };
+
+        // A leading '0' must be the only digit before the decimal point.
+        let mut i = digits_start;
+        match bytes.get(i).cloned() {
+            Some(b'0') => {
+                i += 1;
+                if is_digit(i) {
+                    self.pos = i;
+                    return Err(InvalidNumber);
+                }
+            }
+            Some(b'1' ... b'9') => {
+                while is_digit(i) { i += 1; }
+            }
+            _ => {
+                self.pos = i;
+                return Err(InvalidNumber);
+            }
+        }
+        let int_end = i;
+
+        // Make sure a digit follows the decimal point and the exponent.
+        if bytes.get(i) == Some(&b'.') {
+            i += 1;
+            if !is_digit(i) {
+                self.pos = i;
+                return Err(InvalidNumber);
+            }
+            while is_digit(i) { i += 1; }
+        }
+        if bytes.get(i) == Some(&b'e') || bytes.get(i) == Some(&b'E') {
+            i += 1;
+            if bytes.get(i) == Some(&b'+') || bytes.get(i) == Some(&b'-') {
+                i += 1;
+            }
+            if !is_digit(i) {
+                self.pos = i;
+                return Err(InvalidNumber);
+            }
+            while is_digit(i) { i += 1; }
+        }
+        self.pos = i;
+
+        if i != int_end {
+            return Ok(StreamEvent::F64Value(float::parse(&bytes[start..i])));
+        }
+        let mut n = 0u64;
+        for &d in &bytes[digits_start..int_end] {
+            n = match n.checked_mul(10).and_then(|n| n.checked_add((d - b'0') as u64)) {
+                Some(n) => n,
+                None => return Err(InvalidNumber),
+            };
+        }
+        if !neg {
+            Ok(StreamEvent::U64Value(n))
+        } else if n <= i64::MAX as u64 + 1 {
+            Ok(StreamEvent::I64Value((n as i64).wrapping_neg()))
+        } else {
+            Err(InvalidNumber)
+        }
+    }
+
+    fn parse_str(&mut self) -> Result<Cow<'a, str>, ErrorCode> {
+        let src = self.src;
+        let bytes = src.as_bytes();
+        let start = self.pos + 1;
+
+        // The common case: no escapes, so the string is a slice of the
+        // input. '"' and '\\' are ASCII, so the slice is on char boundaries.
+        let mut i = start + scan::plain_run(&bytes[start..]);
+        match bytes.get(i) {
+            Some(&b'"') => {
+                self.pos = i + 1;
+                return Ok(Cow::Borrowed(&src[start..i]));
+            }
+            Some(_) => {}
+            None => {
+                self.pos = i;
+                return Err(EOFWhileParsingString);
+            }
+        }
+
+        let mut res = string::String::with_capacity(i - start + 16);
+        res.push_str(&src[start..i]);
+        loop {
+            match bytes.get(i) {
+                Some(&b'"') => {
+                    self.pos = i + 1;
+                    return Ok(Cow::Owned(res));
+                }
+                Some(&b'\\') => {
+                    self.pos = i + 1;
+                    let c = match bytes.get(i + 1) {
+                        Some(&b'"') => '"',
+                        Some(&b'\\') => '\\',
+                        Some(&b'/') => '/',
+                        Some(&b'b') => '\x08',
+                        Some(&b'f') => '\x0c',
+                        Some(&b'n') => '\n',
+                        Some(&b'r') => '\r',
+                        Some(&b't') => '\t',
+                        Some(&b'u') => {
+                            let (c, next) = try!(self.parse_unicode_escape(i + 2));
+                            res.push(c);
+                            i = next;
+                            continue;
+                        }
+                        None => return Err(EOFWhileParsingString),
+                        _ => return Err(InvalidEscape),
+                    };
+                    res.push(c);
+                    i += 2;
+                }
+                Some(_) => {
+                    let run = i;
+                    i += scan::plain_run(&bytes[i..]);
+                    res.push_str(&src[run..i]);
+                }
+                None => {
+                    self.pos = i;
+                    return Err(EOFWhileParsingString);
+                }
+            }
+        }
+    }
+
+    // Decodes the hex digits of a \u escape starting at `i`, and of the
+    // escape of the trailing surrogate, if any. Returns the character and
+    // the offset after the escapes.
+    fn parse_unicode_escape(&mut self, i: usize) -> Result<(char, usize), ErrorCode> {
+        let n1 = try!(self.decode_hex_escape(i));
+        match n1 {
+            0xDC00 ... 0xDFFF => Err(LoneLeadingSurrogateInHexEscape),
+
+            // Non-BMP characters are encoded as a sequence of
+            // two hex escapes, representing UTF-16 surrogates.
+            0xD800 ... 0xDBFF => {
+                let src = self.src;
+                let bytes = src.as_bytes();
+                if bytes.get(i + 4) != Some(&b'\\') || bytes.get(i + 5) != Some(&b'u') {
+                    self.pos = i + 4;
+                    return Err(UnexpectedEndOfHexEscape);
+                }
+                let buf = [n1, try!(self.decode_hex_escape(i + 6))];
+                match unicode_str::utf16_items(&buf).next() {
+                    Some(Utf16Item::ScalarValue(c)) => Ok((c, i + 10)),
+                    _ => Err(LoneLeadingSurrogateInHexEscape),
+                }
+            }
+
+            n => match char::from_u32(n as u32) {
+                Some(c) => Ok((c, i + 4)),
+                None => Err(InvalidUnicodeCodePoint),
+            },
+        }
+    }
+
+    fn decode_hex_escape(&mut self, i: usize) -> Result<u16, ErrorCode> {
+        let src = self.src;
+        let bytes = src.as_bytes();
+        let mut n = 0;
+        for j in i..i + 4 {
+            let digit = match bytes.get(j).cloned() {
+                Some(c @ b'0' ... b'9') => c - b'0',
+                Some(c @ b'a' ... b'f') => c - b'a' + 10,
+                Some(c @ b'A' ... b'F') => c - b'A' + 10,
+                _ => {
+                    self.pos = j;
+                    return Err(InvalidEscape);
+                }
+            };
+            n = n * 16 + digit as u16;
+        }
+        Ok(n)
+    }
+}
+
 /// A structure to decode JSON to values in rust.
 pub struct Decoder {
     stack: Vec<Json>,
@@ -2392,6 +2834,482 @@ impl ::Decoder for Decoder {
     }
 }
 
+/// Counts the elements of the array, or the members of the object, whose
+/// opening bracket ends at byte offset `pos` of `src`. Only brackets, commas
+/// and strings are looked at; the contents are validated as they are parsed.
+fn count_members(src: &str, mut pos: usize) -> usize {
+    let bytes = src.as_bytes();
+    let mut depth = 0;
+    let mut commas = 0;
+    let mut empty = true;
+    while pos < bytes.len() {
+        let c = bytes[pos];
+        pos += 1;
+        match c {
+            b'"' => {
+                while pos < bytes.len() {
+                    match bytes[pos] {
+                        b'\\' => pos += 2,
+                        b'"' => { pos += 1; break }
+                        _ => pos += 1,
+                    }
+                }
+            }
+            b'[' | b'{' => depth += 1,
+            b']' | b'}' => {
+                if depth == 0 {
+                    break;
+                }
+                depth -= 1;
+            }
+            b',' if depth == 0 => commas += 1,
+            b' ' | b'\n' | b'\t' | b'\r' => continue,
+            _ => {}
+        }
+        empty = false;
+    }
+    if empty { 0 } else { commas + 1 }
+}
+
+/// Describes the value starting with `evt`, for `ExpectedError`.
+fn describe_event(evt: &StreamEvent) -> string::String {
+    match *evt {
+        StreamEvent::ObjectStart => "{...}".to_string(),
+        StreamEvent::ObjectEnd => "}".to_string(),
+        StreamEvent::ArrayStart => "[...]".to_string(),
+        StreamEvent::ArrayEnd => "]".to_string(),
+        StreamEvent::Key(ref k) => format!("key {}", Json::String(k.to_string())),
+        StreamEvent::BooleanValue(b) => format!("{}", b),
+        StreamEvent::I64Value(n) => format!("{}", n),
+        StreamEvent::U64Value(n) => format!("{}", n),
+        StreamEvent::F64Value(f) => float::format(f).to_string(),
+        StreamEvent::StringValue(ref s) => format!("{}", Json::String(s.to_string())),
+        StreamEvent::NullValue => "null".to_string(),
+        StreamEvent::Error(ref e) => format!("{}", e),
+    }
+}
+
+/// A structure to decode JSON to values in rust straight from the events of
+/// a `StreamParser`, without building a `Json` value first.
+///
+/// Struct fields are usually found in the order they are read, as written
+/// by `Encoder`. A member which is not the field being read is skipped, and
+/// its position remembered in case a later field of the struct wants it.
+/// Arrays and maps are prescanned to count their elements.
+pub struct StreamDecoder<'a> {
+    parser: StreamParser<'a>,
+    // Events to hand out before the parser's, last first.
+    pending: Vec<StreamEvent<'a>>,
+    // For each struct being read, the members skipped so far, with the
+    // offsets of their values.
+    skipped: Vec<Vec<(Cow<'a, str>, usize)>>,
+}
+
+impl<'a> StreamDecoder<'a> {
+    /// Creates a new decoder for the JSON text `src`.
+    pub fn new(src: &'a str) -> StreamDecoder<'a> {
+        StreamDecoder {
+            parser: StreamParser::new(src),
+            pending: Vec::new(),
+            skipped: Vec::new(),
+        }
+    }
+
+    /// Checks that nothing but whitespace follows the decoded value.
+    pub fn finish(&mut self) -> DecodeResult<()> {
+        if let Some(evt) = self.pending.pop() {
+            return Err(ExpectedError("end of input".to_string(), describe_event(&evt)));
+        }
+        match self.parser.next() {
+            None => Ok(()),
+            Some(StreamEvent::Error(e)) => Err(ParseError(e)),
+            Some(_) => Err(ParseError(self.parser.syntax_error(TrailingCharacters))),
+        }
+    }
+
+    fn next_event(&mut self) -> DecodeResult<StreamEvent<'a>> {
+        if let Some(evt) = self.pending.pop() {
+            return Ok(evt);
+        }
+        match self.parser.next() {
+            Some(StreamEvent::Error(e)) => Err(ParseError(e)),
+            Some(evt) => Ok(evt),
+            None => Err(ParseError(self.parser.syntax_error(EOFWhileParsingValue))),
+        }
+    }
+
+    fn read_end(&mut self, array: bool) -> DecodeResult<()> {
+        match try!(self.next_event()) {
+            StreamEvent::ArrayEnd if array => Ok(()),
+            StreamEvent::ObjectEnd if !array => Ok(()),
+            evt => Err(ExpectedError((if array { "]" } else { "}" }).to_string(),
+                                     describe_event(&evt))),
+        }
+    }
+
+    fn read_key(&mut self, name: &str) -> DecodeResult<()> {
+        match try!(self.next_event()) {
+            StreamEvent::Key(ref key) if &**key == name => Ok(()),
+            StreamEvent::Key(_) | StreamEvent::ObjectEnd => {
+                Err(MissingFieldError(name.to_string()))
+            }
+            evt => Err(ExpectedError("Object".to_string(), describe_event(&evt))),
+        }
+    }
+
+    // Skips the rest of the value starting with `evt`.
+    fn skip_value(&mut self, evt: StreamEvent<'a>) -> DecodeResult<()> {
+        let mut depth = match evt {
+            StreamEvent::ArrayStart | StreamEvent::ObjectStart => 1,
+            _ => 0,
+        };
+        while depth > 0 {
+            match try!(self.next_event()) {
+                StreamEvent::ArrayStart | StreamEvent::ObjectStart => depth += 1,
+                StreamEvent::ArrayEnd | StreamEvent::ObjectEnd => depth -= 1,
+                _ => {}
+            }
+        }
+        Ok(())
+    }
+
+    // Decodes the value at byte offset `pos` of the input with `f`, then
+    // picks up where the parser left off.
+    fn read_value_at<T, F>(&mut self, pos: usize, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        let parser = StreamParser::value_at(self.parser.src, pos);
+        let parser = mem::replace(&mut self.parser, parser);
+        let pending = mem::replace(&mut self.pending, Vec::new());
+        let value = f(self);
+        self.parser = parser;
+        self.pending = pending;
+        value
+    }
+}
+
+macro_rules! read_stream_primitive {
+    ($name:ident, $ty:ty) => {
+        fn $name(&mut self) -> DecodeResult<$ty> {
+            match try!(self.next_event()) {
+                StreamEvent::I64Value(f) => Ok(f as $ty),
+                StreamEvent::U64Value(f) => Ok(f as $ty),
+                StreamEvent::F64Value(f) => {
+                    Err(ExpectedError("Integer".to_string(), format!("{}", f)))
+                }
+                // re: #12967.. a type w/ numeric keys (ie HashMap<usize, V> etc)
+                // is going to have a string here, as per JSON spec.
+                StreamEvent::StringValue(s) => match s.parse().ok() {
+                    Some(f) => Ok(f),
+                    None => Err(ExpectedError("Number".to_string(), s.into_owned())),
+                },
+                evt => Err(ExpectedError("Number".to_string(), describe_event(&evt))),
+            }
+        }
+    }
+}
+
+impl<'a> ::Decoder for StreamDecoder<'a> {
+    type Error = DecoderError;
+
+    fn read_nil(&mut self) -> DecodeResult<()> {
+        match try!(self.next_event()) {
+            StreamEvent::NullValue => Ok(()),
+            evt => Err(ExpectedError("Null".to_string(), describe_event(&evt))),
+        }
+    }
+
+    read_stream_primitive! { read_uint, usize }
+    read_stream_primitive! { read_u8, u8 }
+    read_stream_primitive! { read_u16, u16 }
+    read_stream_primitive! { read_u32, u32 }
+    read_stream_primitive! { read_u64, u64 }
+    read_stream_primitive! { read_int, isize }
+    read_stream_primitive! { read_i8, i8 }
+    read_stream_primitive! { read_i16, i16 }
+    read_stream_primitive! { read_i32, i32 }
+    read_stream_primitive! { read_i64, i64 }
+
+    fn read_f32(&mut self) -> DecodeResult<f32> { self.read_f64().map(|x| x as f32) }
+
+    fn read_f64(&mut self) -> DecodeResult<f64> {
+        match try!(self.next_event()) {
+            StreamEvent::I64Value(f) => Ok(f as f64),
+            StreamEvent::U64Value(f) => Ok(f as f64),
+            StreamEvent::F64Value(f) => Ok(f),
+            StreamEvent::StringValue(s) => match s.parse().ok() {
+                Some(f) => Ok(f),
+                None => Err(ExpectedError("Number".to_string(), s.into_owned())),
+            },
+            StreamEvent::NullValue => Ok(f64::NAN),
+            evt => Err(ExpectedError("Number".to_string(), describe_event(&evt))),
+        }
+    }
+
+    fn read_bool(&mut self) -> DecodeResult<bool> {
+        match try!(self.next_event()) {
+            StreamEvent::BooleanValue(b) => Ok(b),
+            evt => Err(ExpectedError("Boolean".to_string(), describe_event(&evt))),
+        }
+    }
+
+    fn read_char(&mut self) -> DecodeResult<char> {
+        let s = try!(self.read_str());
+        {
+            let mut it = s.chars();
+            match (it.next(), it.next()) {
+                // exactly one character
+                (Some(c), None) => return Ok(c),
+                _ => ()
+            }
+        }
+        Err(ExpectedError("single character string".to_string(), format!("{}", s)))
+    }
+
+    fn read_str(&mut self) -> DecodeResult<string::String> {
+        match try!(self.next_event()) {
+            StreamEvent::StringValue(s) => Ok(s.into_owned()),
+            evt => Err(ExpectedError("String".to_string(), describe_event(&evt))),
+        }
+    }
+
+    fn read_enum<T, F>(&mut self, _name: &str, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        f(self)
+    }
+
+    fn read_enum_variant<T, F>(&mut self, names: &[&str],
+                               mut f: F) -> DecodeResult<T>
+        where F: FnMut(&mut StreamDecoder<'a>, usize) -> DecodeResult<T>,
+    {
+        // Variants with fields are objects with the name and then the
+        // fields, in that order, as `Encoder` writes them.
+        let (name, has_fields) = match try!(self.next_event()) {
+            StreamEvent::StringValue(s) => (s, false),
+            StreamEvent::ObjectStart => {
+                try!(self.read_key("variant"));
+                let name = match try!(self.next_event()) {
+                    StreamEvent::StringValue(s) => s,
+                    evt => {
+                        return Err(ExpectedError("String".to_string(), describe_event(&evt)))
+                    }
+                };
+                try!(self.read_key("fields"));
+                match try!(self.next_event()) {
+                    StreamEvent::ArrayStart => {}
+                    evt => {
+                        return Err(ExpectedError("Array".to_string(), describe_event(&evt)))
+                    }
+                }
+                (name, true)
+            }
+            evt => {
+                return Err(ExpectedError("String or Object".to_string(), describe_event(&evt)))
+            }
+        };
+        let idx = match names.iter().position(|n| *n == &*name) {
+            Some(idx) => idx,
+            None => return Err(UnknownVariantError(name.into_owned()))
+        };
+        let value = try!(f(self, idx));
+        if has_fields {
+            try!(self.read_end(true));
+            try!(self.read_end(false));
+        }
+        Ok(value)
+    }
+
+    fn read_enum_variant_arg<T, F>(&mut self, _idx: usize, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        f(self)
+    }
+
+    fn read_enum_struct_variant<T, F>(&mut self, names: &[&str], f: F) -> DecodeResult<T> where
+        F: FnMut(&mut StreamDecoder<'a>, usize) -> DecodeResult<T>,
+    {
+        self.read_enum_variant(names, f)
+    }
+
+
+    fn read_enum_struct_variant_field<T, F>(&mut self,
+                                         _name: &str,
+                                         idx: usize,
+                                         f: F)
+                                         -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        self.read_enum_variant_arg(idx, f)
+    }
+
+    fn read_struct<T, F>(&mut self, _name: &str, _len: usize, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        match try!(self.next_event()) {
+            StreamEvent::ObjectStart => {}
+            evt => return Err(ExpectedError("Object".to_string(), describe_event(&evt))),
+        }
+        self.skipped.push(Vec::new());
+        let value = try!(f(self));
+        self.skipped.pop();
+
+        // Skip the members which are not fields.
+        loop {
+            match try!(self.next_event()) {
+                StreamEvent::Key(_) => {
+                    let evt = try!(self.next_event());
+                    try!(self.skip_value(evt));
+                }
+                StreamEvent::ObjectEnd => return Ok(value),
+                evt => return Err(ExpectedError("}".to_string(), describe_event(&evt))),
+            }
+        }
+    }
+
+    fn read_struct_field<T, F>(&mut self,
+                               name: &str,
+                               _idx: usize,
+                               f: F)
+                               -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        let skipped = self.skipped.last().and_then(|skipped| {
+            skipped.iter().find(|&&(ref key, _)| &**key == name).map(|&(_, pos)| pos)
+        });
+        if let Some(pos) = skipped {
+            return self.read_value_at(pos, f);
+        }
+
+        loop {
+            match try!(self.next_event()) {
+                StreamEvent::Key(key) => {
+                    if &*key == name {
+                        return f(self);
+                    }
+                    let pos = self.parser.pos;
+                    let evt = try!(self.next_event());
+                    try!(self.skip_value(evt));
+                    if let Some(skipped) = self.skipped.last_mut() {
+                        skipped.push((key, pos));
+                    }
+                }
+                StreamEvent::ObjectEnd => {
+                    // Add a Null and try to parse it as an Option<_>
+                    // to get None as a default value.
+                    self.pending.push(StreamEvent::ObjectEnd);
+                    self.pending.push(StreamEvent::NullValue);
+                    return match f(self) {
+                        Ok(x) => Ok(x),
+                        Err(_) => Err(MissingFieldError(name.to_string())),
+                    };
+                }
+                evt => return Err(ExpectedError("Object".to_string(), describe_event(&evt))),
+            }
+        }
+    }
+
+    fn read_tuple<T, F>(&mut self, tuple_len: usize, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        self.read_seq(move |d, len| {
+            if len == tuple_len {
+                f(d)
+            } else {
+                Err(ExpectedError(format!("Tuple{}", tuple_len), format!("Tuple{}", len)))
+            }
+        })
+    }
+
+    fn read_tuple_arg<T, F>(&mut self, idx: usize, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        self.read_seq_elt(idx, f)
+    }
+
+    fn read_tuple_struct<T, F>(&mut self,
+                               _name: &str,
+                               len: usize,
+                               f: F)
+                               -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        self.read_tuple(len, f)
+    }
+
+    fn read_tuple_struct_arg<T, F>(&mut self,
+                                   idx: usize,
+                                   f: F)
+                                   -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        self.read_tuple_arg(idx, f)
+    }
+
+    fn read_option<T, F>(&mut self, mut f: F) -> DecodeResult<T> where
+        F: FnMut(&mut StreamDecoder<'a>, bool) -> DecodeResult<T>,
+    {
+        match try!(self.next_event()) {
+            StreamEvent::NullValue => f(self, false),
+            evt => { self.pending.push(evt); f(self, true) }
+        }
+    }
+
+    fn read_seq<T, F>(&mut self, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>, usize) -> DecodeResult<T>,
+    {
+        match try!(self.next_event()) {
+            StreamEvent::ArrayStart => {}
+            evt => return Err(ExpectedError("Array".to_string(), describe_event(&evt))),
+        }
+        // The '[' is the last thing the parser read, even if the event was
+        // handed back by read_option.
+        let len = count_members(self.parser.src, self.parser.pos);
+        let value = try!(f(self, len));
+        try!(self.read_end(true));
+        Ok(value)
+    }
+
+    fn read_seq_elt<T, F>(&mut self, _idx: usize, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        f(self)
+    }
+
+    fn read_map<T, F>(&mut self, f: F) -> DecodeResult<T> where
+        F: FnOnce(&mut StreamDecoder<'a>, usize) -> DecodeResult<T>,
+    {
+        match try!(self.next_event()) {
+            StreamEvent::ObjectStart => {}
+            evt => return Err(ExpectedError("Object".to_string(), describe_event(&evt))),
+        }
+        let len = count_members(self.parser.src, self.parser.pos);
+        let value = try!(f(self, len));
+        try!(self.read_end(false));
+        Ok(value)
+    }
+
+    fn read_map_elt_key<T, F>(&mut self, _idx: usize, f: F) -> DecodeResult<T> where
+       F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        match try!(self.next_event()) {
+            StreamEvent::Key(key) => self.pending.push(StreamEvent::StringValue(key)),
+            evt => return Err(ExpectedError("Key".to_string(), describe_event(&evt))),
+        }
+        f(self)
+    }
+
+    fn read_map_elt_val<T, F>(&mut self, _idx: usize, f: F) -> DecodeResult<T> where
+       F: FnOnce(&mut StreamDecoder<'a>) -> DecodeResult<T>,
+    {
+        f(self)
+    }
+
+    fn error(&mut self, err: &str) -> DecoderError {
+        ApplicationError(err.to_string())
+    }
+}
+
 /// A trait for converting values to JSON
 pub trait ToJson {
     /// Converts the value of `self` to an instance of JSON
@@ -2617,7 +3535,9 @@ mod tests {
     use super::DecoderError::*;
     use super::JsonEvent::*;
     use super::{Json, from_str, DecodeResult, DecoderError, JsonEvent, Parser,
-                StackElement, Stack, Decoder, Encoder, EncoderError};
+                StackElement, Stack, Decoder, Encoder, EncoderError,
+                StreamEvent, StreamParser};
+    use std::borrow::Cow;
     use std::{i64, u64, f32, f64};
     use std::io::prelude::*;
     use std::collections::BTreeMap;
@@ -2729,6 +3649,21 @@ mod tests {
 
         assert_eq!(F64(f64::NEG_INFINITY).to_string(), "null");
         assert_eq!(F64(f64::NEG_INFINITY).pretty().to_string(), "null");
+
+        assert_eq!(F64(0.1 + 0.2).to_string(), "0.30000000000000004");
+        assert_eq!(F64(1e20).to_string(), "100000000000000000000.0");
+        assert_eq!(F64(1e21).to_string(), "1e21");
+        assert_eq!(F64(-2.5e-10).to_string(), "-2.5e-10");
+    }
+
+    #[test]
+    fn test_f64_roundtrip() {
+        for &v in &[0.1, 1.0 / 3.0, 1e23, -123.456e-100, 5e-324, f64::MAX, f64::MIN_POSITIVE] {
+            let s = F64(v).to_string();
+            assert_eq!(from_str(&s), Ok(F64(v)));
+            let d: f64 = super::decode_stream(&s).unwrap();
+            assert_eq!(d, v);
+        }
     }
 
     #[test]
@@ -2909,6 +3844,15 @@ mod tests {
         check_encoder_for_simple!('\u{10ffff}', "\"\u{10ffff}\"");
     }
 
+    #[test]
+    fn test_write_str_escapes() {
+        let s = "a run of plain text long enough to span words\u{1}\"more text, a \\ and \
+                 \u{e9}\u{7f}\n";
+        check_encoder_for_simple!(s.to_string(),
+                                  "\"a run of plain text long enough to span words\\u0001\\\"\
+                                   more text, a \\\\ and \u{e9}\\u007f\\n\"");
+    }
+
     #[test]
     fn test_trailing_characters() {
         assert_eq!(from_str("nulla"),  Err(SyntaxError(TrailingCharacters, 1, 5)));
@@ -2971,6 +3915,12 @@ mod tests {
         assert_eq!(from_str("0.4e-01"), Ok(F64(0.4e-01)));
         assert_eq!(from_str(" 3 "), Ok(U64(3)));
 
+        // Floats are correctly rounded, whatever their number of digits.
+        assert_eq!(from_str("0.30000000000000004"), Ok(F64(0.1 + 0.2)));
+        assert_eq!(from_str("2.2250738585072012e-308"), Ok(F64(f64::MIN_POSITIVE)));
+        assert_eq!(from_str("18446744073709551616.5"), Ok(F64(18446744073709551616.0)));
+        assert_eq!(from_str("1e400"), Ok(F64(f64::INFINITY)));
+
         assert_eq!(from_str("-9223372036854775808"), Ok(I64(i64::MIN)));
         assert_eq!(from_str("9223372036854775807"), Ok(U64(i64::MAX as u64)));
         assert_eq!(from_str("18446744073709551615"), Ok(U64(u64::MAX)));
@@ -3288,6 +4238,139 @@ mod tests {
                                 UnknownVariantError("C".to_string()));
     }
 
+    fn stream_events(src: &str) -> Vec<StreamEvent> {
+        StreamParser::new(src).collect()
+    }
+
+    #[test]
+    fn test_stream_parser() {
+        let src = r#"{ "foo": "bar", "a\nb": ["x\ty", -1, 2, 0.5, null, true, {}] }"#;
+        let events = stream_events(src);
+        assert_eq!(events, vec![
+            StreamEvent::ObjectStart,
+              StreamEvent::Key(Cow::Borrowed("foo")),
+              StreamEvent::StringValue(Cow::Borrowed("bar")),
+              StreamEvent::Key(Cow::Owned("a\nb".to_string())),
+              StreamEvent::ArrayStart,
+                StreamEvent::StringValue(Cow::Owned("x\ty".to_string())),
+                StreamEvent::I64Value(-1),
+                StreamEvent::U64Value(2),
+                StreamEvent::F64Value(0.5),
+                StreamEvent::NullValue,
+                StreamEvent::BooleanValue(true),
+                StreamEvent::ObjectStart,
+                StreamEvent::ObjectEnd,
+              StreamEvent::ArrayEnd,
+            StreamEvent::ObjectEnd,
+        ]);
+        match events[2] {
+            StreamEvent::StringValue(Cow::Borrowed(_)) => {}
+            ref evt => panic!("unescaped string was copied: {:?}", evt),
+        }
+        match events[3] {
+            StreamEvent::Key(Cow::Owned(_)) => {}
+            ref evt => panic!("escaped key was not unescaped: {:?}", evt),
+        }
+
+        assert_eq!(stream_events("\"\\uD834\\uDD1E \\u00e9\\\"\""),
+                   vec![StreamEvent::StringValue(Cow::Owned("\u{1D11E} \u{e9}\"".to_string()))]);
+        assert_eq!(stream_events("[18446744073709551615, -9223372036854775808, 1e2]"),
+                   vec![StreamEvent::ArrayStart,
+                        StreamEvent::U64Value(u64::MAX),
+                        StreamEvent::I64Value(i64::MIN),
+                        StreamEvent::F64Value(100.0),
+                        StreamEvent::ArrayEnd]);
+    }
+
+    fn last_stream_event(src: &str) -> StreamEvent {
+        stream_events(src).pop().unwrap()
+    }
+
+    #[test]
+    fn test_stream_parser_errors() {
+        let err = |reason, line, col| StreamEvent::Error(SyntaxError(reason, line, col));
+        assert_eq!(last_stream_event(""),           err(EOFWhileParsingValue,  1, 1));
+        assert_eq!(last_stream_event("[1,]"),       err(InvalidSyntax,         1, 4));
+        assert_eq!(last_stream_event("[1 2]"),      err(InvalidSyntax,         1, 4));
+        assert_eq!(last_stream_event("[1"),         err(EOFWhileParsingArray,  1, 3));
+        assert_eq!(last_stream_event("{1"),         err(KeyMustBeAString,      1, 2));
+        assert_eq!(last_stream_event("{\"a\" 1"),   err(ExpectedColon,         1, 6));
+        assert_eq!(last_stream_event("{\"a\":1,}"), err(TrailingComma,         1, 8));
+        assert_eq!(last_stream_event("{\"a\":1"),   err(EOFWhileParsingObject, 1, 7));
+        assert_eq!(last_stream_event("\"abc"),      err(EOFWhileParsingString, 1, 5));
+        assert_eq!(last_stream_event("\"\\x\""),    err(InvalidEscape,         1, 3));
+        assert_eq!(last_stream_event("\"\\u12\""),  err(InvalidEscape,         1, 6));
+        assert_eq!(last_stream_event("01"),         err(InvalidNumber,         1, 2));
+        assert_eq!(last_stream_event("1."),         err(InvalidNumber,         1, 3));
+        assert_eq!(last_stream_event("18446744073709551616"), err(InvalidNumber, 1, 21));
+        assert_eq!(last_stream_event("nul"),        err(InvalidSyntax,         1, 1));
+        assert_eq!(last_stream_event("[]\n  x"),    err(TrailingCharacters,    2, 3));
+    }
+
+    #[test]
+    fn test_decode_stream() {
+        let s = "{
+            \"inner\": [
+                { \"a\": null, \"b\": 2, \"c\": [\"abc\", \"xyz\"] }
+            ]
+        }";
+        let v: Outer = super::decode_stream(s).unwrap();
+        assert_eq!(v, super::decode(s).unwrap());
+
+        // fields out of order, and members which are not fields
+        let s = "{ \"extra\": {\"x\": [1, {}]}, \"c\": [\"a\\n\"], \"b\": 2, \"a\": null }";
+        let v: Inner = super::decode_stream(s).unwrap();
+        assert_eq!(v, Inner { a: (), b: 2, c: vec!["a\n".to_string()] });
+
+        let v: OptionData = super::decode_stream("{}").unwrap();
+        assert_eq!(v, OptionData { opt: None });
+        let v: OptionData = super::decode_stream("{ \"opt\": 10 }").unwrap();
+        assert_eq!(v, OptionData { opt: Some(10) });
+
+        let v: Animal = super::decode_stream("\"Dog\"").unwrap();
+        assert_eq!(v, Dog);
+        let s = "{\"variant\":\"Frog\",\"fields\":[\"Henry\",349]}";
+        let v: Animal = super::decode_stream(s).unwrap();
+        assert_eq!(v, Frog("Henry".to_string(), 349));
+
+        let s = "{\"a\": \"Dog\", \"b\": {\"variant\":\"Frog\",\
+                  \"fields\":[\"Henry\", 349]}}";
+        let mut map: BTreeMap<string::String, Animal> = super::decode_stream(s).unwrap();
+        assert_eq!(map.remove(&"a".to_string()), Some(Dog));
+        assert_eq!(map.remove(&"b".to_string()), Some(Frog("Henry".to_string(), 349)));
+
+        let v: Vec<(u8, Option<string::String>)> =
+            super::decode_stream("[[1, \"a\"], [2, null]]").unwrap();
+        assert_eq!(v, [(1, Some("a".to_string())), (2, None)]);
+        let v: Vec<Vec<f64>> = super::decode_stream("[[], [1, 2.5], [null]]").unwrap();
+        assert_eq!(v[1], [1.0, 2.5]);
+        assert!(v[2][0].is_nan());
+    }
+
+    fn check_stream_err<T: Decodable>(to_parse: &'static str, expected: DecoderError) {
+        match super::decode_stream::<T>(to_parse) {
+            Ok(_) => panic!("`{:?}` parsed & decoded ok, expecting error `{:?}`",
+                              to_parse, expected),
+            Err(e) => assert_eq!(e, expected),
+        }
+    }
+    #[test]
+    fn test_decode_stream_errors() {
+        check_stream_err::<DecodeStruct>("[]", ExpectedError("Object".to_string(),
+                                                             "[...]".to_string()));
+        check_stream_err::<DecodeStruct>("{\"x\": true, \"y\": true, \"z\": \"\", \"w\": []}",
+                                         ExpectedError("Number".to_string(), "true".to_string()));
+        check_stream_err::<DecodeStruct>("{\"x\": 1, \"y\": true, \"z\": \"\"}",
+                                         MissingFieldError("w".to_string()));
+        check_stream_err::<DecodeEnum>("{}", MissingFieldError("variant".to_string()));
+        check_stream_err::<DecodeEnum>("{\"variant\": \"C\", \"fields\": []}",
+                                       UnknownVariantError("C".to_string()));
+        check_stream_err::<Vec<u8>>("[1, 2] 3",
+                                    ParseError(SyntaxError(TrailingCharacters, 1, 8)));
+        check_stream_err::<Vec<u8>>("[1, 2",
+                                    ParseError(SyntaxError(EOFWhileParsingArray, 1, 6)));
+    }
+
     #[test]
     fn test_find(){
         let json_value = from_str("{\"dog\" : \"cat\"}").unwrap();
@@ -4021,4 +5104,109 @@ mod tests {
         let src = big_json();
         b.iter( || { let _ = from_str(&src); });
     }
+
+    #[derive(RustcDecodable)]
+    #[allow(dead_code)]
+    struct BigRecord {
+        a: Option<bool>,
+        b: Option<u64>,
+        c: Option<f64>,
+        d: Option<string::String>,
+        e: Option<Vec<u64>>,
+    }
+
+    fn big_json_records() -> string::String {
+        let mut src = "[\n".to_string();
+        for i in 0..500 {
+            src.push_str(&format!(r#"{{ "a": true, "b": null, "c": 3.1415, "d": "Hello world {}",
+                                     "e": [1,2,3] }},"#, i));
+        }
+        src.push_str("{}]");
+        return src;
+    }
+
+    #[bench]
+    fn bench_stream_parser_large(b: &mut Bencher) {
+        let src = big_json_records();
+        b.bytes = src.len() as u64;
+        b.iter( || StreamParser::new(&src).count());
+    }
+    #[bench]
+    fn bench_decode_large(b: &mut Bencher) {
+        let src = big_json_records();
+        b.bytes = src.len() as u64;
+        b.iter( || {
+            let records: Vec<BigRecord> = super::decode(&src).unwrap();
+            records
+        });
+    }
+    #[bench]
+    fn bench_decode_stream_large(b: &mut Bencher) {
+        let src = big_json_records();
+        b.bytes = src.len() as u64;
+        b.iter( || {
+            let records: Vec<BigRecord> = super::decode_stream(&src).unwrap();
+            records
+        });
+    }
+
+    fn number_json() -> string::String {
+        let mut x = 0x9e3779b97f4a7c15u64;
+        let mut src = "[\n".to_string();
+        for i in 0..2000 {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            let lat = (x >> 11) as f64 / (1u64 << 53) as f64 * 180.0 - 90.0;
+            src.push_str(&format!("[{}, {}.{:06}, {}e-{}]", F64(lat), x % 360, i, x % 100000,
+                                  x % 30));
+            src.push_str(if i < 1999 { ",\n" } else { "\n]" });
+        }
+        return src;
+    }
+
+    #[bench]
+    fn bench_parse_numbers(b: &mut Bencher) {
+        let src = number_json();
+        b.bytes = src.len() as u64;
+        b.iter( || { let _ = from_str(&src); });
+    }
+    #[bench]
+    fn bench_stream_parser_numbers(b: &mut Bencher) {
+        let src = number_json();
+        b.bytes = src.len() as u64;
+        b.iter( || StreamParser::new(&src).count());
+    }
+    #[bench]
+    fn bench_encode_numbers(b: &mut Bencher) {
+        let json = from_str(&number_json()).unwrap();
+        b.iter( || json.to_string());
+    }
+
+    fn log_records() -> Json {
+        let mut records = vec![];
+        for i in 0..500 {
+            let mut record = BTreeMap::new();
+            record.insert("level".to_string(), String("info".to_string()));
+            record.insert("target".to_string(), String("server::http::handler".to_string()));
+            record.insert("message".to_string(), String(format!(
+                "GET /api/v1/users/{}/sessions?expand=devices took {} ms, \
+                 user agent \"Mozilla/5.0 (X11; Linux x86_64)\"", i, i % 97)));
+            records.push(Object(record));
+        }
+        Array(records)
+    }
+
+    #[bench]
+    fn bench_encode_strings(b: &mut Bencher) {
+        let json = log_records();
+        b.bytes = json.to_string().len() as u64;
+        b.iter( || json.to_string());
+    }
+    #[bench]
+    fn bench_stream_parser_strings(b: &mut Bencher) {
+        let src = log_records().to_string();
+        b.bytes = src.len() as u64;
+        b.iter( || StreamParser::new(&src).count());
+    }
 }
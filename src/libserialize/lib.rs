@@ -49,6 +49,9 @@ pub use self::serialize::{Decoder, Encoder, Decodable, Encodable,
 
 mod serialize;
 mod collection_impls;
+mod float;
+#[doc(hidden)]
+pub mod scan;
 
 pub mod hex;
 pub mod json;
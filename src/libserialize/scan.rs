@@ -0,0 +1,143 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! Word-at-a-time scanning of runs of bytes.
+//!
+//! Most bytes of a string need no attention from the JSON encoder or
+//! decoder. The helpers here test a whole machine word of bytes at once, so
+//! that runs of them can be found, and copied, in bulk. The lexer in
+//! libsyntax builds its own runs from the same primitives.
+
+use std::mem;
+use std::usize;
+
+/// A word with the low bit of every byte set.
+pub const LO: usize = usize::MAX / 255;
+/// A word with the high bit of every byte set.
+pub const HI: usize = LO * 0x80;
+
+/// Returns a word with the high bit set in exactly those bytes of `x` that
+/// are zero.
+#[inline]
+pub fn zero_bytes(x: usize) -> usize {
+    !(((x & !HI) + !HI) | x) & HI
+}
+
+/// Returns a word with the high bit set in exactly those bytes of `x` that
+/// are equal to `b`.
+#[inline]
+pub fn eq_bytes(x: usize, b: u8) -> usize {
+    zero_bytes(x ^ (LO * b as usize))
+}
+
+/// Returns a word with the high bit set in exactly those bytes of `x` that
+/// are less than `n`, which must be at most 0x80.
+#[inline]
+pub fn lt_bytes(x: usize, n: u8) -> usize {
+    !((x & !HI) + LO * (0x80 - n as usize)) & !x & HI
+}
+
+/// Returns the length of the longest prefix of `s` whose bytes all satisfy
+/// `byte`. Aligned words are tested with `word`, which must return true only
+/// if `byte` holds for each of its bytes; the remainder is scanned bytewise.
+#[inline]
+pub fn run<W, B>(s: &[u8], word: W, byte: B) -> usize where
+    W: Fn(usize) -> bool,
+    B: Fn(u8) -> bool,
+{
+    let size = mem::size_of::<usize>();
+    let ptr = s.as_ptr();
+    let len = s.len();
+    let mut i = 0;
+    while i < len && (ptr as usize + i) % size != 0 {
+        if !byte(s[i]) { return i }
+        i += 1;
+    }
+    while i + size <= len {
+        let x = unsafe { *(ptr.offset(i as isize) as *const usize) };
+        if !word(x) { break }
+        i += size;
+    }
+    while i < len && byte(s[i]) { i += 1; }
+    i
+}
+
+/// Length of the leading run of bytes in `s` which the encoder writes out
+/// as they are: all but `"`, `\`, the control characters and DEL.
+pub fn clean_run(s: &[u8]) -> usize {
+    run(s,
+        |x| (lt_bytes(x, 0x20) | eq_bytes(x, b'"') | eq_bytes(x, b'\\') |
+             eq_bytes(x, 0x7f)) == 0,
+        |c| c >= 0x20 && c != b'"' && c != b'\\' && c != 0x7f)
+}
+
+/// Length of the leading run of bytes in `s` other than `"` and `\`, which
+/// the decoder copies as they are.
+pub fn plain_run(s: &[u8]) -> usize {
+    run(s,
+        |x| (eq_bytes(x, b'"') | eq_bytes(x, b'\\')) == 0,
+        |c| c != b'"' && c != b'\\')
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_clean_run() {
+        assert_eq!(clean_run(b""), 0);
+        assert_eq!(clean_run(b"\"abc"), 0);
+        assert_eq!(clean_run(b"abc\\"), 3);
+        assert_eq!(clean_run(b"a log message of some length\n"), 28);
+        assert_eq!(clean_run(b"tab\tseparated"), 3);
+        assert_eq!(clean_run(b"delete \x7f"), 7);
+        assert_eq!(clean_run(b"   \x1f"), 3);
+        assert_eq!(clean_run(b" !#~"), 4);
+        assert_eq!(clean_run("caf\u{e9} au lait, \u{2603}\"".as_bytes()), 18);
+    }
+
+    #[test]
+    fn test_plain_run() {
+        assert_eq!(plain_run(b""), 0);
+        assert_eq!(plain_run(b"abc\""), 3);
+        assert_eq!(plain_run(b"a longer string body, with \\n"), 27);
+        assert_eq!(plain_run(b"control \x01\x02 chars pass\""), 21);
+        assert_eq!(plain_run("caf\u{e9}\"".as_bytes()), 5);
+    }
+
+    #[test]
+    fn test_runs_at_every_alignment() {
+        let src = b"  \x10.............................................\"";
+        for start in 3..19 {
+            assert_eq!(clean_run(&src[start..]), src.len() - 1 - start);
+            assert_eq!(plain_run(&src[start..]), src.len() - 1 - start);
+        }
+        for start in 0..3 {
+            assert_eq!(clean_run(&src[start..]), 2 - start);
+            assert_eq!(plain_run(&src[start..]), src.len() - 1 - start);
+        }
+    }
+
+    #[test]
+    fn test_every_byte() {
+        for b in 0..256 {
+            let b = b as u8;
+            let mut s = [b'x'; 24];
+            for i in 0..s.len() {
+                s[i] = b;
+                let clean = b >= 0x20 && b != b'"' && b != b'\\' && b != 0x7f;
+                assert_eq!(clean_run(&s), if clean { s.len() } else { i });
+                let plain = b != b'"' && b != b'\\';
+                assert_eq!(plain_run(&s), if plain { s.len() } else { i });
+                s[i] = b'x';
+            }
+        }
+    }
+}
@@ -128,3 +128,184 @@ fn get_remove_insert(b: &mut Bencher) {
         k += 1;
     })
 }
+
+#[bench]
+fn find_existing_large(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    let mut m = HashMap::new();
+
+    for i in 0..100_000u64 {
+        m.insert(i, i);
+    }
+
+    b.iter(|| {
+        let mut found = 0;
+        for i in 0..100_000u64 {
+            found += m.contains_key(&i) as usize;
+        }
+        found
+    });
+}
+
+#[bench]
+fn find_nonexisting_large(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    let mut m = HashMap::new();
+
+    for i in 0..100_000u64 {
+        m.insert(i, i);
+    }
+
+    b.iter(|| {
+        let mut found = 0;
+        for i in 100_000..200_000u64 {
+            found += m.contains_key(&i) as usize;
+        }
+        found
+    });
+}
+
+#[bench]
+fn find_existing_strings(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    let keys: Vec<String> = (0..10_000).map(|i| format!("key number {}", i)).collect();
+    let mut m = HashMap::new();
+
+    for (i, k) in keys.iter().enumerate() {
+        m.insert(k.clone(), i);
+    }
+
+    b.iter(|| {
+        let mut found = 0;
+        for k in keys.iter() {
+            found += m.contains_key(&k[..]) as usize;
+        }
+        found
+    });
+}
+
+#[bench]
+fn find_after_churn(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    let mut m = HashMap::new();
+
+    for i in 0..10_000 {
+        m.insert(i, i);
+    }
+    // Leave the table full of removed buckets.
+    for i in 0..50_000 {
+        m.remove(&i);
+        m.insert(i + 10_000, i);
+    }
+
+    b.iter(|| {
+        let mut found = 0;
+        for i in 45_000..65_000 {
+            found += m.contains_key(&i) as usize;
+        }
+        found
+    });
+}
+
+#[bench]
+fn churn_at_high_load(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    // As full as the map gets without resizing, so that the removed buckets
+    // pile up quickly.
+    let mut m = HashMap::with_capacity(10_000);
+    let n = m.capacity();
+    for i in 0..n {
+        m.insert(i, i);
+    }
+
+    let mut k = 0;
+
+    b.iter(|| {
+        m.remove(&k);
+        m.insert(k + n, k);
+        k += 1;
+    });
+}
+
+#[bench]
+fn find_existing_large_mul_hasher(b: &mut Bencher) {
+    use super::map::HashMap;
+    use super::state::DefaultState;
+    use hash::MulHasher;
+
+    let mut m: HashMap<_, _, DefaultState<MulHasher>> = Default::default();
+
+    for i in 0..100_000u64 {
+        m.insert(i, i);
+    }
+
+    b.iter(|| {
+        let mut found = 0;
+        for i in 0..100_000u64 {
+            found += m.contains_key(&i) as usize;
+        }
+        found
+    });
+}
+
+#[bench]
+fn find_existing_strings_fnv_hasher(b: &mut Bencher) {
+    use super::map::HashMap;
+    use super::state::DefaultState;
+    use hash::FnvHasher;
+
+    let keys: Vec<String> = (0..10_000).map(|i| format!("key number {}", i)).collect();
+    let mut m: HashMap<_, _, DefaultState<FnvHasher>> = Default::default();
+
+    for (i, k) in keys.iter().enumerate() {
+        m.insert(k.clone(), i);
+    }
+
+    b.iter(|| {
+        let mut found = 0;
+        for k in keys.iter() {
+            found += m.contains_key(&k[..]) as usize;
+        }
+        found
+    });
+}
+
+#[bench]
+fn build_by_insertion(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    b.iter(|| {
+        let mut m = HashMap::new();
+        for i in 0..100_000u64 {
+            m.insert(i, i);
+        }
+        m
+    });
+}
+
+#[bench]
+fn build_by_extend(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    b.iter(|| {
+        let mut m = HashMap::new();
+        m.extend((0..100_000u64).map(|i| (i, i)));
+        m
+    });
+}
+
+#[bench]
+fn build_by_insert_batch(b: &mut Bencher) {
+    use super::map::HashMap;
+
+    b.iter(|| {
+        let mut m = HashMap::new();
+        m.insert_batch((0..100_000u64).map(|i| (i, i)));
+        m
+    });
+}
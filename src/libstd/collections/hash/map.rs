@@ -14,7 +14,7 @@ use self::VacantEntryState::*;
 
 use borrow::Borrow;
 use clone::Clone;
-use cmp::{max, Eq, PartialEq};
+use cmp::{max, Eq, PartialEq, Ord};
 use default::Default;
 use fmt::{self, Debug};
 use hash::{Hash, SipHasher};
@@ -25,10 +25,10 @@ use ops::{Deref, FnMut, FnOnce, Index};
 use option::Option::{self, Some, None};
 use rand::{self, Rng};
 use result::Result::{self, Ok, Err};
+use vec::Vec;
 
 use super::table::{
     self,
-    Bucket,
     EmptyBucket,
     FullBucket,
     FullBucketImm,
@@ -36,6 +36,9 @@ use super::table::{
     RawTable,
     SafeHash
 };
+#[cfg(not(swiss_table))]
+use super::table::Bucket;
+#[cfg(not(swiss_table))]
 use super::table::BucketState::{
     Empty,
     Full,
@@ -316,6 +319,7 @@ pub struct HashMap<K, V, S = RandomState> {
 }
 
 /// Search for a pre-hashed key.
+#[cfg(not(swiss_table))]
 fn search_hashed<K, V, M, F>(table: M,
                              hash: SafeHash,
                              mut is_match: F)
@@ -360,6 +364,22 @@ fn search_hashed<K, V, M, F>(table: M,
     TableRef(probe.into_table())
 }
 
+/// Search for a pre-hashed key.
+#[cfg(swiss_table)]
+fn search_hashed<K, V, M, F>(table: M,
+                             hash: SafeHash,
+                             is_match: F)
+                             -> SearchResult<K, V, M> where
+    M: Deref<Target=RawTable<K, V>>,
+    F: FnMut(&K) -> bool,
+{
+    match table::find(table, hash, is_match) {
+        Ok(full) => FoundExisting(full),
+        Err(table) => TableRef(table),
+    }
+}
+
+#[cfg(not(swiss_table))]
 fn pop_internal<K, V>(starting_bucket: FullBucketMut<K, V>) -> (K, V) {
     let (empty, retkey, retval) = starting_bucket.take();
     let mut gap = match empty.gap_peek() {
@@ -378,11 +398,18 @@ fn pop_internal<K, V>(starting_bucket: FullBucketMut<K, V>) -> (K, V) {
     (retkey, retval)
 }
 
+#[cfg(swiss_table)]
+fn pop_internal<K, V>(starting_bucket: FullBucketMut<K, V>) -> (K, V) {
+    let (_, retkey, retval) = starting_bucket.take();
+    (retkey, retval)
+}
+
 /// Perform robin hood bucket stealing at the given `bucket`. You must
 /// also pass the position of that bucket's initial bucket so we don't have
 /// to recalculate it.
 ///
 /// `hash`, `k`, and `v` are the elements to "robin hood" into the hashtable.
+#[cfg(not(swiss_table))]
 fn robin_hood<'a, K: 'a, V: 'a>(mut bucket: FullBucketMut<'a, K, V>,
                         mut ib: usize,
                         mut hash: SafeHash,
@@ -482,6 +509,7 @@ impl<K, V, S> HashMap<K, V, S>
     }
 
     // The caller should ensure that invariants by Robin Hood Hashing hold.
+    #[cfg(not(swiss_table))]
     fn insert_hashed_ordered(&mut self, hash: SafeHash, k: K, v: V) {
         let cap = self.table.capacity();
         let mut buckets = Bucket::new(&mut self.table, hash);
@@ -501,6 +529,13 @@ impl<K, V, S> HashMap<K, V, S>
         }
         panic!("Internal HashMap error: Out of space.");
     }
+
+    // Entries never move once put in the group probing table, so there is
+    // no order to keep.
+    #[cfg(swiss_table)]
+    fn insert_hashed_ordered(&mut self, hash: SafeHash, k: K, v: V) {
+        table::vacant(&mut self.table, hash).put(hash, k, v);
+    }
 }
 
 impl<K: Hash + Eq, V> HashMap<K, V, RandomState> {
@@ -644,6 +679,7 @@ impl<K, V, S> HashMap<K, V, S>
     ///   1) Make sure the new capacity is enough for all the elements, accounting
     ///      for the load factor.
     ///   2) Ensure new_capacity is a power of two or zero.
+    #[cfg(not(swiss_table))]
     fn resize(&mut self, new_capacity: usize) {
         assert!(self.table.size() <= new_capacity);
         assert!(new_capacity.is_power_of_two() || new_capacity == 0);
@@ -721,6 +757,22 @@ impl<K, V, S> HashMap<K, V, S>
         assert_eq!(self.table.size(), old_size);
     }
 
+    /// Resizes the internal vectors to a new capacity, as above.
+    #[cfg(swiss_table)]
+    fn resize(&mut self, new_capacity: usize) {
+        assert!(self.table.size() <= new_capacity);
+        assert!(new_capacity.is_power_of_two() || new_capacity == 0);
+
+        let old_table = replace(&mut self.table, RawTable::new(new_capacity));
+        let old_size = old_table.size();
+
+        for (h, k, v) in old_table.into_iter() {
+            self.insert_hashed_ordered(h, k, v);
+        }
+
+        assert_eq!(self.table.size(), old_size);
+    }
+
     /// Shrinks the capacity of the map as much as possible. It will drop
     /// down as much as possible while maintaining the internal rules
     /// and possibly leaving some space in accordance with the resize policy.
@@ -768,6 +820,7 @@ impl<K, V, S> HashMap<K, V, S>
         self.insert_or_replace_with(hash, k, v, |_, _, _| ())
     }
 
+    #[cfg(not(swiss_table))]
     fn insert_or_replace_with<'a, F>(&'a mut self,
                                      hash: SafeHash,
                                      k: K,
@@ -814,6 +867,27 @@ impl<K, V, S> HashMap<K, V, S>
         }
     }
 
+    #[cfg(swiss_table)]
+    fn insert_or_replace_with<'a, F>(&'a mut self,
+                                     hash: SafeHash,
+                                     k: K,
+                                     v: V,
+                                     mut found_existing: F)
+                                     -> &'a mut V where
+        F: FnMut(&mut K, &mut V, V),
+    {
+        let table = match table::find(&mut self.table, hash, |key| *key == k) {
+            Ok(bucket) => {
+                // Key already exists. Get its reference.
+                let (bucket_k, bucket_v) = bucket.into_mut_refs();
+                found_existing(bucket_k, bucket_v, v);
+                return bucket_v;
+            }
+            Err(table) => table
+        };
+        table::vacant(table, hash).put(hash, k, v).into_mut_refs().1
+    }
+
     /// An iterator visiting all keys in arbitrary order.
     /// Iterator element type is `&'a K`.
     ///
@@ -1105,6 +1179,54 @@ impl<K, V, S> HashMap<K, V, S>
         retval
     }
 
+    /// Inserts many key-value pairs into the map at once. This is the same
+    /// as `extend`, but faster for large batches: every key is hashed up
+    /// front, room is made for all of them with at most one resize, and they
+    /// are then inserted in the order of their place in the table, so that
+    /// the table is written from one end to the other rather than at random.
+    ///
+    /// The hashed batch is buffered in full while this runs. A key which
+    /// appears more than once keeps the value that came last.
+    ///
+    /// # Examples
+    ///
+    /// ```
+    /// # #![feature(std_misc)]
+    /// use std::collections::HashMap;
+    ///
+    /// let mut map = HashMap::new();
+    /// map.insert_batch((0..1000).map(|i| (i, i * 2)));
+    /// assert_eq!(map.len(), 1000);
+    /// assert_eq!(map[&500], 1000);
+    /// ```
+    #[unstable(feature = "std_misc",
+               reason = "recently added, may be folded into `extend`")]
+    pub fn insert_batch<I: IntoIterator<Item=(K, V)>>(&mut self, iter: I) {
+        let mut batch: Vec<(SafeHash, K, V)> = iter.into_iter().map(|(k, v)| {
+            (self.make_hash(&k), k, v)
+        }).collect();
+        if batch.is_empty() {
+            return;
+        }
+
+        self.reserve(batch.len());
+
+        // Both tables start probing for a hash at `hash & mask`. The sort is
+        // stable, so repeated keys are still inserted in their given order.
+        let mask = self.table.capacity() - 1;
+        batch.sort_by(|a, b| {
+            let a = a.0.inspect() as usize & mask;
+            let b = b.0.inspect() as usize & mask;
+            a.cmp(&b)
+        });
+
+        for (hash, k, v) in batch {
+            self.insert_or_replace_with(hash, k, v, |_, val_ref, val| {
+                *val_ref = val;
+            });
+        }
+    }
+
     /// Removes a key from the map, returning the value at the key if the key
     /// was previously in the map.
     ///
@@ -1134,6 +1256,7 @@ impl<K, V, S> HashMap<K, V, S>
     }
 }
 
+#[cfg(not(swiss_table))]
 fn search_entry_hashed<'a, K: Eq, V>(table: &'a mut RawTable<K,V>, hash: SafeHash, k: K)
         -> Entry<'a, K, V>
 {
@@ -1181,6 +1304,21 @@ fn search_entry_hashed<'a, K: Eq, V>(table: &'a mut RawTable<K,V>, hash: SafeHas
     }
 }
 
+#[cfg(swiss_table)]
+fn search_entry_hashed<'a, K: Eq, V>(table: &'a mut RawTable<K,V>, hash: SafeHash, k: K)
+        -> Entry<'a, K, V>
+{
+    let table = match table::find(table, hash, |key| *key == k) {
+        Ok(bucket) => return Occupied(OccupiedEntry { elem: bucket }),
+        Err(table) => table
+    };
+    Vacant(VacantEntry {
+        hash: hash,
+        key: k,
+        elem: NoElem(table::vacant(table, hash)),
+    })
+}
+
 impl<K, V, S> PartialEq for HashMap<K, V, S>
     where K: Eq + Hash, V: PartialEq, S: HashState
 {
@@ -1325,6 +1463,7 @@ pub enum Entry<'a, K: 'a, V: 'a> {
 enum VacantEntryState<K, V, M> {
     /// The index is occupied, but the key to insert has precedence,
     /// and will kick the current one out on insertion.
+    #[cfg(not(swiss_table))]
     NeqElem(FullBucket<K, V, M>, usize),
     /// The index is genuinely vacant.
     NoElem(EmptyBucket<K, V, M>),
@@ -1535,6 +1674,7 @@ impl<'a, K: 'a, V: 'a> VacantEntry<'a, K, V> {
     #[stable(feature = "rust1", since = "1.0.0")]
     pub fn insert(self, value: V) -> &'a mut V {
         match self.elem {
+            #[cfg(not(swiss_table))]
             NeqElem(bucket, ib) => {
                 robin_hood(bucket, ib, self.hash, self.key, value)
             }
@@ -1564,6 +1704,15 @@ impl<K, V, S> Extend<(K, V)> for HashMap<K, V, S>
     where K: Eq + Hash, S: HashState
 {
     fn extend<T: IntoIterator<Item=(K, V)>>(&mut self, iter: T) {
+        let iter = iter.into_iter();
+
+        // Keys which are already in the map take no more room, so only make
+        // room for half of them up front if there are keys here already. If
+        // the guess is short, the map still grows as it would have anyway.
+        let lower = iter.size_hint().0;
+        let additional = if self.is_empty() { lower } else { (lower + 1) / 2 };
+        self.reserve(additional);
+
         for (k, v) in iter {
             self.insert(k, v);
         }
@@ -2142,6 +2291,34 @@ mod test_map {
         }
     }
 
+    #[test]
+    fn test_extend() {
+        let mut map: HashMap<i32, i32> = HashMap::new();
+        map.extend((0..1000).map(|i| (i, i)));
+        assert!(map.capacity() >= 1000);
+
+        map.extend((0..1000).map(|i| (i, -i)));
+        assert_eq!(map.len(), 1000);
+        assert_eq!(map[&10], -10);
+    }
+
+    #[test]
+    fn test_insert_batch() {
+        let mut map = HashMap::new();
+        map.insert_batch(Vec::<(i32, i32)>::new());
+        assert!(map.is_empty());
+
+        map.insert(5000, 0);
+        map.insert(3, 0);
+        map.insert_batch((0..1000).map(|i| (i, i)).chain((0..10).map(|i| (i, -i))));
+        assert_eq!(map.len(), 1001);
+        for i in 0..1000 {
+            let v = if i < 10 { -i } else { i };
+            assert_eq!(map[&i], v);
+        }
+        assert_eq!(map[&5000], 0);
+    }
+
     #[test]
     fn test_size_hint() {
         let xs = [(1, 1), (2, 2), (3, 3), (4, 4), (5, 5), (6, 6)];
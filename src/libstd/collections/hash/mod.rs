@@ -11,6 +11,10 @@
 //! Unordered containers, implemented as hash-tables
 
 mod bench;
+#[cfg(not(swiss_table))]
+mod table;
+#[cfg(swiss_table)]
+#[path = "swiss_table.rs"]
 mod table;
 pub mod map;
 pub mod set;
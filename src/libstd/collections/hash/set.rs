@@ -607,9 +607,7 @@ impl<T, S> Extend<T> for HashSet<T, S>
           S: HashState,
 {
     fn extend<I: IntoIterator<Item=T>>(&mut self, iter: I) {
-        for k in iter {
-            self.insert(k);
-        }
+        self.map.extend(iter.into_iter().map(|k| (k, ())));
     }
 }
 
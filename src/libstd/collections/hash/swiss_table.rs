@@ -0,0 +1,925 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! An open addressing table which probes a group of buckets at a time.
+//!
+//! `HashMap` uses this table in place of the Robin Hood one in `table.rs`
+//! when built with `--cfg swiss_table` (`./configure --enable-swiss-table`).
+//! The design follows Google's "Swiss tables": besides its hash, key and
+//! value, each bucket has a control byte, which is `EMPTY_BUCKET`, `DELETED`
+//! or, for a full bucket, seven bits of its hash. A lookup loads a word's
+//! worth of consecutive control bytes, a *group*, and compares all of them
+//! with the byte it is after in a few instructions, so only the buckets
+//! which match have their hash and key looked at. Groups are probed
+//! quadratically, starting from the bucket the hash maps to, and a lookup
+//! is over at the first group with an empty bucket.
+//!
+//! Entries never move once put, so removal leaves a `DELETED` tombstone
+//! behind, unless no probe can have gone past the bucket. Tombstones keep
+//! lookups going; once there are too many of them, the table is rebuilt,
+//! and grows if it is more than half full.
+//!
+//! The control bytes of the first group are repeated after the last bucket,
+//! so that a group may start at any bucket.
+
+use clone::Clone;
+use cmp;
+use hash::{Hash, Hasher};
+use iter::{Iterator, ExactSizeIterator};
+use marker::{Copy, Send, Sync, Sized, self};
+use mem::{min_align_of, size_of};
+use mem;
+use ops::{Deref, DerefMut, Drop, FnMut};
+use option::Option::{self, Some, None};
+use ptr::{self, Unique};
+use result::Result::{self, Ok, Err};
+use rt::heap::{allocate, deallocate, EMPTY};
+use collections::hash_state::HashState;
+
+/// The control byte of a bucket which has never been full.
+const EMPTY_BUCKET: u8 = 0xff;
+/// The control byte of a bucket whose entry has been taken.
+const DELETED: u8 = 0x80;
+
+/// The number of buckets in a group.
+const GROUP: usize = ::usize::BYTES;
+
+const LO: usize = ::usize::MAX / 255;
+const HI: usize = LO * 0x80;
+
+/// The raw hashtable: the arrays of control bytes, hashes, keys and values,
+/// all in one allocation.
+///
+/// Essential invariants of this structure:
+///
+///   - The hash, key and value of bucket `i` are initialized exactly when
+///     its control byte has the high bit clear. `EmptyBucket` and
+///     `FullBucket` are only constructed for buckets in the right state.
+///
+///   - There are `capacity + GROUP` control bytes, and the last `GROUP` of
+///     them are the same as the first `GROUP`. `capacity` is zero or a power
+///     of two of at least `GROUP`.
+///
+///   - `size + deleted` is the number of buckets which are not empty. Lookups
+///     stop at an empty bucket, so some must always be left.
+#[unsafe_no_drop_flag]
+pub struct RawTable<K, V> {
+    capacity: usize,
+    size:     usize,
+    deleted:  usize,
+    ctrl:     Unique<u8>,
+
+    // Because K/V do not appear directly in any of the types in the struct,
+    // inform rustc that in fact instances of K and V are reachable from here.
+    marker:   marker::PhantomData<(K,V)>,
+}
+
+unsafe impl<K: Send, V: Send> Send for RawTable<K, V> {}
+unsafe impl<K: Sync, V: Sync> Sync for RawTable<K, V> {}
+
+struct RawBucket<K, V> {
+    hash: *mut u64,
+    key:  *mut K,
+    val:  *mut V,
+    _marker: marker::PhantomData<(K,V)>,
+}
+
+impl<K,V> Copy for RawBucket<K,V> {}
+impl<K,V> Clone for RawBucket<K,V> {
+    fn clone(&self) -> RawBucket<K, V> { *self }
+}
+
+pub struct EmptyBucket<K, V, M> {
+    raw:   RawBucket<K, V>,
+    idx:   usize,
+    table: M
+}
+
+pub struct FullBucket<K, V, M> {
+    raw:   RawBucket<K, V>,
+    idx:   usize,
+    table: M
+}
+
+pub type  FullBucketImm<'table, K, V> =  FullBucket<K, V, &'table RawTable<K, V>>;
+pub type  FullBucketMut<'table, K, V> =  FullBucket<K, V, &'table mut RawTable<K, V>>;
+
+/// A hash with the most significant bit set, as for the Robin Hood table.
+#[derive(PartialEq, Copy, Clone)]
+pub struct SafeHash {
+    hash: u64,
+}
+
+impl SafeHash {
+    /// Peek at the hash value, which is guaranteed to be non-zero.
+    #[inline(always)]
+    pub fn inspect(&self) -> u64 { self.hash }
+}
+
+/// This function wraps up `hash_keyed` to be the only way outside this
+/// module to generate a SafeHash.
+pub fn make_hash<T: ?Sized, S>(hash_state: &S, t: &T) -> SafeHash
+    where T: Hash, S: HashState
+{
+    let mut state = hash_state.hasher();
+    t.hash(&mut state);
+    SafeHash { hash: 0x8000_0000_0000_0000 | state.finish() }
+}
+
+/// The control byte of a full bucket holding `hash`: the seven bits below
+/// the always set MSB, which only pick the bucket in enormous tables.
+#[inline]
+fn h2(hash: SafeHash) -> u8 {
+    (hash.inspect() >> 56) as u8 & 0x7f
+}
+
+/// The control bytes of `GROUP` consecutive buckets, in a word whose byte
+/// `i`, counting from the least significant, belongs to the `i`th bucket.
+#[derive(Copy, Clone)]
+struct Group(usize);
+
+impl Group {
+    #[inline]
+    unsafe fn load(ctrl: *const u8) -> Group {
+        let mut word = 0;
+        ptr::copy_nonoverlapping(ctrl, &mut word as *mut usize as *mut u8, GROUP);
+        Group(usize::from_le(word))
+    }
+
+    /// The full buckets whose control byte is `byte`.
+    #[inline]
+    fn matches(self, byte: u8) -> BitMask {
+        let x = self.0 ^ (LO * byte as usize);
+        BitMask(!(((x & !HI) + !HI) | x) & HI)
+    }
+
+    /// The empty buckets: those with both of the top two bits set.
+    #[inline]
+    fn empty(self) -> BitMask {
+        BitMask(self.0 & (self.0 << 1) & HI)
+    }
+
+    /// The empty and deleted buckets: those with the top bit set.
+    #[inline]
+    fn empty_or_deleted(self) -> BitMask {
+        BitMask(self.0 & HI)
+    }
+}
+
+/// A set of buckets of a group, as the top bits of their bytes. Iterating
+/// over it yields their positions in the group, in increasing order.
+struct BitMask(usize);
+
+impl BitMask {
+    /// The number of buckets before the first one in the set.
+    #[inline]
+    fn leading(&self) -> usize {
+        self.0.trailing_zeros() as usize / 8
+    }
+
+    /// The number of buckets after the last one in the set.
+    #[inline]
+    fn trailing(&self) -> usize {
+        self.0.leading_zeros() as usize / 8
+    }
+}
+
+impl Iterator for BitMask {
+    type Item = usize;
+
+    #[inline]
+    fn next(&mut self) -> Option<usize> {
+        if self.0 == 0 {
+            return None;
+        }
+        let i = self.leading();
+        self.0 &= self.0 - 1;
+        Some(i)
+    }
+}
+
+/// The sequence of groups to probe for a hash. Each step moves one group
+/// further than the last, which for a power of two number of buckets covers
+/// all of them before repeating.
+struct ProbeSeq {
+    pos: usize,
+    stride: usize,
+    mask: usize,
+}
+
+impl ProbeSeq {
+    #[inline]
+    fn new(hash: SafeHash, capacity: usize) -> ProbeSeq {
+        let mask = capacity - 1;
+        ProbeSeq { pos: hash.inspect() as usize & mask, stride: 0, mask: mask }
+    }
+
+    /// Moves to the next group. Returns false, instead, if every bucket has
+    /// been in a group already.
+    #[inline]
+    fn next(&mut self) -> bool {
+        self.stride += GROUP;
+        if self.stride > self.mask {
+            return false;
+        }
+        self.pos = (self.pos + self.stride) & self.mask;
+        true
+    }
+}
+
+impl<K, V> RawBucket<K, V> {
+    unsafe fn offset(self, count: isize) -> RawBucket<K, V> {
+        RawBucket {
+            hash: self.hash.offset(count),
+            key:  self.key.offset(count),
+            val:  self.val.offset(count),
+            _marker: marker::PhantomData,
+        }
+    }
+}
+
+/// Looks for the full bucket with the given hash whose key satisfies
+/// `is_match`. The table is handed back if there is none.
+pub fn find<K, V, M, F>(table: M, hash: SafeHash, mut is_match: F)
+                        -> Result<FullBucket<K, V, M>, M> where
+    M: Deref<Target=RawTable<K, V>>,
+    F: FnMut(&K) -> bool,
+{
+    if table.capacity() == 0 {
+        return Err(table);
+    }
+
+    let byte = h2(hash);
+    let first = table.first_bucket_raw();
+    let mut probe = ProbeSeq::new(hash, table.capacity());
+    loop {
+        let group = unsafe { table.group(probe.pos) };
+        for i in group.matches(byte) {
+            let idx = (probe.pos + i) & probe.mask;
+            let raw = unsafe { first.offset(idx as isize) };
+            if unsafe { *raw.hash } == hash.inspect() && is_match(unsafe { &*raw.key }) {
+                return Ok(FullBucket { raw: raw, idx: idx, table: table });
+            }
+        }
+        if group.empty().0 != 0 || !probe.next() {
+            return Err(table);
+        }
+    }
+}
+
+/// Finds an empty bucket to put an entry with the given hash into. The key
+/// must not be in the table already, and the table must have room for one
+/// more entry.
+pub fn vacant<K, V, M>(mut table: M, hash: SafeHash) -> EmptyBucket<K, V, M> where
+    M: Deref<Target=RawTable<K, V>> + DerefMut,
+{
+    let mut idx = table.insert_index(hash);
+    // Reusing a tombstone is free. Filling an empty bucket, though, must
+    // leave a sixteenth of them empty, for lookups to stop at. A table more
+    // than half full would soon gather as many tombstones again, and rebuild
+    // every few inserts under churn, so it grows instead.
+    if table.deleted > 0 && unsafe { table.ctrl_byte(idx) } == EMPTY_BUCKET &&
+       table.size + table.deleted >= table.capacity - table.capacity / 16 {
+        let capacity = if table.size > table.capacity / 2 {
+            table.capacity.checked_mul(2).expect("capacity overflow")
+        } else {
+            table.capacity
+        };
+        table.rebuild(capacity);
+        idx = table.insert_index(hash);
+    }
+    EmptyBucket {
+        raw: unsafe { table.first_bucket_raw().offset(idx as isize) },
+        idx: idx,
+        table: table
+    }
+}
+
+impl<K, V, M: Deref<Target=RawTable<K, V>> + DerefMut> EmptyBucket<K, V, M> {
+    /// Puts given key and value pair, along with the key's hash,
+    /// into this bucket in the hashtable. Note how `self` is 'moved' into
+    /// this function, because this slot will no longer be empty when
+    /// we return! A `FullBucket` is returned for later use, pointing to
+    /// the newly-filled slot in the hashtable.
+    ///
+    /// Use `make_hash` to construct a `SafeHash` to pass to this function.
+    pub fn put(mut self, hash: SafeHash, key: K, value: V)
+               -> FullBucket<K, V, M> {
+        unsafe {
+            *self.raw.hash = hash.inspect();
+            ptr::write(self.raw.key, key);
+            ptr::write(self.raw.val, value);
+
+            if self.table.ctrl_byte(self.idx) == DELETED {
+                self.table.deleted -= 1;
+            }
+            self.table.set_ctrl(self.idx, h2(hash));
+        }
+
+        self.table.size += 1;
+
+        FullBucket { raw: self.raw, idx: self.idx, table: self.table }
+    }
+}
+
+impl<K, V, M: Deref<Target=RawTable<K, V>>> FullBucket<K, V, M> {
+    /// Gets references to the key and value at a given index.
+    pub fn read(&self) -> (&K, &V) {
+        unsafe {
+            (&*self.raw.key,
+             &*self.raw.val)
+        }
+    }
+}
+
+impl<K, V, M: Deref<Target=RawTable<K, V>> + DerefMut> FullBucket<K, V, M> {
+    /// Removes this bucket's key and value from the hashtable.
+    ///
+    /// The bucket is marked empty if every group it is in has an empty
+    /// bucket too, as then no probe can have been past it. Otherwise it
+    /// becomes a tombstone.
+    pub fn take(mut self) -> (EmptyBucket<K, V, M>, K, V) {
+        self.table.size -= 1;
+
+        unsafe {
+            let mask = self.table.capacity - 1;
+            let before = self.table.group(self.idx.wrapping_sub(GROUP) & mask).empty();
+            let after = self.table.group(self.idx).empty();
+            if before.trailing() + after.leading() < GROUP {
+                self.table.set_ctrl(self.idx, EMPTY_BUCKET);
+            } else {
+                self.table.set_ctrl(self.idx, DELETED);
+                self.table.deleted += 1;
+            }
+
+            (
+                EmptyBucket {
+                    raw: self.raw,
+                    idx: self.idx,
+                    table: self.table
+                },
+                ptr::read(self.raw.key),
+                ptr::read(self.raw.val)
+            )
+        }
+    }
+
+    /// Gets mutable references to the key and value at a given index.
+    pub fn read_mut(&mut self) -> (&mut K, &mut V) {
+        unsafe {
+            (&mut *self.raw.key,
+             &mut *self.raw.val)
+        }
+    }
+}
+
+impl<'t, K, V, M: Deref<Target=RawTable<K, V>> + 't> FullBucket<K, V, M> {
+    /// Exchange a bucket state for immutable references into the table.
+    /// Because the underlying reference to the table is also consumed,
+    /// no further changes to the structure of the table are possible;
+    /// in exchange for this, the returned references have a longer lifetime
+    /// than the references returned by `read()`.
+    pub fn into_refs(self) -> (&'t K, &'t V) {
+        unsafe {
+            (&*self.raw.key,
+             &*self.raw.val)
+        }
+    }
+}
+
+impl<'t, K, V, M: Deref<Target=RawTable<K, V>> + DerefMut + 't> FullBucket<K, V, M> {
+    /// This works similarly to `into_refs`, exchanging a bucket state
+    /// for mutable references into the table.
+    pub fn into_mut_refs(self) -> (&'t mut K, &'t mut V) {
+        unsafe {
+            (&mut *self.raw.key,
+             &mut *self.raw.val)
+        }
+    }
+}
+
+/// Rounds up to a multiple of a power of two. Returns the closest multiple
+/// of `target_alignment` that is higher or equal to `unrounded`.
+///
+/// # Panics
+///
+/// Panics if `target_alignment` is not a power of two.
+fn round_up_to_next(unrounded: usize, target_alignment: usize) -> usize {
+    assert!(target_alignment.is_power_of_two());
+    (unrounded + target_alignment - 1) & !(target_alignment - 1)
+}
+
+// Returns a tuple of (hashes_offset, keys_offset, vals_offset, size) for
+// an allocation of `capacity` buckets. The control bytes come first.
+fn calculate_offsets(capacity: usize,
+                     keys_size: usize, keys_align: usize,
+                     vals_size: usize, vals_align: usize)
+                     -> (usize, usize, usize, usize) {
+    let hashes_offset = round_up_to_next(capacity + GROUP, min_align_of::<u64>());
+    let end_of_hashes = hashes_offset + capacity * size_of::<u64>();
+    let keys_offset = round_up_to_next(end_of_hashes, keys_align);
+    let vals_offset = round_up_to_next(keys_offset + capacity * keys_size, vals_align);
+
+    (hashes_offset, keys_offset, vals_offset, vals_offset + capacity * vals_size)
+}
+
+impl<K, V> RawTable<K, V> {
+    /// Does not initialize the buckets. The caller should ensure they,
+    /// at the very least, set every control byte.
+    unsafe fn new_uninitialized(capacity: usize) -> RawTable<K, V> {
+        if capacity == 0 {
+            return RawTable {
+                size: 0,
+                capacity: 0,
+                deleted: 0,
+                ctrl: Unique::new(EMPTY as *mut u8),
+                marker: marker::PhantomData,
+            };
+        }
+        assert!(capacity.is_power_of_two() && capacity >= GROUP);
+
+        // One check for overflow that covers calculation and rounding of
+        // every offset, as no array is padded by `align` bytes or more.
+        let align = RawTable::<K, V>::align();
+        let size_of_bucket = size_of::<u64>().checked_add(size_of::<K>()).unwrap()
+                                             .checked_add(size_of::<V>()).unwrap()
+                                             .checked_add(1).unwrap();
+        capacity.checked_mul(size_of_bucket)
+                .and_then(|size| size.checked_add(GROUP + 3 * align))
+                .expect("capacity overflow");
+
+        let (_, _, _, size) = calculate_offsets(capacity,
+                                                size_of::<K>(), min_align_of::<K>(),
+                                                size_of::<V>(), min_align_of::<V>());
+        let buffer = allocate(size, align);
+        if buffer.is_null() { ::alloc::oom() }
+
+        RawTable {
+            capacity: capacity,
+            size:     0,
+            deleted:  0,
+            ctrl:     Unique::new(buffer),
+            marker:   marker::PhantomData,
+        }
+    }
+
+    fn align() -> usize {
+        cmp::max(min_align_of::<u64>(), cmp::max(min_align_of::<K>(), min_align_of::<V>()))
+    }
+
+    fn first_bucket_raw(&self) -> RawBucket<K, V> {
+        let (hashes_offset, keys_offset, vals_offset, _) =
+            calculate_offsets(self.capacity,
+                              size_of::<K>(), min_align_of::<K>(),
+                              size_of::<V>(), min_align_of::<V>());
+        let buffer = *self.ctrl;
+        unsafe {
+            RawBucket {
+                hash: buffer.offset(hashes_offset as isize) as *mut u64,
+                key:  buffer.offset(keys_offset as isize) as *mut K,
+                val:  buffer.offset(vals_offset as isize) as *mut V,
+                _marker: marker::PhantomData,
+            }
+        }
+    }
+
+    /// Creates a new raw table from a given capacity. All buckets are
+    /// initially empty.
+    pub fn new(capacity: usize) -> RawTable<K, V> {
+        unsafe {
+            let mut ret = RawTable::new_uninitialized(capacity);
+            ret.clear_ctrl();
+            ret
+        }
+    }
+
+    /// The hashtable's capacity, similar to a vector's.
+    pub fn capacity(&self) -> usize {
+        self.capacity
+    }
+
+    /// The number of elements ever `put` in the hashtable, minus the number
+    /// of elements ever `take`n.
+    pub fn size(&self) -> usize {
+        self.size
+    }
+
+    #[inline]
+    unsafe fn ctrl_byte(&self, idx: usize) -> u8 {
+        *self.ctrl.offset(idx as isize)
+    }
+
+    /// The group starting at bucket `idx`.
+    #[inline]
+    unsafe fn group(&self, idx: usize) -> Group {
+        Group::load(self.ctrl.offset(idx as isize))
+    }
+
+    /// Sets the control byte of bucket `idx`, and of its copy past the last
+    /// bucket, if it has one.
+    #[inline]
+    unsafe fn set_ctrl(&mut self, idx: usize, byte: u8) {
+        let mirror = (idx.wrapping_sub(GROUP) & (self.capacity - 1)) + GROUP;
+        *self.ctrl.offset(idx as isize) = byte;
+        *self.ctrl.offset(mirror as isize) = byte;
+    }
+
+    /// Marks every bucket empty.
+    unsafe fn clear_ctrl(&mut self) {
+        if self.capacity != 0 {
+            ptr::write_bytes(*self.ctrl, EMPTY_BUCKET, self.capacity + GROUP);
+        }
+        self.deleted = 0;
+    }
+
+    /// The first empty or deleted bucket in the probe sequence of `hash`.
+    fn insert_index(&self, hash: SafeHash) -> usize {
+        let mut probe = ProbeSeq::new(hash, self.capacity);
+        loop {
+            let group = unsafe { self.group(probe.pos) };
+            if let Some(i) = group.empty_or_deleted().next() {
+                return (probe.pos + i) & probe.mask;
+            }
+            assert!(probe.next(), "Internal HashMap error: Out of space.");
+        }
+    }
+
+    /// Moves every entry into a new table of the given capacity, which
+    /// leaves all the tombstones behind.
+    fn rebuild(&mut self, capacity: usize) {
+        let old_table = mem::replace(self, RawTable::new(capacity));
+        for (hash, k, v) in old_table.into_iter() {
+            let idx = self.insert_index(hash);
+            EmptyBucket {
+                raw: unsafe { self.first_bucket_raw().offset(idx as isize) },
+                idx: idx,
+                table: &mut *self
+            }.put(hash, k, v);
+        }
+    }
+
+    fn raw_buckets(&self) -> RawBuckets<K, V> {
+        RawBuckets {
+            first: self.first_bucket_raw(),
+            ctrl: *self.ctrl,
+            idx: 0,
+            end: self.capacity,
+            marker: marker::PhantomData,
+        }
+    }
+
+    pub fn iter(&self) -> Iter<K, V> {
+        Iter {
+            iter: self.raw_buckets(),
+            elems_left: self.size(),
+        }
+    }
+
+    pub fn iter_mut(&mut self) -> IterMut<K, V> {
+        IterMut {
+            iter: self.raw_buckets(),
+            elems_left: self.size(),
+        }
+    }
+
+    pub fn into_iter(self) -> IntoIter<K, V> {
+        let RawBuckets { first, ctrl, idx, end, .. } = self.raw_buckets();
+        // Replace the marker regardless of lifetime bounds on parameters.
+        IntoIter {
+            iter: RawBuckets {
+                first: first,
+                ctrl: ctrl,
+                idx: idx,
+                end: end,
+                marker: marker::PhantomData,
+            },
+            table: self,
+        }
+    }
+
+    pub fn drain(&mut self) -> Drain<K, V> {
+        let RawBuckets { first, ctrl, idx, end, .. } = self.raw_buckets();
+        // Replace the marker regardless of lifetime bounds on parameters.
+        Drain {
+            iter: RawBuckets {
+                first: first,
+                ctrl: ctrl,
+                idx: idx,
+                end: end,
+                marker: marker::PhantomData,
+            },
+            table: self,
+        }
+    }
+}
+
+/// A raw iterator over the full buckets, and their indices. The basis for
+/// the other iterators in this module.
+struct RawBuckets<'a, K, V> {
+    first: RawBucket<K, V>,
+    ctrl: *const u8,
+    idx: usize,
+    end: usize,
+
+    // As in `table.rs`, `&'a (K,V)` would need `K: 'a`, which does not
+    // hold for the move iterations using `RawBuckets<'static, ..>`.
+    marker: marker::PhantomData<&'a ()>,
+}
+
+// FIXME(#19839) Remove in favor of `#[derive(Clone)]`
+impl<'a, K, V> Clone for RawBuckets<'a, K, V> {
+    fn clone(&self) -> RawBuckets<'a, K, V> {
+        RawBuckets {
+            first: self.first,
+            ctrl: self.ctrl,
+            idx: self.idx,
+            end: self.end,
+            marker: marker::PhantomData,
+        }
+    }
+}
+
+impl<'a, K, V> Iterator for RawBuckets<'a, K, V> {
+    type Item = (usize, RawBucket<K, V>);
+
+    fn next(&mut self) -> Option<(usize, RawBucket<K, V>)> {
+        while self.idx != self.end {
+            let idx = self.idx;
+            self.idx += 1;
+            unsafe {
+                if *self.ctrl.offset(idx as isize) & 0x80 == 0 {
+                    return Some((idx, self.first.offset(idx as isize)));
+                }
+            }
+        }
+
+        None
+    }
+}
+
+/// Iterator over shared references to entries in a table.
+pub struct Iter<'a, K: 'a, V: 'a> {
+    iter: RawBuckets<'a, K, V>,
+    elems_left: usize,
+}
+
+// FIXME(#19839) Remove in favor of `#[derive(Clone)]`
+impl<'a, K, V> Clone for Iter<'a, K, V> {
+    fn clone(&self) -> Iter<'a, K, V> {
+        Iter {
+            iter: self.iter.clone(),
+            elems_left: self.elems_left
+        }
+    }
+}
+
+/// Iterator over mutable references to entries in a table.
+pub struct IterMut<'a, K: 'a, V: 'a> {
+    iter: RawBuckets<'a, K, V>,
+    elems_left: usize,
+}
+
+/// Iterator over the entries in a table, consuming the table.
+pub struct IntoIter<K, V> {
+    table: RawTable<K, V>,
+    iter: RawBuckets<'static, K, V>
+}
+
+/// Iterator over the entries in a table, clearing the table.
+pub struct Drain<'a, K: 'a, V: 'a> {
+    table: &'a mut RawTable<K, V>,
+    iter: RawBuckets<'static, K, V>,
+}
+
+impl<'a, K, V> Iterator for Iter<'a, K, V> {
+    type Item = (&'a K, &'a V);
+
+    fn next(&mut self) -> Option<(&'a K, &'a V)> {
+        self.iter.next().map(|(_, bucket)| {
+            self.elems_left -= 1;
+            unsafe {
+                (&*bucket.key,
+                 &*bucket.val)
+            }
+        })
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.elems_left, Some(self.elems_left))
+    }
+}
+impl<'a, K, V> ExactSizeIterator for Iter<'a, K, V> {
+    fn len(&self) -> usize { self.elems_left }
+}
+
+impl<'a, K, V> Iterator for IterMut<'a, K, V> {
+    type Item = (&'a K, &'a mut V);
+
+    fn next(&mut self) -> Option<(&'a K, &'a mut V)> {
+        self.iter.next().map(|(_, bucket)| {
+            self.elems_left -= 1;
+            unsafe {
+                (&*bucket.key,
+                 &mut *bucket.val)
+            }
+        })
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.elems_left, Some(self.elems_left))
+    }
+}
+impl<'a, K, V> ExactSizeIterator for IterMut<'a, K, V> {
+    fn len(&self) -> usize { self.elems_left }
+}
+
+impl<K, V> Iterator for IntoIter<K, V> {
+    type Item = (SafeHash, K, V);
+
+    fn next(&mut self) -> Option<(SafeHash, K, V)> {
+        self.iter.next().map(|(_, bucket)| {
+            self.table.size -= 1;
+            unsafe {
+                (
+                    SafeHash {
+                        hash: *bucket.hash,
+                    },
+                    ptr::read(bucket.key),
+                    ptr::read(bucket.val)
+                )
+            }
+        })
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let size = self.table.size();
+        (size, Some(size))
+    }
+}
+impl<K, V> ExactSizeIterator for IntoIter<K, V> {
+    fn len(&self) -> usize { self.table.size() }
+}
+
+impl<'a, K, V> Iterator for Drain<'a, K, V> {
+    type Item = (SafeHash, K, V);
+
+    #[inline]
+    fn next(&mut self) -> Option<(SafeHash, K, V)> {
+        self.iter.next().map(|(idx, bucket)| {
+            self.table.size -= 1;
+            unsafe {
+                self.table.set_ctrl(idx, EMPTY_BUCKET);
+                (
+                    SafeHash {
+                        hash: *bucket.hash,
+                    },
+                    ptr::read(bucket.key),
+                    ptr::read(bucket.val)
+                )
+            }
+        })
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let size = self.table.size();
+        (size, Some(size))
+    }
+}
+impl<'a, K, V> ExactSizeIterator for Drain<'a, K, V> {
+    fn len(&self) -> usize { self.table.size() }
+}
+
+impl<'a, K: 'a, V: 'a> Drop for Drain<'a, K, V> {
+    fn drop(&mut self) {
+        for _ in self.by_ref() {}
+        // Only tombstones are left; the table can start afresh.
+        unsafe { self.table.clear_ctrl(); }
+    }
+}
+
+impl<K: Clone, V: Clone> Clone for RawTable<K, V> {
+    fn clone(&self) -> RawTable<K, V> {
+        unsafe {
+            let mut new_ht = RawTable::new_uninitialized(self.capacity());
+
+            if self.capacity != 0 {
+                // Until `size` is set, a panic in `clone` only frees the
+                // allocation, whatever the control bytes say.
+                ptr::copy_nonoverlapping(*self.ctrl, *new_ht.ctrl, self.capacity + GROUP);
+                let new_first = new_ht.first_bucket_raw();
+                for (idx, bucket) in self.raw_buckets() {
+                    let new_bucket = new_first.offset(idx as isize);
+                    *new_bucket.hash = *bucket.hash;
+                    ptr::write(new_bucket.key, (*bucket.key).clone());
+                    ptr::write(new_bucket.val, (*bucket.val).clone());
+                }
+            }
+
+            new_ht.size = self.size();
+            new_ht.deleted = self.deleted;
+
+            new_ht
+        }
+    }
+}
+
+impl<K, V> Drop for RawTable<K, V> {
+    fn drop(&mut self) {
+        if self.capacity == 0 || self.capacity == mem::POST_DROP_USIZE {
+            return;
+        }
+
+        // This is done in reverse because we've likely partially taken
+        // some elements out with `.into_iter()` from the front, without
+        // marking their buckets empty. Only the last `size` full buckets
+        // still own their entries.
+        unsafe {
+            let first = self.first_bucket_raw();
+            let mut idx = self.capacity;
+            while self.size > 0 {
+                idx -= 1;
+                if self.ctrl_byte(idx) & 0x80 == 0 {
+                    let bucket = first.offset(idx as isize);
+                    self.size -= 1;
+                    mem::drop(ptr::read(bucket.key));
+                    mem::drop(ptr::read(bucket.val));
+                }
+            }
+        }
+
+        let (_, _, _, size) = calculate_offsets(self.capacity,
+                                                size_of::<K>(), min_align_of::<K>(),
+                                                size_of::<V>(), min_align_of::<V>());
+        unsafe {
+            deallocate(*self.ctrl, size, RawTable::<K, V>::align());
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use prelude::v1::*;
+
+    use super::{BitMask, Group, ProbeSeq, SafeHash, calculate_offsets};
+    use super::{DELETED, EMPTY_BUCKET, GROUP};
+
+    #[test]
+    fn test_offset_calculation() {
+        let g = GROUP;
+        assert_eq!(calculate_offsets(32, 1, 1, 4, 4),
+                   (32 + g, 32 * 9 + g, 32 * 10 + g, 32 * 14 + g));
+        assert_eq!(calculate_offsets(16, 12, 4, 24, 8),
+                   (16 + g, 16 * 9 + g, 16 * 21 + g, 16 * 45 + g));
+        assert_eq!(calculate_offsets(8, 0, 1, 1, 1).3, 8 * 10 + g);
+    }
+
+    #[test]
+    fn test_group() {
+        let mut bytes = [EMPTY_BUCKET; 2 * GROUP];
+        for i in 0..GROUP {
+            bytes[i] = i as u8;
+        }
+        bytes[0] = DELETED;
+        bytes[1] = 0x7f;
+        bytes[GROUP - 2] = 0x7f;
+        bytes[GROUP - 1] = EMPTY_BUCKET;
+
+        let g = unsafe { Group::load(bytes.as_ptr()) };
+        assert_eq!(g.matches(0x7f).collect::<Vec<_>>(), [1, GROUP - 2]);
+        assert_eq!(g.matches(0x7e).next(), None);
+        assert_eq!(g.empty().collect::<Vec<_>>(), [GROUP - 1]);
+        assert_eq!(g.empty_or_deleted().collect::<Vec<_>>(), [0, GROUP - 1]);
+        assert_eq!(g.empty().leading(), GROUP - 1);
+        assert_eq!(g.empty().trailing(), 0);
+
+        let g = unsafe { Group::load(bytes.as_ptr().offset(GROUP as isize)) };
+        assert_eq!(g.empty().count(), GROUP);
+        assert_eq!(g.empty().leading(), 0);
+        assert_eq!(BitMask(0).leading(), GROUP);
+        assert_eq!(BitMask(0).trailing(), GROUP);
+    }
+
+    #[test]
+    fn test_probe_seq_covers_table() {
+        for &cap in &[GROUP, 4 * GROUP, 128] {
+            for start in 0..cap {
+                let mut seen = vec![false; cap];
+                let mut probe = ProbeSeq::new(SafeHash { hash: start as u64 }, cap);
+                loop {
+                    for i in 0..GROUP {
+                        seen[(probe.pos + i) & probe.mask] = true;
+                    }
+                    if !probe.next() { break }
+                }
+                assert!(seen.iter().all(|&s| s));
+            }
+        }
+    }
+}
@@ -18,13 +18,15 @@
 
 use prelude::v1::*;
 
+use boxed;
 use error::Error;
 use ffi::{OsStr, OsString};
 use fmt;
 use io;
+use libc;
 use path::{Path, PathBuf};
 use sync::atomic::{AtomicIsize, ATOMIC_ISIZE_INIT, Ordering};
-use sync::{StaticMutex, MUTEX_INIT};
+use sync::{StaticMutex, MUTEX_INIT, Once, ONCE_INIT};
 use sys::os as os_imp;
 
 /// Returns the current working directory as a `PathBuf`.
@@ -455,6 +457,35 @@ pub fn current_exe() -> io::Result<PathBuf> {
     os_imp::current_exe()
 }
 
+/// Returns the path to the current executable, as `current_exe` does, but
+/// without allocating.
+///
+/// The path (or the error) is looked up once per process, the first time
+/// this function is called, and kept for as long as the process lives. This
+/// makes the executable's name cheap to ask for repeatedly, say from a
+/// logger or a panic handler, but a later move or replacement of the
+/// executable, or a lookup that failed only transiently, is never noticed.
+/// `current_exe` looks the path up afresh on each call.
+#[unstable(feature = "env_cached", reason = "recently added API")]
+pub fn current_exe_cached() -> io::Result<&'static Path> {
+    static INIT: Once = ONCE_INIT;
+    // The error is kept as its OS error code, if it has one.
+    static mut EXE: *const Result<PathBuf, Option<i32>> =
+        0 as *const Result<PathBuf, Option<i32>>;
+    unsafe {
+        INIT.call_once(|| {
+            let exe = os_imp::current_exe().map_err(|e| e.raw_os_error());
+            EXE = boxed::into_raw(Box::new(exe));
+        });
+        match *EXE {
+            Ok(ref path) => Ok(path),
+            Err(Some(code)) => Err(io::Error::from_raw_os_error(code)),
+            Err(None) => Err(io::Error::new(io::ErrorKind::Other,
+                                            "could not determine the current executable")),
+        }
+    }
+}
+
 static EXIT_STATUS: AtomicIsize = ATOMIC_ISIZE_INIT;
 
 /// Sets the process exit code
@@ -567,12 +598,40 @@ impl ExactSizeIterator for ArgsOs {
     fn len(&self) -> usize { self.inner.len() }
 }
 
+/// Returns the arguments which this program was started with, as `args_os`
+/// does, but without allocating or locking.
+///
+/// The arguments are copied once per process, on the first call, into
+/// storage which lives as long as the process does.
+#[unstable(feature = "env_cached", reason = "recently added API")]
+pub fn args_cached() -> &'static [OsString] {
+    static INIT: Once = ONCE_INIT;
+    static mut ARGS: *const Vec<OsString> = 0 as *const Vec<OsString>;
+    unsafe {
+        INIT.call_once(|| {
+            ARGS = boxed::into_raw(Box::new(args_os().collect()));
+        });
+        &**ARGS
+    }
+}
+
 /// Returns the page size of the current architecture in bytes.
 #[unstable(feature = "page_size", reason = "naming and/or location may change")]
 pub fn page_size() -> usize {
     os_imp::page_size()
 }
 
+/// Returns the number of CPUs the current process can run on.
+///
+/// This is never less than one. On Linux it takes into account the
+/// scheduler affinity mask of the process and any CPU quota of its cgroup,
+/// so that it does not overcount inside containers or under `taskset`.
+#[unstable(feature = "num_cpus", reason = "naming and/or location may change")]
+pub fn num_cpus() -> usize {
+    extern { fn rust_get_num_cpus() -> libc::uintptr_t; }
+    unsafe { rust_get_num_cpus() as usize }
+}
+
 /// Constants associated with the current target
 #[stable(feature = "env", since = "1.0.0")]
 pub mod consts {
@@ -889,6 +948,19 @@ mod tests {
         assert!(check_parse("/:/usr/local", &mut ["/", "/usr/local"]));
     }
 
+    #[test]
+    fn test_cached() {
+        assert_eq!(current_exe_cached().unwrap(), &*current_exe().unwrap());
+        assert!(current_exe_cached().unwrap().is_absolute());
+        assert_eq!(args_cached().len(), args_os().len());
+        assert_eq!(args_cached().as_ptr(), args_cached().as_ptr());
+    }
+
+    #[test]
+    fn test_num_cpus() {
+        assert!(num_cpus() >= 1);
+    }
+
     #[test]
     #[cfg(unix)]
     fn join_paths_unix() {
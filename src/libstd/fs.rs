@@ -768,6 +768,14 @@ impl AsInner<fs_imp::DirEntry> for DirEntry {
     fn as_inner(&self) -> &fs_imp::DirEntry { &self.0 }
 }
 
+impl AsInnerMut<fs_imp::ReadDir> for ReadDir {
+    fn as_inner_mut(&mut self) -> &mut fs_imp::ReadDir { &mut self.0 }
+}
+
+impl FromInner<fs_imp::FileType> for FileType {
+    fn from_inner(ft: fs_imp::FileType) -> FileType { FileType(ft) }
+}
+
 /// Removes a file from the underlying filesystem.
 ///
 /// Note that, just because an unlink call was successful, it is not
@@ -1650,6 +1658,41 @@ mod tests {
         check!(fs::remove_dir(dir));
     }
 
+    #[test]
+    #[cfg(unix)]
+    fn file_test_directoryinfo_readdir_raw() {
+        use os::unix::fs::ReadDirExt;
+
+        let tmpdir = tmpdir();
+        let dir = &tmpdir.join("di_readdir_raw");
+        check!(fs::create_dir(dir));
+        check!(fs::create_dir(&dir.join("sub")));
+        // Enough entries to need more than one batch.
+        for n in 0..2000 {
+            check!(File::create(&dir.join(&format!("file-with-a-long-name-{}", n))));
+        }
+
+        let mut files = check!(fs::read_dir(dir));
+        let mut nfiles = 0;
+        let mut ndirs = 0;
+        while let Some(entry) = files.next_raw() {
+            let entry = check!(entry);
+            let name = entry.file_name().to_str().unwrap();
+            match entry.file_type() {
+                Some(ref t) if t.is_dir() => { assert_eq!(name, "sub"); ndirs += 1; }
+                Some(ref t) if t.is_file() => {
+                    assert!(name.starts_with("file-with-a-long-name-"));
+                    nfiles += 1;
+                }
+                Some(_) => panic!("unexpected file type for {}", name),
+                None => if name != "sub" { nfiles += 1 },
+            }
+        }
+        assert_eq!(nfiles, 2000);
+        assert!(ndirs <= 1);
+        check!(fs::remove_dir_all(dir));
+    }
+
     #[test]
     fn file_test_walk_dir() {
         let tmpdir = tmpdir();
@@ -1678,6 +1721,48 @@ mod tests {
         check!(fs::remove_dir_all(dir));
     }
 
+    #[test]
+    #[cfg(unix)]
+    fn file_test_par_walk_dir() {
+        use os::unix::fs::par_walk_dir;
+
+        let tmpdir = tmpdir();
+        let dir = &tmpdir.join("par_walk_dir");
+        for a in 0..4 {
+            for b in 0..4 {
+                let sub = dir.join(&format!("{}/{}", a, b));
+                check!(fs::create_dir_all(&sub));
+                for c in 0..4 {
+                    check!(File::create(&sub.join(&format!("{}.txt", c))));
+                }
+            }
+        }
+        check!(fs::create_dir_all(&dir.join("skip/deeper")));
+
+        let walk = check!(par_walk_dir(dir).threads(3).filter(|e| {
+            e.path().file_name().unwrap().to_str() != Some("skip")
+        }).walk());
+        let mut dirs = 0;
+        let mut files = 0;
+        for entry in walk {
+            let entry = check!(entry);
+            assert!(entry.path().starts_with(dir));
+            if entry.file_type().is_dir() {
+                dirs += 1;
+                assert!(entry.depth() <= 2);
+            } else {
+                assert!(entry.file_type().is_file());
+                assert_eq!(entry.depth(), 3);
+                files += 1;
+            }
+        }
+        assert_eq!(dirs, 4 + 16);
+        assert_eq!(files, 64);
+
+        assert!(par_walk_dir(&dir.join("missing")).walk().is_err());
+        check!(fs::remove_dir_all(dir));
+    }
+
     #[test]
     fn mkdir_path_already_exists_error() {
         let tmpdir = tmpdir();
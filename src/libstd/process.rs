@@ -834,4 +834,72 @@ mod tests {
         assert!(output.contains("RUN_TEST_NEW_ENV=123"),
                 "didn't find RUN_TEST_NEW_ENV inside of:\n\n{}", output);
     }
+
+    #[cfg(all(unix, not(target_os="android")))]
+    #[test]
+    fn test_null_stdio() {
+        let out = Command::new("cat").stdin(Stdio::null()).output().unwrap();
+        assert!(out.status.success());
+        assert_eq!(out.stdout, Vec::<u8>::new());
+    }
+
+    #[cfg(all(unix, not(target_os="android")))]
+    #[test]
+    fn test_script_without_interpreter() {
+        use env;
+        use fs::{self, File};
+        use libc;
+        use os::unix::fs::PermissionsExt;
+
+        // Run by /bin/sh, as `execvp` does for files it can't execute.
+        let pid = unsafe { libc::getpid() };
+        let path = env::temp_dir().join(format!("rust-test-script-{}", pid));
+        File::create(&path).unwrap().write_all(b"echo hello\n").unwrap();
+        fs::set_permissions(&path, PermissionsExt::from_mode(0o755)).unwrap();
+        let out = Command::new(&path).output();
+        fs::remove_file(&path).unwrap();
+        let out = out.unwrap();
+        assert!(out.status.success());
+        assert_eq!(out.stdout, b"hello\n".to_vec());
+    }
+
+    // The time to spawn a trivial child and wait for it, with a parent of the
+    // given heap size. Setting a working directory forces the child to be
+    // forked rather than spawned with `posix_spawn`, for comparison.
+    #[cfg(all(unix, not(target_os="android")))]
+    fn bench_spawn_with(b: &mut ::test::Bencher, heap_bytes: usize, fork: bool) {
+        let heap = vec![1u8; heap_bytes];
+        b.iter(|| {
+            let mut cmd = Command::new("true");
+            if fork {
+                cmd.current_dir(".");
+            }
+            assert!(cmd.status().unwrap().success());
+        });
+        drop(heap);
+    }
+
+    #[cfg(all(unix, not(target_os="android")))]
+    #[bench]
+    fn bench_spawn(b: &mut ::test::Bencher) {
+        bench_spawn_with(b, 0, false)
+    }
+
+    #[cfg(all(unix, not(target_os="android")))]
+    #[bench]
+    fn bench_spawn_fork(b: &mut ::test::Bencher) {
+        bench_spawn_with(b, 0, true)
+    }
+
+    #[cfg(all(unix, not(target_os="android")))]
+    #[bench]
+    fn bench_spawn_large_heap(b: &mut ::test::Bencher) {
+        bench_spawn_with(b, 256 << 20, false)
+    }
+
+    #[cfg(all(unix, not(target_os="android")))]
+    #[bench]
+    fn bench_spawn_fork_large_heap(b: &mut ::test::Bencher) {
+        bench_spawn_with(b, 256 << 20, true)
+    }
 }
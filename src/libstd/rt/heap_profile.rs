@@ -0,0 +1,284 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! A sampling heap profiler.
+//!
+//! The profiler is compiled in with `--cfg heap_profile`
+//! (`./configure --enable-heap-profile`). It starts when
+//! `RUST_HEAP_PROFILE` is set to the mean number of bytes between samples,
+//! for instance `RUST_HEAP_PROFILE=524288`. liballoc picks the allocations
+//! to sample (see `alloc::heap::profile`). Their stacks are captured with
+//! libbacktrace's `backtrace_simple` and counted per call site in a
+//! lock-free table.
+//!
+//! The table is written out when the process exits. It is also written at
+//! the first sampled allocation after a `SIGUSR2`, or after the signal whose
+//! number is in `RUST_HEAP_PROFILE_SIGNAL` (`0` for none). Each dump goes to
+//! `<prefix>.<n>.folded`. The prefix comes from `RUST_HEAP_PROFILE_FILE` and
+//! defaults to `heap.<pid>`.
+//!
+//! Profiles are "folded" stacks, the input of flamegraph.pl and similar
+//! tools. Each line is one call site: its frames from the outermost in,
+//! separated by `;`, then the estimated number of bytes allocated there.
+//! Each dump covers everything since the process started.
+
+use prelude::v1::*;
+use io::prelude::*;
+
+use alloc::heap::profile;
+use boxed;
+use cell::UnsafeCell;
+use env;
+use ffi::CStr;
+use fs::File;
+use io::{self, BufWriter};
+use libc;
+use mem;
+use ptr;
+use str;
+use sync::atomic::{AtomicBool, AtomicUsize, Ordering, ATOMIC_BOOL_INIT, ATOMIC_USIZE_INIT};
+use sync::{StaticMutex, MUTEX_INIT};
+use sys_common::backtrace::demangle;
+use u32;
+
+use super::util;
+
+/// Frames kept per call site.
+const DEPTH: usize = 32;
+/// Call sites in the table, a power of two.
+const SITES: usize = 1 << 14;
+/// Slots looked at before a sample is given up as dropped.
+const PROBES: usize = 64;
+/// Frames of the profiler itself: `sample` and liballoc's sampler.
+const SKIP: libc::c_int = 2;
+
+#[cfg(any(target_arch = "mips", target_arch = "mipsel"))]
+const SIGUSR2: libc::c_int = 17;
+#[cfg(not(any(target_arch = "mips", target_arch = "mipsel")))]
+const SIGUSR2: libc::c_int = 12;
+
+/// A call site. The slot is claimed by setting `hash`; the thread which
+/// claims it then fills in `frames` and sets `ready`.
+struct Site {
+    hash: AtomicUsize,
+    ready: AtomicBool,
+    frames: UnsafeCell<([usize; DEPTH], usize)>,
+    bytes: AtomicUsize,
+}
+
+static mut TABLE: *const Site = 0 as *const Site;
+static mut STATE: *mut backtrace_state = 0 as *mut backtrace_state;
+static mut PREFIX: *const String = 0 as *const String;
+static DROPPED: AtomicUsize = ATOMIC_USIZE_INIT;
+static DUMP_REQUESTED: AtomicBool = ATOMIC_BOOL_INIT;
+static DUMPS: AtomicUsize = ATOMIC_USIZE_INIT;
+static LOCK: StaticMutex = MUTEX_INIT;
+
+////////////////////////////////////////////////////////////////////////
+// libbacktrace.h API
+////////////////////////////////////////////////////////////////////////
+#[allow(non_camel_case_types)]
+enum backtrace_state {}
+
+#[allow(non_camel_case_types)]
+type backtrace_simple_callback =
+    extern "C" fn(data: *mut libc::c_void, pc: libc::uintptr_t) -> libc::c_int;
+#[allow(non_camel_case_types)]
+type backtrace_syminfo_callback =
+    extern "C" fn(data: *mut libc::c_void,
+                  pc: libc::uintptr_t,
+                  symname: *const libc::c_char,
+                  symval: libc::uintptr_t,
+                  symsize: libc::uintptr_t);
+#[allow(non_camel_case_types)]
+type backtrace_error_callback =
+    extern "C" fn(data: *mut libc::c_void,
+                  msg: *const libc::c_char,
+                  errnum: libc::c_int);
+
+extern {
+    fn backtrace_create_state(filename: *const libc::c_char,
+                              threaded: libc::c_int,
+                              error: backtrace_error_callback,
+                              data: *mut libc::c_void)
+                              -> *mut backtrace_state;
+    fn backtrace_simple(state: *mut backtrace_state,
+                        skip: libc::c_int,
+                        cb: backtrace_simple_callback,
+                        error: backtrace_error_callback,
+                        data: *mut libc::c_void) -> libc::c_int;
+    fn backtrace_syminfo(state: *mut backtrace_state,
+                         addr: libc::uintptr_t,
+                         cb: backtrace_syminfo_callback,
+                         error: backtrace_error_callback,
+                         data: *mut libc::c_void) -> libc::c_int;
+}
+
+extern fn error_cb(_data: *mut libc::c_void, _msg: *const libc::c_char,
+                   _errnum: libc::c_int) {
+    // frames which cannot be unwound or named are left out
+}
+
+extern fn simple_cb(data: *mut libc::c_void, pc: libc::uintptr_t) -> libc::c_int {
+    let frames = unsafe { &mut *(data as *mut ([usize; DEPTH], usize)) };
+    frames.0[frames.1] = pc as usize;
+    frames.1 += 1;
+    (frames.1 == DEPTH) as libc::c_int
+}
+
+extern fn syminfo_cb(data: *mut libc::c_void,
+                     _pc: libc::uintptr_t,
+                     symname: *const libc::c_char,
+                     _symval: libc::uintptr_t,
+                     _symsize: libc::uintptr_t) {
+    let slot = data as *mut *const libc::c_char;
+    unsafe { *slot = symname; }
+}
+
+extern fn on_signal(_signum: libc::c_int) {
+    DUMP_REQUESTED.store(true, Ordering::SeqCst);
+}
+
+/// Starts the profiler if `RUST_HEAP_PROFILE` asks for it.
+pub fn init() {
+    let rate = match env::var("RUST_HEAP_PROFILE").ok().and_then(|s| s.parse().ok()) {
+        Some(rate) if rate > 0 && rate <= u32::MAX as usize => rate,
+        _ => return,
+    };
+    let prefix = env::var("RUST_HEAP_PROFILE_FILE").unwrap_or_else(|_| {
+        format!("heap.{}", unsafe { libc::getpid() })
+    });
+    let signum = env::var("RUST_HEAP_PROFILE_SIGNAL").ok()
+                     .and_then(|s| s.parse().ok()).unwrap_or(SIGUSR2);
+
+    unsafe {
+        STATE = backtrace_create_state(ptr::null(), 1, error_cb, ptr::null_mut());
+        if STATE.is_null() {
+            rterrln!("heap profile: cannot capture stacks, not profiling");
+            return
+        }
+
+        let mut table = Vec::with_capacity(SITES);
+        for _ in 0..SITES {
+            table.push(Site {
+                hash: AtomicUsize::new(0),
+                ready: AtomicBool::new(false),
+                frames: UnsafeCell::new(([0; DEPTH], 0)),
+                bytes: AtomicUsize::new(0),
+            });
+        }
+        TABLE = table.as_ptr();
+        mem::forget(table);
+        PREFIX = boxed::into_raw(Box::new(prefix));
+
+        if signum != 0 {
+            use libc::funcs::posix01::signal::signal;
+            signal(signum, on_signal as libc::sighandler_t);
+        }
+    }
+
+    let _ = super::at_exit(|| {
+        profile::stop();
+        dump();
+    });
+    profile::start(rate, sample);
+}
+
+/// The hook called by liballoc for each sampled allocation.
+#[inline(never)]
+fn sample(_size: usize, weight: usize) {
+    if DUMP_REQUESTED.swap(false, Ordering::SeqCst) {
+        dump();
+    }
+
+    let mut frames = ([0; DEPTH], 0);
+    unsafe {
+        backtrace_simple(STATE, SKIP, simple_cb, error_cb,
+                         &mut frames as *mut _ as *mut libc::c_void);
+    }
+    let pcs = &frames.0[..frames.1];
+    if pcs.is_empty() {
+        return
+    }
+    let hash = pcs.iter().fold(0, |h: usize, &pc| {
+        (h.rotate_left(5) ^ pc).wrapping_mul(0x9e3779b1)
+    }) | 1;
+
+    for i in 0..PROBES {
+        let slot = hash.wrapping_add(i) & (SITES - 1);
+        let site = unsafe { &*TABLE.offset(slot as isize) };
+        let mut h = site.hash.load(Ordering::SeqCst);
+        if h == 0 {
+            h = site.hash.compare_and_swap(0, hash, Ordering::SeqCst);
+            if h == 0 {
+                unsafe { *site.frames.get() = frames; }
+                site.ready.store(true, Ordering::SeqCst);
+                h = hash;
+            }
+        }
+        if h == hash {
+            site.bytes.fetch_add(weight, Ordering::SeqCst);
+            return
+        }
+    }
+    DROPPED.fetch_add(weight, Ordering::SeqCst);
+}
+
+/// Writes the table out to the next profile file.
+fn dump() {
+    let _g = LOCK.lock();
+    let path = format!("{}.{}.folded", unsafe { &*PREFIX },
+                       DUMPS.fetch_add(1, Ordering::SeqCst));
+    match write_profile(&path) {
+        Ok(()) => {}
+        Err(e) => util::dumb_print(format_args!("heap profile: cannot write {}: {}\n",
+                                                path, e)),
+    }
+}
+
+fn write_profile(path: &str) -> io::Result<()> {
+    let mut w = BufWriter::new(try!(File::create(path)));
+    for i in 0..SITES {
+        let site = unsafe { &*TABLE.offset(i as isize) };
+        if !site.ready.load(Ordering::SeqCst) {
+            continue
+        }
+        let (pcs, depth) = unsafe { *site.frames.get() };
+        for (j, &pc) in pcs[..depth].iter().rev().enumerate() {
+            if j > 0 {
+                try!(w.write_all(b";"));
+            }
+            try!(write_symbol(&mut w, pc));
+        }
+        try!(writeln!(w, " {}", site.bytes.load(Ordering::SeqCst)));
+    }
+    let dropped = DROPPED.load(Ordering::SeqCst);
+    if dropped > 0 {
+        try!(writeln!(w, "[call site table full] {}", dropped));
+    }
+    w.flush()
+}
+
+fn write_symbol(w: &mut Write, addr: usize) -> io::Result<()> {
+    let mut name = ptr::null();
+    let ret = unsafe {
+        backtrace_syminfo(STATE, addr as libc::uintptr_t, syminfo_cb, error_cb,
+                          &mut name as *mut *const libc::c_char as *mut libc::c_void)
+    };
+    let name = if ret == 0 || name.is_null() {
+        None
+    } else {
+        str::from_utf8(unsafe { CStr::from_ptr(name).to_bytes() }).ok()
+    };
+    match name {
+        Some(name) => demangle(w, name),
+        None => write!(w, "{:#x}", addr),
+    }
+}
@@ -45,6 +45,13 @@ pub mod args;
 mod at_exit_imp;
 mod libunwind;
 
+#[cfg(all(heap_profile, target_os = "linux"))]
+mod heap_profile;
+#[cfg(not(all(heap_profile, target_os = "linux")))]
+mod heap_profile {
+    pub fn init() {}
+}
+
 /// The default error code of the rust runtime if the main thread panics instead
 /// of exiting cleanly.
 pub const DEFAULT_ERROR_CODE: isize = 101;
@@ -124,6 +131,9 @@ fn lang_start(main: *const u8, argc: isize, argv: *const *const u8) -> isize {
         // Store our args if necessary in a squirreled away location
         args::init(argc, argv);
 
+        // Start the heap profiler if it is built in and asked for
+        heap_profile::init();
+
         // And finally, let's run some code!
         let res = unwind::try(|| {
             let main: fn() = mem::transmute(main);
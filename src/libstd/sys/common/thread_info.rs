@@ -13,6 +13,7 @@
 use core::prelude::*;
 
 use cell::RefCell;
+use mem;
 use string::String;
 use thread::Thread;
 use thread::LocalKeyState;
@@ -50,6 +51,11 @@ pub fn stack_guard() -> Option<usize> {
     ThreadInfo::with(|info| info.stack_guard)
 }
 
+/// Installs `thread` as the current thread's handle, returning the old one.
+pub fn replace_thread(thread: Thread) -> Option<Thread> {
+    ThreadInfo::with(move |info| mem::replace(&mut info.thread, thread))
+}
+
 pub fn set(stack_guard: usize, thread: Thread) {
     THREAD_INFO.with(|c| assert!(c.borrow().is_none()));
     THREAD_INFO.with(move |c| *c.borrow_mut() = Some(ThreadInfo{
@@ -364,7 +364,7 @@ fn print(w: &mut Write, idx: isize, addr: *mut libc::c_void,
                           cfg!(target_os = "dragonfly") ||
                           cfg!(target_os = "bitrig") ||
                           cfg!(target_os = "openbsd") {
-            env::current_exe().ok()
+            env::current_exe_cached().ok()
         } else {
             None
         };
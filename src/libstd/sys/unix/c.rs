@@ -165,6 +165,54 @@ extern {
                     -> *mut libc::c_char;
 }
 
+// Only the platforms whose `posix_spawn` can report a failed exec back to the
+// parent; see `process2::posix_spawn`.
+#[cfg(any(all(target_os = "linux", not(target_env = "musl")),
+          target_os = "macos",
+          target_os = "freebsd"))]
+pub mod spawn {
+    use libc;
+
+    #[cfg(target_os = "linux")]
+    #[repr(C)]
+    pub struct posix_spawn_file_actions_t {
+        __allocated: libc::c_int,
+        __used: libc::c_int,
+        __actions: *mut libc::c_void,
+        __pad: [libc::c_int; 16],
+    }
+
+    #[cfg(any(target_os = "macos", target_os = "freebsd"))]
+    pub type posix_spawn_file_actions_t = *mut libc::c_void;
+
+    extern {
+        // The attributes are always left null, so their type is not needed.
+        pub fn posix_spawnp(pid: *mut libc::pid_t,
+                            file: *const libc::c_char,
+                            file_actions: *const posix_spawn_file_actions_t,
+                            attrp: *const libc::c_void,
+                            argv: *const *const libc::c_char,
+                            envp: *const *const libc::c_char) -> libc::c_int;
+        pub fn posix_spawn_file_actions_init(actions: *mut posix_spawn_file_actions_t)
+                                             -> libc::c_int;
+        pub fn posix_spawn_file_actions_destroy(actions: *mut posix_spawn_file_actions_t)
+                                                -> libc::c_int;
+        pub fn posix_spawn_file_actions_adddup2(actions: *mut posix_spawn_file_actions_t,
+                                                fd: libc::c_int,
+                                                newfd: libc::c_int) -> libc::c_int;
+        pub fn posix_spawn_file_actions_addopen(actions: *mut posix_spawn_file_actions_t,
+                                                fd: libc::c_int,
+                                                path: *const libc::c_char,
+                                                oflag: libc::c_int,
+                                                mode: libc::mode_t) -> libc::c_int;
+    }
+
+    #[cfg(target_os = "linux")]
+    extern {
+        pub fn gnu_get_libc_version() -> *const libc::c_char;
+    }
+}
+
 #[cfg(any(target_os = "macos", target_os = "ios"))]
 mod select {
     pub const FD_SETSIZE: usize = 1024;
@@ -14,15 +14,24 @@
 
 use prelude::v1::*;
 
+use cmp;
+use collections::VecDeque;
+use env;
+use ffi::OsStr;
 use fs::{self, Permissions, OpenOptions};
 use io;
 use mem;
 use os::raw::c_long;
+use os::unix::ffi::OsStrExt;
 use os::unix::raw;
-use path::Path;
+use path::{Path, PathBuf};
+use sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use sync::mpsc;
+use sync::{Arc, Condvar, Mutex};
 use sys::platform;
 use sys;
 use sys_common::{FromInner, AsInner, AsInnerMut};
+use thread;
 
 #[unstable(feature = "fs_mode", reason = "recently added API")]
 pub const USER_READ: raw::mode_t = 0o400;
@@ -161,6 +170,47 @@ impl DirEntryExt for fs::DirEntry {
     fn ino(&self) -> raw::ino_t { self.as_inner().ino() }
 }
 
+/// A directory entry borrowed from the internal buffer of a `fs::ReadDir`.
+///
+/// Unlike `fs::DirEntry` this does not allocate, and it is only valid until
+/// the next entry is read from the same `ReadDir`.
+#[unstable(feature = "dir_entry_ext", reason = "recently added API")]
+pub struct RawDirEntry<'a>(sys::fs2::RawDirEntry<'a>);
+
+#[unstable(feature = "dir_entry_ext", reason = "recently added API")]
+impl<'a> RawDirEntry<'a> {
+    /// Returns the bare file name of this entry.
+    pub fn file_name(&self) -> &'a OsStr {
+        <OsStr as OsStrExt>::from_bytes(self.0.name_bytes())
+    }
+
+    /// Returns the inode number of this entry.
+    pub fn ino(&self) -> raw::ino_t { self.0.ino() }
+
+    /// Returns the file type of this entry if the directory listing reported
+    /// it, without ever calling `lstat`. Symlinks are not followed.
+    pub fn file_type(&self) -> Option<fs::FileType> {
+        self.0.file_type().map(fs::FileType::from_inner)
+    }
+}
+
+/// Batched, allocation-free directory enumeration.
+///
+/// On Linux `fs::ReadDir` reads entries in large batches with `getdents64`;
+/// `next_raw` hands them out in place instead of copying each one into an
+/// owned `fs::DirEntry`.
+#[unstable(feature = "dir_entry_ext", reason = "recently added API")]
+pub trait ReadDirExt {
+    /// Returns the next entry of the directory, or `None` at its end.
+    fn next_raw(&mut self) -> Option<io::Result<RawDirEntry>>;
+}
+
+impl ReadDirExt for fs::ReadDir {
+    fn next_raw(&mut self) -> Option<io::Result<RawDirEntry>> {
+        self.as_inner_mut().next_raw().map(|entry| entry.map(RawDirEntry))
+    }
+}
+
 /// Creates a new symbolic link on the filesystem.
 ///
 /// The `dst` path will be a symbolic link pointing to the `src` path.
@@ -205,3 +255,319 @@ impl DirBuilderExt for fs::DirBuilder {
     }
 }
 
+
+/// An entry found by a parallel directory walk started with `par_walk_dir`.
+#[unstable(feature = "fs_walk", reason = "recently added API")]
+pub struct WalkEntry {
+    path: PathBuf,
+    file_type: fs::FileType,
+    depth: usize,
+}
+
+#[unstable(feature = "fs_walk", reason = "recently added API")]
+impl WalkEntry {
+    /// Returns the full path of this entry, starting with the walk's root.
+    pub fn path(&self) -> &Path { &self.path }
+
+    /// Returns the type of this entry. Symlinks are reported as symlinks and
+    /// are never followed.
+    pub fn file_type(&self) -> fs::FileType { self.file_type }
+
+    /// Returns how far below the root this entry is. Entries of the root
+    /// directory itself have depth 1.
+    pub fn depth(&self) -> usize { self.depth }
+
+    /// Consumes the entry, returning its path.
+    pub fn into_path(self) -> PathBuf { self.path }
+}
+
+/// A builder for a recursive directory walk that is spread over a pool of
+/// threads.
+///
+/// Directories are read with the same batched primitive as
+/// `ReadDirExt::next_raw`, file types come from the directory listing
+/// wherever the file system provides them, and subdirectories are opened
+/// relative to their parent's open descriptor rather than by full path.
+/// Each thread works through its own queue of directories depth-first and
+/// steals from the other queues when it runs dry.
+///
+/// Entries are streamed back in no particular order through the iterator
+/// returned by `walk`; dropping the iterator stops the walk.
+#[unstable(feature = "fs_walk", reason = "recently added API")]
+pub struct ParWalkDir {
+    root: PathBuf,
+    threads: usize,
+    filter: Option<Arc<Fn(&WalkEntry) -> bool + Send + Sync>>,
+}
+
+/// Creates a builder for a parallel recursive walk of the directory `path`.
+///
+/// # Examples
+///
+/// ```
+/// # #![feature(fs_walk)]
+/// use std::os::unix::fs::par_walk_dir;
+///
+/// # fn foo() -> std::io::Result<()> {
+/// let walk = try!(par_walk_dir("src").threads(4).filter(|e| {
+///     e.path().file_name().map_or(true, |n| n.to_str() != Some(".git"))
+/// }).walk());
+/// for entry in walk {
+///     let entry = try!(entry);
+///     if entry.file_type().is_file() {
+///         println!("{}", entry.path().display());
+///     }
+/// }
+/// # Ok(())
+/// # }
+/// ```
+#[unstable(feature = "fs_walk", reason = "recently added API")]
+pub fn par_walk_dir<P: AsRef<Path>>(path: P) -> ParWalkDir {
+    ParWalkDir {
+        root: path.as_ref().to_path_buf(),
+        threads: env::num_cpus(),
+        filter: None,
+    }
+}
+
+#[unstable(feature = "fs_walk", reason = "recently added API")]
+impl ParWalkDir {
+    /// Sets the number of threads to walk with. Defaults to the number of
+    /// CPUs.
+    pub fn threads(&mut self, threads: usize) -> &mut ParWalkDir {
+        self.threads = cmp::max(threads, 1);
+        self
+    }
+
+    /// Sets a predicate deciding which entries are reported. Entries for
+    /// which it returns false are skipped, and if they are directories their
+    /// contents are not walked at all. It is called concurrently from all
+    /// of the walk's threads.
+    pub fn filter<F>(&mut self, filter: F) -> &mut ParWalkDir where
+        F: Fn(&WalkEntry) -> bool + Send + Sync + 'static
+    {
+        self.filter = Some(Arc::new(filter));
+        self
+    }
+
+    /// Starts the walk, returning an iterator over the entries found.
+    ///
+    /// Failing to open the root is reported here; errors reading anything
+    /// below it are yielded by the iterator, and the walk carries on.
+    pub fn walk(&self) -> io::Result<ParWalkIter> {
+        let root = try!(sys::fs2::readdir(&self.root));
+        let (tx, rx) = mpsc::sync_channel(WALK_CHANNEL_BOUND);
+        let shared = Arc::new(WalkShared {
+            queues: (0..self.threads).map(|_| Mutex::new(VecDeque::new())).collect(),
+            pending: AtomicUsize::new(1),
+            open_parents: Arc::new(AtomicUsize::new(0)),
+            done: AtomicBool::new(false),
+            sleep: Mutex::new(()),
+            wakeup: Condvar::new(),
+            filter: self.filter.clone(),
+        });
+        shared.queues[0].lock().unwrap().push_back(WalkJob {
+            dir: JobDir::Open(root),
+            path: self.root.clone(),
+            depth: 0,
+        });
+        for i in 0..self.threads {
+            let shared = shared.clone();
+            let tx = tx.clone();
+            try!(thread::Builder::new().spawn(move || walk_worker(&shared, i, &tx)));
+        }
+        Ok(ParWalkIter { rx: rx })
+    }
+}
+
+/// An iterator over the entries of a parallel directory walk.
+#[unstable(feature = "fs_walk", reason = "recently added API")]
+pub struct ParWalkIter {
+    rx: mpsc::Receiver<io::Result<WalkEntry>>,
+}
+
+#[unstable(feature = "fs_walk", reason = "recently added API")]
+impl Iterator for ParWalkIter {
+    type Item = io::Result<WalkEntry>;
+
+    fn next(&mut self) -> Option<io::Result<WalkEntry>> {
+        self.rx.recv().ok()
+    }
+}
+
+// How many entries the walkers may get ahead of the consumer.
+const WALK_CHANNEL_BOUND: usize = 1024;
+
+// How many fully-read directories are kept open so that their children can be
+// opened relative to them. Beyond this, children are opened by full path, to
+// stay well clear of the process's descriptor limit.
+const WALK_MAX_OPEN_PARENTS: usize = 128;
+
+struct WalkShared {
+    queues: Vec<Mutex<VecDeque<WalkJob>>>,
+    // Jobs queued or in progress. The walk is over when this reaches zero.
+    pending: AtomicUsize,
+    open_parents: Arc<AtomicUsize>,
+    // Set once the consumer has hung up.
+    done: AtomicBool,
+    // Idle workers wait on `wakeup`, holding `sleep` while they check for
+    // work, until a job is queued or the walk is over.
+    sleep: Mutex<()>,
+    wakeup: Condvar,
+    filter: Option<Arc<Fn(&WalkEntry) -> bool + Send + Sync>>,
+}
+
+struct WalkJob {
+    dir: JobDir,
+    path: PathBuf,
+    depth: usize,
+}
+
+enum JobDir {
+    Open(sys::fs2::ReadDir),
+    Child(Arc<ParentDir>, Vec<u8>),
+    Path,
+}
+
+// A directory kept open after being read, for opening its children.
+struct ParentDir {
+    dir: sys::fs2::ReadDir,
+    count: Arc<AtomicUsize>,
+}
+
+impl Drop for ParentDir {
+    fn drop(&mut self) {
+        self.count.fetch_sub(1, Ordering::SeqCst);
+    }
+}
+
+fn walk_worker(shared: &WalkShared, me: usize,
+               tx: &mpsc::SyncSender<io::Result<WalkEntry>>) {
+    while let Some(job) = next_walk_job(shared, me) {
+        if !walk_one(shared, me, job, tx) {
+            shared.done.store(true, Ordering::SeqCst);
+        }
+        if shared.pending.fetch_sub(1, Ordering::SeqCst) == 1 ||
+           shared.done.load(Ordering::SeqCst) {
+            wake_walkers(shared);
+        }
+    }
+}
+
+// Takes a job to work on, sleeping while there is none but other workers may
+// yet queue some. Returns `None` once the walk is over.
+fn next_walk_job(shared: &WalkShared, me: usize) -> Option<WalkJob> {
+    if shared.done.load(Ordering::SeqCst) {
+        return None
+    }
+    if let Some(job) = take_walk_job(shared, me) {
+        return Some(job)
+    }
+    // Jobs are queued before `sleep` is taken to wake the workers, so one
+    // queued after the check below can't be missed.
+    let mut guard = shared.sleep.lock().unwrap();
+    loop {
+        if shared.done.load(Ordering::SeqCst) ||
+           shared.pending.load(Ordering::SeqCst) == 0 {
+            return None
+        }
+        if let Some(job) = take_walk_job(shared, me) {
+            return Some(job)
+        }
+        guard = shared.wakeup.wait(guard).unwrap();
+    }
+}
+
+fn wake_walkers(shared: &WalkShared) {
+    let _guard = shared.sleep.lock().unwrap();
+    shared.wakeup.notify_all();
+}
+
+// Pops the most recently queued job of this thread's own queue, or else
+// steals the oldest job of another thread's.
+fn take_walk_job(shared: &WalkShared, me: usize) -> Option<WalkJob> {
+    if let Some(job) = shared.queues[me].lock().unwrap().pop_back() {
+        return Some(job)
+    }
+    let n = shared.queues.len();
+    for i in 1..n {
+        if let Some(job) = shared.queues[(me + i) % n].lock().unwrap().pop_front() {
+            return Some(job)
+        }
+    }
+    None
+}
+
+// Reads one directory, reporting its entries and queueing its
+// subdirectories. Returns false if the consumer has hung up.
+fn walk_one(shared: &WalkShared, me: usize, job: WalkJob,
+            tx: &mpsc::SyncSender<io::Result<WalkEntry>>) -> bool {
+    let opened = match job.dir {
+        JobDir::Open(dir) => Ok(dir),
+        JobDir::Child(ref parent, ref name) => parent.dir.open_child(name),
+        JobDir::Path => sys::fs2::readdir(&job.path),
+    };
+    let mut dir = match opened {
+        Ok(dir) => dir,
+        Err(e) => return tx.send(Err(e)).is_ok(),
+    };
+
+    let mut subdirs = Vec::new();
+    loop {
+        let (name, file_type) = match dir.next_raw() {
+            None => break,
+            Some(Err(e)) => {
+                if tx.send(Err(e)).is_err() { return false }
+                break
+            }
+            Some(Ok(raw)) => (raw.name_bytes().to_vec(), raw.file_type()),
+        };
+        let file_type = match file_type {
+            Some(t) => t,
+            None => match dir.child_type(&name) {
+                Ok(t) => t,
+                Err(e) => {
+                    if tx.send(Err(e)).is_err() { return false }
+                    continue
+                }
+            },
+        };
+        let entry = WalkEntry {
+            path: job.path.join(<OsStr as OsStrExt>::from_bytes(&name)),
+            file_type: fs::FileType::from_inner(file_type),
+            depth: job.depth + 1,
+        };
+        if let Some(ref filter) = shared.filter {
+            if !(**filter)(&entry) { continue }
+        }
+        if file_type.is_dir() {
+            subdirs.push((name, entry.path.clone()));
+        }
+        if tx.send(Ok(entry)).is_err() { return false }
+    }
+
+    if subdirs.is_empty() {
+        return true
+    }
+    let parent = if shared.open_parents.fetch_add(1, Ordering::SeqCst) <
+                        WALK_MAX_OPEN_PARENTS {
+        dir.release_buffer();
+        Some(Arc::new(ParentDir { dir: dir, count: shared.open_parents.clone() }))
+    } else {
+        shared.open_parents.fetch_sub(1, Ordering::SeqCst);
+        None
+    };
+    shared.pending.fetch_add(subdirs.len(), Ordering::SeqCst);
+    {
+        let mut queue = shared.queues[me].lock().unwrap();
+        for (name, path) in subdirs {
+            let dir = match parent {
+                Some(ref parent) => JobDir::Child(parent.clone(), name),
+                None => JobDir::Path,
+            };
+            queue.push_back(WalkJob { dir: dir, path: path, depth: job.depth + 1 });
+        }
+    }
+    wake_walkers(shared);
+    true
+}
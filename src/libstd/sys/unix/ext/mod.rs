@@ -47,7 +47,7 @@ pub mod prelude {
     #[doc(no_inline)]
     pub use super::fs::{PermissionsExt, OpenOptionsExt, MetadataExt};
     #[doc(no_inline)]
-    pub use super::fs::{DirEntryExt};
+    pub use super::fs::{DirEntryExt, ReadDirExt};
     #[doc(no_inline)] #[stable(feature = "rust1", since = "1.0.0")]
     pub use super::process::{CommandExt, ExitStatusExt};
 }
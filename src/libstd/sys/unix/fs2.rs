@@ -18,7 +18,6 @@ use io::{self, Error, SeekFrom};
 use libc::{self, c_int, size_t, off_t, c_char, mode_t};
 use mem;
 use path::{Path, PathBuf};
-use ptr;
 use sync::Arc;
 use sys::fd::FileDesc;
 use sys::platform::raw;
@@ -35,6 +34,11 @@ pub struct FileAttr {
 pub struct ReadDir {
     dirp: Dir,
     root: Arc<PathBuf>,
+    // On Linux a batch of raw getdents64 records, elsewhere space for a
+    // single dirent_t. Words rather than bytes to keep the records aligned.
+    buf: Vec<u64>,
+    pos: usize,
+    end: usize,
 }
 
 struct Dir(*mut libc::DIR);
@@ -43,8 +47,18 @@ unsafe impl Send for Dir {}
 unsafe impl Sync for Dir {}
 
 pub struct DirEntry {
-    buf: Vec<u8>, // actually *mut libc::dirent_t
     root: Arc<PathBuf>,
+    name: Vec<u8>,
+    ino: raw::ino_t,
+    mode: c_int, // -1 if the directory didn't report the file type
+}
+
+/// A directory entry which borrows its name from the buffer of the `ReadDir`
+/// it was read from, valid until the next call to `ReadDir::next_raw`.
+pub struct RawDirEntry<'a> {
+    name: &'a [u8],
+    ino: raw::ino_t,
+    mode: c_int,
 }
 
 #[derive(Clone)]
@@ -131,20 +145,87 @@ impl FromInner<raw::mode_t> for FilePermissions {
     }
 }
 
-impl Iterator for ReadDir {
-    type Item = io::Result<DirEntry>;
+impl ReadDir {
+    #[cfg(any(target_os = "linux", target_os = "android"))]
+    fn new(dirp: Dir, root: Arc<PathBuf>) -> ReadDir {
+        ReadDir { dirp: dirp, root: root, buf: Vec::with_capacity(4096),
+                  pos: 0, end: 0 }
+    }
 
-    fn next(&mut self) -> Option<io::Result<DirEntry>> {
+    #[cfg(not(any(target_os = "linux", target_os = "android")))]
+    fn new(dirp: Dir, root: Arc<PathBuf>) -> ReadDir {
         extern {
             fn rust_dirent_t_size() -> c_int;
         }
+        let size = unsafe { rust_dirent_t_size() as usize };
+        ReadDir { dirp: dirp, root: root, buf: Vec::with_capacity((size + 7) / 8),
+                  pos: 0, end: 0 }
+    }
+
+    /// Returns the next entry without allocating, refilling the buffer with
+    /// a single `getdents64` call whenever it runs dry.
+    #[cfg(any(target_os = "linux", target_os = "android"))]
+    pub fn next_raw(&mut self) -> Option<io::Result<RawDirEntry>> {
+        if self.buf.capacity() == 0 {
+            return None
+        }
+        // The records are opaque to Rust; ptr points at a `struct rust_dirent64`.
+        extern {
+            fn rust_dir_fill(dirp: *mut libc::DIR, buf: *mut u64,
+                             len: size_t) -> libc::ssize_t;
+            fn rust_dirent64_reclen(ptr: *const u8) -> size_t;
+            fn rust_dirent64_name(ptr: *const u8) -> *const c_char;
+            fn rust_dirent64_mode(ptr: *const u8) -> c_int;
+            fn rust_dirent64_ino(ptr: *const u8) -> u64;
+        }
+
+        loop {
+            if self.pos == self.end {
+                let len = self.buf.capacity() * 8;
+                let n = unsafe {
+                    rust_dir_fill(self.dirp.0, self.buf.as_mut_ptr(), len as size_t)
+                };
+                if n < 0 {
+                    return Some(Err(Error::last_os_error()))
+                }
+                if n == 0 {
+                    return None
+                }
+                self.pos = 0;
+                self.end = n as usize;
+            }
+
+            unsafe {
+                let ptr = (self.buf.as_ptr() as *const u8).offset(self.pos as isize);
+                self.pos += rust_dirent64_reclen(ptr) as usize;
+                let name = CStr::from_ptr(rust_dirent64_name(ptr)).to_bytes();
+                if name == b"." || name == b".." {
+                    continue
+                }
+                return Some(Ok(RawDirEntry {
+                    name: name,
+                    ino: rust_dirent64_ino(ptr) as raw::ino_t,
+                    mode: rust_dirent64_mode(ptr),
+                }))
+            }
+        }
+    }
 
-        let mut buf: Vec<u8> = Vec::with_capacity(unsafe {
-            rust_dirent_t_size() as usize
-        });
-        let ptr = buf.as_mut_ptr() as *mut libc::dirent_t;
+    /// Returns the next entry without allocating, reading it into the
+    /// buffer with `readdir_r`.
+    #[cfg(not(any(target_os = "linux", target_os = "android")))]
+    pub fn next_raw(&mut self) -> Option<io::Result<RawDirEntry>> {
+        if self.buf.capacity() == 0 {
+            return None
+        }
+        extern {
+            fn rust_list_dir_val(ptr: *mut libc::dirent_t) -> *const c_char;
+            fn rust_dir_get_mode(ptr: *mut libc::dirent_t) -> c_int;
+            fn rust_dir_get_ino(ptr: *mut libc::dirent_t) -> raw::ino_t;
+        }
 
-        let mut entry_ptr = ptr::null_mut();
+        let ptr = self.buf.as_mut_ptr() as *mut libc::dirent_t;
+        let mut entry_ptr = ::ptr::null_mut();
         loop {
             if unsafe { libc::readdir_r(self.dirp.0, ptr, &mut entry_ptr) != 0 } {
                 return Some(Err(Error::last_os_error()))
@@ -153,15 +234,102 @@ impl Iterator for ReadDir {
                 return None
             }
 
-            let entry = DirEntry {
-                buf: buf,
-                root: self.root.clone()
-            };
-            if entry.name_bytes() == b"." || entry.name_bytes() == b".." {
-                buf = entry.buf;
-            } else {
-                return Some(Ok(entry))
+            unsafe {
+                let name = CStr::from_ptr(rust_list_dir_val(ptr)).to_bytes();
+                if name == b"." || name == b".." {
+                    continue
+                }
+                return Some(Ok(RawDirEntry {
+                    name: name,
+                    ino: rust_dir_get_ino(ptr),
+                    mode: rust_dir_get_mode(ptr),
+                }))
+            }
+        }
+    }
+}
+
+impl ReadDir {
+    /// The path this directory was opened with.
+    pub fn path(&self) -> &Path { &self.root }
+
+    /// Frees the entry buffer of a directory that has been read to the end.
+    /// It can still be used with `open_child` and `child_type`.
+    pub fn release_buffer(&mut self) {
+        self.buf = Vec::new();
+        self.pos = 0;
+        self.end = 0;
+    }
+
+    /// Opens the subdirectory `name` of this directory relative to its open
+    /// descriptor, without following symlinks. Falls back to opening the
+    /// full path where `openat` is unavailable.
+    pub fn open_child(&self, name: &[u8]) -> io::Result<ReadDir> {
+        extern {
+            fn rust_opendirat(dirp: *mut libc::DIR,
+                              name: *const c_char) -> *mut libc::DIR;
+        }
+        let root = Arc::new(self.root.join(<OsStr as OsStrExt>::from_bytes(name)));
+        let name = try!(CString::new(name));
+        let ptr = unsafe { rust_opendirat(self.dirp.0, name.as_ptr()) };
+        if !ptr.is_null() {
+            return Ok(ReadDir::new(Dir(ptr), root))
+        }
+        let err = Error::last_os_error();
+        if err.raw_os_error() == Some(libc::ENOSYS) {
+            readdir(&root)
+        } else {
+            Err(err)
+        }
+    }
+
+    /// Looks up the type of the entry `name` of this directory with `fstatat`
+    /// relative to its descriptor, without following symlinks.
+    pub fn child_type(&self, name: &[u8]) -> io::Result<FileType> {
+        extern {
+            fn rust_dir_lstat_mode(dirp: *mut libc::DIR,
+                                   name: *const c_char) -> c_int;
+        }
+        let cname = try!(CString::new(name));
+        match unsafe { rust_dir_lstat_mode(self.dirp.0, cname.as_ptr()) } {
+            -1 => {
+                let err = Error::last_os_error();
+                if err.raw_os_error() == Some(libc::ENOSYS) {
+                    let path = self.root.join(<OsStr as OsStrExt>::from_bytes(name));
+                    lstat(&path).map(|m| m.file_type())
+                } else {
+                    Err(err)
+                }
             }
+            n => Ok(FileType { mode: n as mode_t }),
+        }
+    }
+}
+
+impl Iterator for ReadDir {
+    type Item = io::Result<DirEntry>;
+
+    fn next(&mut self) -> Option<io::Result<DirEntry>> {
+        let root = self.root.clone();
+        self.next_raw().map(|entry| entry.map(|raw| DirEntry {
+            root: root,
+            name: raw.name.to_vec(),
+            ino: raw.ino,
+            mode: raw.mode,
+        }))
+    }
+}
+
+impl<'a> RawDirEntry<'a> {
+    pub fn name_bytes(&self) -> &'a [u8] { self.name }
+    pub fn ino(&self) -> raw::ino_t { self.ino }
+
+    /// The file type reported by the directory listing, if any. Unlike
+    /// `DirEntry::file_type` this never falls back to `lstat`.
+    pub fn file_type(&self) -> Option<FileType> {
+        match self.mode {
+            -1 => None,
+            n => Some(FileType { mode: n as mode_t }),
         }
     }
 }
@@ -187,36 +355,15 @@ impl DirEntry {
     }
 
     pub fn file_type(&self) -> io::Result<FileType> {
-        extern {
-            fn rust_dir_get_mode(ptr: *mut libc::dirent_t) -> c_int;
-        }
-        unsafe {
-            match rust_dir_get_mode(self.dirent()) {
-                -1 => lstat(&self.path()).map(|m| m.file_type()),
-                n => Ok(FileType { mode: n as mode_t }),
-            }
-        }
-    }
-
-    pub fn ino(&self) -> raw::ino_t {
-        extern {
-            fn rust_dir_get_ino(ptr: *mut libc::dirent_t) -> raw::ino_t;
+        match self.mode {
+            -1 => lstat(&self.path()).map(|m| m.file_type()),
+            n => Ok(FileType { mode: n as mode_t }),
         }
-        unsafe { rust_dir_get_ino(self.dirent()) }
     }
 
-    fn name_bytes(&self) -> &[u8] {
-        extern {
-            fn rust_list_dir_val(ptr: *mut libc::dirent_t) -> *const c_char;
-        }
-        unsafe {
-            CStr::from_ptr(rust_list_dir_val(self.dirent())).to_bytes()
-        }
-    }
+    pub fn ino(&self) -> raw::ino_t { self.ino }
 
-    fn dirent(&self) -> *mut libc::dirent_t {
-        self.buf.as_ptr() as *mut _
-    }
+    fn name_bytes(&self) -> &[u8] { &self.name }
 }
 
 impl OpenOptions {
@@ -427,7 +574,7 @@ pub fn readdir(p: &Path) -> io::Result<ReadDir> {
         if ptr.is_null() {
             Err(Error::last_os_error())
         } else {
-            Ok(ReadDir { dirp: Dir(ptr), root: root })
+            Ok(ReadDir::new(Dir(ptr), root))
         }
     }
 }
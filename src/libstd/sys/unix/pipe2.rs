@@ -44,6 +44,10 @@ impl AnonPipe {
         self.0.write(buf)
     }
 
+    pub fn raw(&self) -> libc::c_int {
+        self.0.raw()
+    }
+
     pub fn into_fd(self) -> FileDesc {
         self.0
     }
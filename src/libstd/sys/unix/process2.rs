@@ -141,6 +141,17 @@ impl Process {
 
         let (envp, _a, _b) = make_envp(cfg.env.as_ref());
         let (argv, _a) = make_argv(&cfg.program, &cfg.args);
+
+        let spawned = unsafe { posix_spawn(cfg, argv, envp, &in_fd, &out_fd, &err_fd) };
+        match spawned {
+            // `execvp` runs a file which is not a binary and has no `#!` line
+            // with /bin/sh, but `posix_spawnp` does not, so such a file is
+            // given to the fork path.
+            Some(Err(ref e)) if e.raw_os_error() == Some(libc::ENOEXEC) => {}
+            Some(ret) => return ret,
+            None => {}
+        }
+
         let (input, output) = try!(sys::pipe2::anon_pipe());
 
         let pid = unsafe {
@@ -334,6 +345,129 @@ impl Process {
     }
 }
 
+// Spawning with `fork` copies the parent's page tables, which takes a long
+// time for a parent with a lot of memory mapped. `posix_spawnp` avoids the
+// copy, with `vfork` or the like, but it cannot do everything a `Command` can.
+// This returns `None` when the command needs the `fork` path instead.
+#[cfg(any(all(target_os = "linux", not(target_env = "musl")),
+          target_os = "macos",
+          target_os = "freebsd"))]
+unsafe fn posix_spawn(cfg: &Command,
+                      argv: *const *const libc::c_char,
+                      envp: *const c_void,
+                      in_fd: &Stdio,
+                      out_fd: &Stdio,
+                      err_fd: &Stdio) -> Option<io::Result<Process>> {
+    use mem;
+    use sys::c::spawn::*;
+
+    // These need code run in the child between fork and exec.
+    if cfg.uid.is_some() || cfg.gid.is_some() || cfg.detach || cfg.cwd.is_some() {
+        return None
+    }
+
+    // `posix_spawnp` looks the program up in the parent's PATH, not in the
+    // environment given to the child.
+    if let Some(ref vars) = cfg.env {
+        let searches_path = !cfg.program.as_bytes().contains(&b'/');
+        if searches_path && vars.get(OsStr::new("PATH")) != env::var_os("PATH").as_ref() {
+            return None
+        }
+    }
+
+    if !reports_exec_errors() {
+        return None
+    }
+
+    struct FileActions(posix_spawn_file_actions_t);
+
+    impl Drop for FileActions {
+        fn drop(&mut self) {
+            unsafe { posix_spawn_file_actions_destroy(&mut self.0); }
+        }
+    }
+
+    fn cvt_nz(error: c_int) -> io::Result<()> {
+        if error == 0 {
+            Ok(())
+        } else {
+            Err(Error::from_raw_os_error(error))
+        }
+    }
+
+    let mut actions = FileActions(mem::zeroed());
+    if let Err(e) = cvt_nz(posix_spawn_file_actions_init(&mut actions.0)) {
+        mem::forget(actions);
+        return Some(Err(e))
+    }
+
+    let stdio = [(in_fd, libc::STDIN_FILENO),
+                 (out_fd, libc::STDOUT_FILENO),
+                 (err_fd, libc::STDERR_FILENO)];
+    for &(src, dst) in &stdio {
+        let ret = match *src {
+            Stdio::Inherit => 0,
+            Stdio::Piped(ref pipe) => {
+                posix_spawn_file_actions_adddup2(&mut actions.0, pipe.raw(), dst)
+            }
+            // As in `child_after_fork`, ignored stdio is /dev/null.
+            Stdio::None => {
+                let flags = if dst == libc::STDIN_FILENO {
+                    libc::O_RDONLY
+                } else {
+                    libc::O_WRONLY
+                };
+                posix_spawn_file_actions_addopen(&mut actions.0, dst,
+                                                 b"/dev/null\0".as_ptr() as *const _,
+                                                 flags, 0)
+            }
+        };
+        if let Err(e) = cvt_nz(ret) {
+            return Some(Err(e))
+        }
+    }
+
+    let envp = if envp.is_null() {
+        *sys::os::environ()
+    } else {
+        envp as *const *const libc::c_char
+    };
+    let mut pid = 0;
+    let ret = posix_spawnp(&mut pid, *argv, &actions.0, ptr::null(), argv, envp);
+    Some(cvt_nz(ret).map(|()| Process { pid: pid }))
+}
+
+#[cfg(not(any(all(target_os = "linux", not(target_env = "musl")),
+              target_os = "macos",
+              target_os = "freebsd")))]
+unsafe fn posix_spawn(_cfg: &Command,
+                      _argv: *const *const libc::c_char,
+                      _envp: *const c_void,
+                      _in_fd: &Stdio,
+                      _out_fd: &Stdio,
+                      _err_fd: &Stdio) -> Option<io::Result<Process>> {
+    None
+}
+
+// Before 2.24, glibc's `posix_spawn` could not tell the parent that the exec
+// failed, and the child just exited with status 127 instead.
+#[cfg(all(target_os = "linux", not(target_env = "musl")))]
+fn reports_exec_errors() -> bool {
+    use str;
+
+    let version = unsafe { CStr::from_ptr(c::spawn::gnu_get_libc_version()) };
+    let mut parts = version.to_bytes().split(|&b| b == b'.').map(|part| {
+        str::from_utf8(part).ok().and_then(|part| part.parse::<u32>().ok())
+    });
+    match (parts.next(), parts.next()) {
+        (Some(Some(major)), Some(Some(minor))) => (major, minor) >= (2, 24),
+        _ => false,
+    }
+}
+
+#[cfg(any(target_os = "macos", target_os = "freebsd"))]
+fn reports_exec_errors() -> bool { true }
+
 fn make_argv(prog: &CString, args: &[CString])
              -> (*const *const libc::c_char, Vec<*const libc::c_char>)
 {
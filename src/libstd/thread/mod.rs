@@ -474,6 +474,29 @@ pub fn catch_panic<F, R>(f: F) -> Result<R>
     Ok(result.unwrap())
 }
 
+/// Runs `f` on the current thread as though the thread were named `name`.
+///
+/// Within `f`, `thread::current()` returns a fresh handle carrying the new
+/// name, which is also the name reported should `f` panic. The previous
+/// handle is reinstated when `f` returns or unwinds. This lets a long-lived
+/// worker thread run jobs that expect to be told apart by thread name, as
+/// the test harness does.
+#[unstable(feature = "thread_rename",
+           reason = "implementation detail of the test harness")]
+#[doc(hidden)]
+pub fn with_name<F, R>(name: Option<String>, f: F) -> R where F: FnOnce() -> R {
+    struct Reset(Option<Thread>);
+    impl Drop for Reset {
+        fn drop(&mut self) {
+            if let Some(thread) = self.0.take() {
+                thread_info::replace_thread(thread);
+            }
+        }
+    }
+    let _reset = Reset(thread_info::replace_thread(Thread::new(name)));
+    f()
+}
+
 /// Puts the current thread to sleep for the specified amount of time.
 ///
 /// The thread may sleep longer than the duration specified due to scheduling
@@ -751,6 +774,21 @@ mod tests {
         }).unwrap().join();
     }
 
+    #[test]
+    fn test_with_name() {
+        thread::spawn(move|| {
+            thread::with_name(Some("babbage".to_string()), || {
+                assert!(thread::current().name() == Some("babbage"));
+            });
+            assert!(thread::current().name().is_none());
+            let r = thread::catch_panic(|| {
+                thread::with_name(Some("boom".to_string()), || -> () { panic!() })
+            });
+            assert!(r.is_err());
+            assert!(thread::current().name().is_none());
+        }).join().ok().unwrap();
+    }
+
     #[test]
     fn test_run_basic() {
         let (tx, rx) = channel();
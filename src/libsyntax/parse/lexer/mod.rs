@@ -25,6 +25,7 @@ use std::rc::Rc;
 pub use ext::tt::transcribe::{TtReader, new_tt_reader, new_tt_reader_with_doc_flag};
 
 pub mod comments;
+mod scan;
 
 pub trait Reader {
     fn is_eof(&self) -> bool;
@@ -337,6 +338,23 @@ impl<'a> StringReader<'a> {
         }
     }
 
+    /// Advance over a run of characters starting at `curr`, as measured by
+    /// `run` on the remaining source bytes, leaving the last character of the
+    /// run in `curr`. `run` must only accept ASCII characters other than
+    /// `\n`, so that no line or multibyte bookkeeping is skipped.
+    fn bump_run<F>(&mut self, run: F) where F: FnOnce(&[u8]) -> usize {
+        if self.curr.is_none() { return }
+        let offset = self.byte_offset(self.last_pos).to_usize();
+        let n = run(&self.source_text.as_bytes()[offset..]);
+        if n > 1 {
+            let skip = n - 1;
+            self.last_pos = self.last_pos + BytePos(skip as u32);
+            self.pos = self.pos + BytePos(skip as u32);
+            self.col = self.col + CharPos(skip);
+            self.curr = Some(self.source_text.as_bytes()[offset + skip] as char);
+        }
+    }
+
     pub fn nextch(&self) -> Option<char> {
         let offset = self.byte_offset(self.pos).to_usize();
         if offset < self.source_text.len() {
@@ -407,6 +425,7 @@ impl<'a> StringReader<'a> {
                     if self.curr_is('/') || self.curr_is('!') {
                         let start_bpos = self.pos - BytePos(3);
                         while !self.is_eof() {
+                            self.bump_run(|s| scan::plain_run(s, b'\n', b'\r'));
                             match self.curr.unwrap() {
                                 '\n' => break,
                                 '\r' => {
@@ -437,7 +456,10 @@ impl<'a> StringReader<'a> {
                         });
                     } else {
                         let start_bpos = self.last_pos - BytePos(2);
-                        while !self.curr_is('\n') && !self.is_eof() { self.bump(); }
+                        while !self.curr_is('\n') && !self.is_eof() {
+                            self.bump_run(|s| scan::plain_run(s, b'\n', b'\r'));
+                            self.bump();
+                        }
                         return Some(TokenAndSpan {
                             tok: token::Comment,
                             sp: codemap::mk_sp(start_bpos, self.last_pos)
@@ -493,7 +515,10 @@ impl<'a> StringReader<'a> {
             },
             c if is_whitespace(Some(c)) => {
                 let start_bpos = self.last_pos;
-                while is_whitespace(self.curr) { self.bump(); }
+                while is_whitespace(self.curr) {
+                    self.bump_run(scan::blank_run);
+                    self.bump();
+                }
                 let c = Some(TokenAndSpan {
                     tok: token::Whitespace,
                     sp: codemap::mk_sp(start_bpos, self.last_pos)
@@ -523,6 +548,7 @@ impl<'a> StringReader<'a> {
                 let last_bpos = self.last_pos;
                 self.fatal_span_(start_bpos, last_bpos, msg);
             }
+            self.bump_run(|s| scan::plain_run(s, b'*', b'/'));
             let n = self.curr.unwrap();
             match n {
                 '/' if self.nextch_is('*') => {
@@ -1093,6 +1119,7 @@ impl<'a> StringReader<'a> {
                     self.fatal_span_(start_bpos, last_bpos, "unterminated double quote string");
                 }
 
+                self.bump_run(|s| scan::plain_run(s, b'"', b'\\'));
                 let ch_start = self.last_pos;
                 let ch = self.curr.unwrap();
                 self.bump();
@@ -1134,6 +1161,7 @@ impl<'a> StringReader<'a> {
                     let last_bpos = self.last_pos;
                     self.fatal_span_(start_bpos, last_bpos, "unterminated raw string");
                 }
+                self.bump_run(|s| scan::plain_run(s, b'"', b'"'));
                 //if self.curr_is('"') {
                     //content_end_bpos = self.last_pos;
                     //for _ in 0..hash_count {
@@ -0,0 +1,70 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! Word-at-a-time scanning of runs of uninteresting source bytes.
+//!
+//! The lexer steps through whitespace, comments and string literal bodies
+//! one `char` at a time. The helpers here classify a whole machine word of
+//! bytes at once, with the primitives of libserialize's JSON scanner, so
+//! that the long ASCII runs which need no further attention can be skipped
+//! in bulk by `StringReader::bump_run`.
+
+use serialize::scan::{run, eq_bytes, HI};
+
+/// Length of the leading run of spaces and tabs in `s`.
+pub fn blank_run(s: &[u8]) -> usize {
+    run(s,
+        |x| (eq_bytes(x, b' ') | eq_bytes(x, b'\t')) == HI,
+        |c| c == b' ' || c == b'\t')
+}
+
+/// Length of the leading run of ASCII bytes in `s` other than `\n`, `\r`,
+/// `a` and `b`.
+pub fn plain_run(s: &[u8], a: u8, b: u8) -> usize {
+    run(s,
+        |x| ((x & HI) | eq_bytes(x, b'\n') | eq_bytes(x, b'\r') |
+             eq_bytes(x, a) | eq_bytes(x, b)) == 0,
+        |c| c < 0x80 && c != b'\n' && c != b'\r' && c != a && c != b)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_blank_run() {
+        assert_eq!(blank_run(b""), 0);
+        assert_eq!(blank_run(b"x   "), 0);
+        assert_eq!(blank_run(b" \t x"), 3);
+        assert_eq!(blank_run(b"                    \n    "), 20);
+        assert_eq!(blank_run(b"\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"), 17);
+    }
+
+    #[test]
+    fn test_plain_run() {
+        assert_eq!(plain_run(b"", b'"', b'\\'), 0);
+        assert_eq!(plain_run(b"abc\"", b'"', b'\\'), 3);
+        assert_eq!(plain_run(b"a long string body \\n", b'"', b'\\'), 19);
+        assert_eq!(plain_run(b"comment text, still going\n", b'*', b'/'), 25);
+        assert_eq!(plain_run(b"carriage return\r\n", b'*', b'/'), 15);
+        assert_eq!(plain_run("ascii then \u{e9}".as_bytes(), b'"', b'\\'), 11);
+    }
+
+    #[test]
+    fn test_runs_at_every_alignment() {
+        let src = b"    ..............................................*";
+        for start in 0..16 {
+            assert_eq!(plain_run(&src[start..], b'*', b'/'), src.len() - 1 - start);
+        }
+        for start in 0..4 {
+            assert_eq!(blank_run(&src[start..]), 4 - start);
+        }
+    }
+}
@@ -43,6 +43,9 @@
 #![feature(std_misc)]
 #![feature(libc)]
 #![feature(set_stdio)]
+#![feature(num_cpus)]
+#![feature(catch_panic)]
+#![feature(thread_rename)]
 
 extern crate getopts;
 extern crate serialize;
@@ -61,6 +64,7 @@ use self::OutputLocation::*;
 use stats::Stats;
 use getopts::{OptGroup, optflag, optopt};
 use serialize::Encodable;
+use serialize::json;
 use std::boxed::FnBox;
 use term::Terminal;
 use term::color::{Color, RED, YELLOW, GREEN, CYAN};
@@ -74,8 +78,8 @@ use std::fs::File;
 use std::io::prelude::*;
 use std::io;
 use std::iter::repeat;
-use std::path::PathBuf;
-use std::sync::mpsc::{channel, Sender};
+use std::path::{Path, PathBuf};
+use std::sync::mpsc::{channel, Receiver, Sender};
 use std::sync::{Arc, Mutex};
 use std::thread;
 use std::thunk::Thunk;
@@ -92,6 +96,7 @@ pub mod test {
 }
 
 pub mod stats;
+mod perf;
 
 // The name of a test. By convention this follows the rules for rust
 // paths; i.e. it should be a series of identifiers separated by double
@@ -289,6 +294,10 @@ pub struct TestOpts {
     pub logfile: Option<PathBuf>,
     pub nocapture: bool,
     pub color: ColorConfig,
+    pub bench_samples: usize,
+    pub bench_save: Option<PathBuf>,
+    pub bench_baseline: Option<PathBuf>,
+    pub bench_counters: bool,
 }
 
 impl TestOpts {
@@ -302,6 +311,10 @@ impl TestOpts {
             logfile: None,
             nocapture: false,
             color: AutoColor,
+            bench_samples: DEFAULT_BENCH_SAMPLES,
+            bench_save: None,
+            bench_baseline: None,
+            bench_counters: false,
         }
     }
 }
@@ -321,7 +334,16 @@ fn optgroups() -> Vec<getopts::OptGroup> {
       getopts::optopt("", "color", "Configure coloring of output:
             auto   = colorize if stdout is a tty and tests are run on serially (default);
             always = always colorize output;
-            never  = never colorize output;", "auto|always|never"))
+            never  = never colorize output;", "auto|always|never"),
+      getopts::optopt("", "bench-samples", "Number of timings to take of each \
+                          benchmark per round (default 50)", "N"),
+      getopts::optopt("", "bench-save", "Save benchmark results to PATH as JSON, \
+                          or as CSV if PATH ends in .csv", "PATH"),
+      getopts::optopt("", "bench-baseline", "Compare benchmarks against results \
+                          saved as JSON in PATH, failing if any got slower", "PATH"),
+      getopts::optflag("", "bench-counters", "Also report hardware counters (cycles, \
+                           instructions, cache and branch misses) per iteration, \
+                           where the platform makes them available"))
 }
 
 fn usage(binary: &str) {
@@ -396,6 +418,17 @@ pub fn parse_opts(args: &[String]) -> Option<OptRes> {
                                             v))),
     };
 
+    let bench_samples = match matches.opt_str("bench-samples") {
+        Some(s) => match s.parse::<usize>() {
+            Ok(n) if n >= 2 => n,
+            _ => return Some(Err(format!("argument for --bench-samples must be \
+                                          an integer of at least 2 (was {})", s))),
+        },
+        None => DEFAULT_BENCH_SAMPLES,
+    };
+    let bench_save = matches.opt_str("bench-save").map(|s| PathBuf::from(&s));
+    let bench_baseline = matches.opt_str("bench-baseline").map(|s| PathBuf::from(&s));
+
     let test_opts = TestOpts {
         filter: filter,
         run_ignored: run_ignored,
@@ -404,6 +437,10 @@ pub fn parse_opts(args: &[String]) -> Option<OptRes> {
         logfile: logfile,
         nocapture: nocapture,
         color: color,
+        bench_samples: bench_samples,
+        bench_save: bench_save,
+        bench_baseline: bench_baseline,
+        bench_counters: matches.opt_present("bench-counters"),
     };
 
     Some(Ok(test_opts))
@@ -412,7 +449,90 @@ pub fn parse_opts(args: &[String]) -> Option<OptRes> {
 #[derive(Clone, PartialEq)]
 pub struct BenchSamples {
     ns_iter_summ: stats::Summary,
+    ns_iter_ci: (f64, f64),
+    mb_s: usize,
+    counters: Vec<(&'static str, f64)>, // hardware counts per iteration
+}
+
+/// The number of timings taken of a benchmark per round by default.
+pub const DEFAULT_BENCH_SAMPLES: usize = 50;
+
+/// The outcome of one benchmark, as saved by `--bench-save` and read back by
+/// `--bench-baseline`. Times are in nanoseconds per iteration; `ci_low` and
+/// `ci_high` bound the 95% confidence interval of the median. The hardware
+/// counts per iteration are only there with `--bench-counters`, and for the
+/// counters the machine offers.
+#[derive(Clone, RustcEncodable, RustcDecodable, PartialEq, Debug)]
+struct BenchRecord {
+    name: String,
+    median: f64,
+    ci_low: f64,
+    ci_high: f64,
+    mean: f64,
+    min: f64,
+    max: f64,
+    median_abs_dev: f64,
     mb_s: usize,
+    cycles: Option<f64>,
+    instructions: Option<f64>,
+    cache_misses: Option<f64>,
+    branch_misses: Option<f64>,
+}
+
+impl BenchRecord {
+    fn new(desc: &TestDesc, bs: &BenchSamples) -> BenchRecord {
+        let summ = &bs.ns_iter_summ;
+        let counter = |name: &str| {
+            bs.counters.iter().find(|&&(n, _)| n == name).map(|&(_, count)| count)
+        };
+        BenchRecord {
+            name: desc.name.to_string(),
+            median: summ.median,
+            ci_low: bs.ns_iter_ci.0,
+            ci_high: bs.ns_iter_ci.1,
+            mean: summ.mean,
+            min: summ.min,
+            max: summ.max,
+            median_abs_dev: summ.median_abs_dev,
+            mb_s: bs.mb_s,
+            cycles: counter("cycles"),
+            instructions: counter("instructions"),
+            cache_misses: counter("cache-misses"),
+            branch_misses: counter("branch-misses"),
+        }
+    }
+}
+
+fn save_bench_records(path: &Path, records: &[BenchRecord]) -> io::Result<()> {
+    // Counts that were not taken are left empty in CSV.
+    fn count(n: Option<f64>) -> String {
+        n.map(|n| n.to_string()).unwrap_or(String::new())
+    }
+
+    let mut file = try!(File::create(path));
+    if path.extension().and_then(|e| e.to_str()) != Some("csv") {
+        let s = json::encode(&records).unwrap();
+        return file.write_all(s.as_bytes());
+    }
+    try!(writeln!(file, "name,median,ci_low,ci_high,mean,min,max,median_abs_dev,mb_s,\
+                         cycles,instructions,cache_misses,branch_misses"));
+    for r in records {
+        try!(writeln!(file, "\"{}\",{},{},{},{},{},{},{},{},{},{},{},{}",
+                      r.name.replace("\"", "\"\""), r.median, r.ci_low, r.ci_high,
+                      r.mean, r.min, r.max, r.median_abs_dev, r.mb_s,
+                      count(r.cycles), count(r.instructions), count(r.cache_misses),
+                      count(r.branch_misses)));
+    }
+    Ok(())
+}
+
+fn load_bench_records(path: &Path) -> io::Result<Vec<BenchRecord>> {
+    let mut s = String::new();
+    try!(try!(File::open(path)).read_to_string(&mut s));
+    json::decode(&s).map_err(|e| {
+        io::Error::new(io::ErrorKind::InvalidInput,
+                       format!("malformed benchmark baseline {}: {}", path.display(), e))
+    })
 }
 
 #[derive(Clone, PartialEq)]
@@ -442,6 +562,7 @@ struct ConsoleTestState<T> {
     measured: usize,
     metrics: MetricMap,
     failures: Vec<(TestDesc, Vec<u8> )> ,
+    benches: Vec<BenchRecord>,
     max_name_len: usize, // number of columns to fill when aligning names
 }
 
@@ -468,6 +589,7 @@ impl<T: Write> ConsoleTestState<T> {
             measured: 0,
             metrics: MetricMap::new(),
             failures: Vec::new(),
+            benches: Vec::new(),
             max_name_len: 0,
         })
     }
@@ -601,6 +723,44 @@ impl<T: Write> ConsoleTestState<T> {
         Ok(())
     }
 
+    /// Lists the benchmarks whose confidence intervals moved clear of those
+    /// recorded in `baseline`. Returns whether any of them got slower.
+    fn write_bench_comparison(&mut self, baseline: &[BenchRecord]) -> io::Result<bool> {
+        let by_name: BTreeMap<&str, &BenchRecord> = baseline.iter()
+                                                            .map(|r| (&r.name[..], r))
+                                                            .collect();
+        let mut regressed = Vec::new();
+        let mut improved = Vec::new();
+        for new in &self.benches {
+            let old = match by_name.get(&new.name[..]) {
+                Some(old) => *old,
+                None => continue,
+            };
+            let line = format!("    {}: {} -> {} ns/iter ({:+.1}%)\n",
+                               new.name, old.median as u64, new.median as u64,
+                               (new.median - old.median) * 100.0 / old.median.max(1.0));
+            if new.ci_low > old.ci_high {
+                regressed.push(line);
+            } else if new.ci_high < old.ci_low {
+                improved.push(line);
+            }
+        }
+
+        if !improved.is_empty() {
+            try!(self.write_plain("\nbenchmarks improved on the baseline:\n"));
+            for line in &improved {
+                try!(self.write_plain(line));
+            }
+        }
+        if !regressed.is_empty() {
+            try!(self.write_plain("\nbenchmarks regressed from the baseline:\n"));
+            for line in &regressed {
+                try!(self.write_plain(line));
+            }
+        }
+        Ok(!regressed.is_empty())
+    }
+
     pub fn write_run_finish(&mut self) -> io::Result<bool> {
         assert!(self.passed + self.failed + self.ignored + self.measured == self.total);
 
@@ -624,7 +784,7 @@ impl<T: Write> ConsoleTestState<T> {
 }
 
 pub fn fmt_bench_samples(bs: &BenchSamples) -> String {
-    if bs.mb_s != 0 {
+    let mut s = if bs.mb_s != 0 {
         format!("{:>9} ns/iter (+/- {}) = {} MB/s",
              bs.ns_iter_summ.median as usize,
              (bs.ns_iter_summ.max - bs.ns_iter_summ.min) as usize,
@@ -633,7 +793,14 @@ pub fn fmt_bench_samples(bs: &BenchSamples) -> String {
         format!("{:>9} ns/iter (+/- {})",
              bs.ns_iter_summ.median as usize,
              (bs.ns_iter_summ.max - bs.ns_iter_summ.min) as usize)
+    };
+    if !bs.counters.is_empty() {
+        let counts: Vec<String> = bs.counters.iter()
+                                    .map(|&(name, n)| format!("{:.1} {}", n, name))
+                                    .collect();
+        s.push_str(&format!(" ({} per iter)", counts.connect(", ")));
     }
+    s
 }
 
 // A simple console test runner
@@ -667,6 +834,7 @@ pub fn run_tests_console(opts: &TestOpts, tests: Vec<TestDescAndFn> ) -> io::Res
                         st.metrics.insert_metric(test.name.as_slice(),
                                                  bs.ns_iter_summ.median,
                                                  bs.ns_iter_summ.max - bs.ns_iter_summ.min);
+                        st.benches.push(BenchRecord::new(&test, &bs));
                         st.measured += 1
                     }
                     TrFailed => {
@@ -693,8 +861,20 @@ pub fn run_tests_console(opts: &TestOpts, tests: Vec<TestDescAndFn> ) -> io::Res
         },
         None => {}
     }
+    let baseline = match opts.bench_baseline {
+        Some(ref path) => Some(try!(load_bench_records(path))),
+        None => None,
+    };
     try!(run_tests(opts, tests, |x| callback(&x, &mut st)));
-    return st.write_run_finish();
+    if let Some(ref path) = opts.bench_save {
+        try!(save_bench_records(path, &st.benches));
+    }
+    let regressed = match baseline {
+        Some(ref baseline) => try!(st.write_bench_comparison(baseline)),
+        None => false,
+    };
+    let success = try!(st.write_run_finish());
+    return Ok(success && !regressed);
 }
 
 #[test]
@@ -722,7 +902,8 @@ fn should_sort_failures_before_printing_them() {
         measured: 0,
         max_name_len: 10,
         metrics: MetricMap::new(),
-        failures: vec!((test_b, Vec::new()), (test_a, Vec::new()))
+        failures: vec!((test_b, Vec::new()), (test_a, Vec::new())),
+        benches: Vec::new(),
     };
 
     st.write_failures().unwrap();
@@ -802,6 +983,7 @@ fn run_tests<F>(opts: &TestOpts,
     let mut pending = 0;
 
     let (tx, rx) = channel::<MonitorMsg>();
+    let pool = TestPool::new(concurrency, opts.nocapture, tx.clone());
 
     while pending > 0 || !remaining.is_empty() {
         while pending < concurrency && !remaining.is_empty() {
@@ -812,7 +994,7 @@ fn run_tests<F>(opts: &TestOpts,
                 // that hang forever.
                 try!(callback(TeWait(test.desc.clone(), test.testfn.padding())));
             }
-            run_test(opts, !opts.run_tests, test, tx.clone());
+            pool.run(opts, !opts.run_tests, test);
             pending += 1;
         }
 
@@ -823,6 +1005,7 @@ fn run_tests<F>(opts: &TestOpts,
         try!(callback(TeResult(desc, result, stdout)));
         pending -= 1;
     }
+    drop(pool);
 
     // All benchmarks run at the end, in serial.
     // (this includes metric fns)
@@ -849,8 +1032,7 @@ fn get_concurrency() -> usize {
             if std::rt::util::limit_thread_creation_due_to_osx_and_valgrind() {
                 1
             } else {
-                extern { fn rust_get_num_cpus() -> libc::uintptr_t; }
-                unsafe { rust_get_num_cpus() as usize }
+                env::num_cpus()
             }
         }
     }
@@ -893,6 +1075,105 @@ pub fn filter_tests(opts: &TestOpts, tests: Vec<TestDescAndFn>) -> Vec<TestDescA
     filtered
 }
 
+fn test_thread_name(name: &TestName) -> String {
+    match *name {
+        DynTestName(ref name) => name.clone().to_string(),
+        StaticTestName(name) => name.to_string(),
+    }
+}
+
+/// Collects the output of a test when it is being captured.
+struct Sink(Arc<Mutex<Vec<u8>>>);
+
+impl Write for Sink {
+    fn write(&mut self, data: &[u8]) -> io::Result<usize> {
+        Write::write(&mut *self.0.lock().unwrap(), data)
+    }
+    fn flush(&mut self) -> io::Result<()> { Ok(()) }
+}
+
+type TestJob = (TestDesc, Thunk<'static>);
+
+/// A fixed set of worker threads running tests off a shared queue.
+///
+/// Spawning a thread (two, in fact) per test dominates the running time of
+/// suites made of many small tests, so the workers are started once and run
+/// tests one after another. Each test still runs under its own name, has its
+/// panic caught on its own and gets its own output capture, but thread-local
+/// state lives on from one test to the next on the same worker.
+struct TestPool {
+    jobs: Option<Sender<TestJob>>,
+    workers: Vec<thread::JoinHandle<()>>,
+    monitor_ch: Sender<MonitorMsg>,
+}
+
+impl TestPool {
+    fn new(threads: usize, nocapture: bool, monitor_ch: Sender<MonitorMsg>) -> TestPool {
+        let (tx, rx) = channel::<TestJob>();
+        let rx = Arc::new(Mutex::new(rx));
+        let workers = (0..threads).map(|i| {
+            let rx = rx.clone();
+            let monitor_ch = monitor_ch.clone();
+            thread::Builder::new().name(format!("test-worker-{}", i)).spawn(move || {
+                TestPool::work(rx, monitor_ch, nocapture)
+            }).unwrap()
+        }).collect();
+        TestPool { jobs: Some(tx), workers: workers, monitor_ch: monitor_ch }
+    }
+
+    /// Queues a test, sending its result to the monitor channel once run.
+    /// Anything other than a plain test is run right away by `run_test`.
+    fn run(&self, opts: &TestOpts, force_ignore: bool, test: TestDescAndFn) {
+        let TestDescAndFn { desc, testfn } = test;
+        let testfn: Thunk<'static> = match testfn {
+            _ if force_ignore || desc.ignore => {
+                self.monitor_ch.send((desc, TrIgnored, Vec::new())).unwrap();
+                return;
+            }
+            DynTestFn(f) => f,
+            StaticTestFn(f) => Box::new(move|| f()),
+            testfn => {
+                let test = TestDescAndFn { desc: desc, testfn: testfn };
+                return run_test(opts, force_ignore, test, self.monitor_ch.clone());
+            }
+        };
+        self.jobs.as_ref().unwrap().send((desc, testfn)).unwrap();
+    }
+
+    fn work(jobs: Arc<Mutex<Receiver<TestJob>>>,
+            monitor_ch: Sender<MonitorMsg>,
+            nocapture: bool) {
+        loop {
+            let job = jobs.lock().unwrap().recv();
+            let (desc, testfn) = match job {
+                Ok(job) => job,
+                Err(..) => break,
+            };
+            let data = Arc::new(Mutex::new(Vec::new()));
+            if !nocapture {
+                io::set_print(box Sink(data.clone()));
+                io::set_panic(box Sink(data.clone()));
+            }
+            let result = thread::with_name(Some(test_thread_name(&desc.name)), || {
+                thread::catch_panic(move || testfn())
+            });
+            let test_result = calc_result(&desc, result);
+            let stdout = data.lock().unwrap().to_vec();
+            monitor_ch.send((desc, test_result, stdout)).unwrap();
+        }
+    }
+}
+
+impl Drop for TestPool {
+    fn drop(&mut self) {
+        // Hanging up the queue makes idle workers exit.
+        drop(self.jobs.take());
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
+}
+
 pub fn run_test(opts: &TestOpts,
                 force_ignore: bool,
                 test: TestDescAndFn,
@@ -909,21 +1190,10 @@ pub fn run_test(opts: &TestOpts,
                       monitor_ch: Sender<MonitorMsg>,
                       nocapture: bool,
                       testfn: Thunk<'static>) {
-        struct Sink(Arc<Mutex<Vec<u8>>>);
-        impl Write for Sink {
-            fn write(&mut self, data: &[u8]) -> io::Result<usize> {
-                Write::write(&mut *self.0.lock().unwrap(), data)
-            }
-            fn flush(&mut self) -> io::Result<()> { Ok(()) }
-        }
-
         thread::spawn(move || {
             let data = Arc::new(Mutex::new(Vec::new()));
             let data2 = data.clone();
-            let cfg = thread::Builder::new().name(match desc.name {
-                DynTestName(ref name) => name.clone().to_string(),
-                StaticTestName(name) => name.to_string(),
-            });
+            let cfg = thread::Builder::new().name(test_thread_name(&desc.name));
 
             let result_guard = cfg.spawn(move || {
                 if !nocapture {
@@ -940,12 +1210,14 @@ pub fn run_test(opts: &TestOpts,
 
     match testfn {
         DynBenchFn(bencher) => {
-            let bs = ::bench::benchmark(|harness| bencher.run(harness));
+            let bs = ::bench::benchmark_samples(opts.bench_samples, opts.bench_counters,
+                                                |harness| bencher.run(harness));
             monitor_ch.send((desc, TrBench(bs), Vec::new())).unwrap();
             return;
         }
         StaticBenchFn(benchfn) => {
-            let bs = ::bench::benchmark(|harness| (benchfn.clone())(harness));
+            let bs = ::bench::benchmark_samples(opts.bench_samples, opts.bench_counters,
+                                                |harness| (benchfn.clone())(harness));
             monitor_ch.send((desc, TrBench(bs), Vec::new())).unwrap();
             return;
         }
@@ -1038,12 +1310,14 @@ pub fn black_box<T>(dummy: T) -> T {
 impl Bencher {
     /// Callback for benchmark functions to run in their body.
     pub fn iter<T, F>(&mut self, mut inner: F) where F: FnMut() -> T {
+        perf::start();
         self.dur = Duration::span(|| {
             let k = self.iterations;
             for _ in 0..k {
                 black_box(inner());
             }
         });
+        perf::stop();
     }
 
     pub fn ns_elapsed(&mut self) -> u64 {
@@ -1064,7 +1338,15 @@ impl Bencher {
     }
 
     // This is a more statistics-driven benchmark algorithm
-    pub fn auto_bench<F>(&mut self, mut f: F) -> stats::Summary where F: FnMut(&mut Bencher) {
+    pub fn auto_bench<F>(&mut self, f: F) -> stats::Summary where F: FnMut(&mut Bencher) {
+        self.sample_bench(DEFAULT_BENCH_SAMPLES, f).0
+    }
+
+    /// Like `auto_bench`, taking `nsamples` timings per round. Also returns
+    /// the (winsorized) timings of the final round.
+    pub fn sample_bench<F>(&mut self, nsamples: usize, mut f: F) -> (stats::Summary, Vec<f64>)
+        where F: FnMut(&mut Bencher)
+    {
         // Initial bench run to get ballpark figure.
         let mut n = 1;
         self.bench_n(n, |x| f(x));
@@ -1084,28 +1366,28 @@ impl Bencher {
         if n == 0 { n = 1; }
 
         let mut total_run = Duration::nanoseconds(0);
-        let samples : &mut [f64] = &mut [0.0_f64; 50];
+        let mut samples = vec![0.0_f64; nsamples];
         loop {
             let mut summ = None;
             let mut summ5 = None;
 
             let loop_run = Duration::span(|| {
 
-                for p in &mut *samples {
+                for p in &mut samples {
                     self.bench_n(n, |x| f(x));
                     *p = self.ns_per_iter() as f64;
                 };
 
-                stats::winsorize(samples, 5.0);
-                summ = Some(stats::Summary::new(samples));
+                stats::winsorize(&mut samples, 5.0);
+                summ = Some(stats::Summary::new(&samples));
 
-                for p in &mut *samples {
+                for p in &mut samples {
                     self.bench_n(5 * n, |x| f(x));
                     *p = self.ns_per_iter() as f64;
                 };
 
-                stats::winsorize(samples, 5.0);
-                summ5 = Some(stats::Summary::new(samples));
+                stats::winsorize(&mut samples, 5.0);
+                summ5 = Some(stats::Summary::new(&samples));
             });
             let summ = summ.unwrap();
             let summ5 = summ5.unwrap();
@@ -1115,13 +1397,13 @@ impl Bencher {
             if loop_run.num_milliseconds() > 100 &&
                 summ.median_abs_dev_pct < 1.0 &&
                 summ.median - summ5.median < summ5.median_abs_dev {
-                return summ5;
+                return (summ5, samples);
             }
 
             total_run = total_run + loop_run;
             // Longest we ever run for is 3s.
             if total_run.num_seconds() > 3 {
-                return summ5;
+                return (summ5, samples);
             }
 
             // If we overflow here just return the results so far. We check a
@@ -1130,7 +1412,7 @@ impl Bencher {
             // the summ5 result)
             n = match n.checked_mul(10) {
                 Some(_) => n * 2,
-                None => return summ5,
+                None => return (summ5, samples),
             };
         }
     }
@@ -1139,16 +1421,47 @@ impl Bencher {
 pub mod bench {
     use std::cmp;
     use std::time::Duration;
-    use super::{Bencher, BenchSamples};
+    use perf;
+    use stats;
+    use super::{Bencher, BenchSamples, DEFAULT_BENCH_SAMPLES};
+
+    /// Resamples drawn to estimate the confidence interval of the median.
+    const BOOTSTRAP_RESAMPLES: usize = 1000;
 
     pub fn benchmark<F>(f: F) -> BenchSamples where F: FnMut(&mut Bencher) {
+        benchmark_samples(DEFAULT_BENCH_SAMPLES, false, f)
+    }
+
+    /// Runs a benchmark taking `nsamples` timings per round. If `counters`
+    /// is set and hardware counters are available, one more run at the
+    /// final iteration count is made with the counters read around it.
+    pub fn benchmark_samples<F>(nsamples: usize, counters: bool, mut f: F) -> BenchSamples
+        where F: FnMut(&mut Bencher)
+    {
         let mut bs = Bencher {
             iterations: 0,
             dur: Duration::nanoseconds(0),
             bytes: 0
         };
 
-        let ns_iter_summ = bs.auto_bench(f);
+        let (ns_iter_summ, samples) = bs.sample_bench(nsamples, |x| f(x));
+        let ns_iter_ci = stats::bootstrap_median_ci(&samples, BOOTSTRAP_RESAMPLES, 95.0);
+
+        // Counting is kept out of the timed runs above, so that starting
+        // and stopping the counters does not show up in the timings.
+        let mut per_iter = Vec::new();
+        if counters {
+            if let Some(counters) = perf::Counters::open() {
+                perf::install(counters);
+                let n = cmp::max(bs.iterations, 1);
+                bs.bench_n(n, |x| f(x));
+                // The counters are closed once read.
+                let counters = perf::uninstall().unwrap();
+                per_iter = counters.values().into_iter()
+                                   .map(|(name, count)| (name, count as f64 / n as f64))
+                                   .collect();
+            }
+        }
 
         let ns_iter = cmp::max(ns_iter_summ.median as u64, 1);
         let iter_s = 1_000_000_000 / ns_iter;
@@ -1156,7 +1469,9 @@ pub mod bench {
 
         BenchSamples {
             ns_iter_summ: ns_iter_summ,
-            mb_s: mb_s as usize
+            ns_iter_ci: ns_iter_ci,
+            mb_s: mb_s as usize,
+            counters: per_iter,
         }
     }
 }
@@ -1167,6 +1482,7 @@ mod tests {
                TestDesc, TestDescAndFn, TestOpts, run_test,
                MetricMap,
                StaticTestName, DynTestName, DynTestFn, ShouldPanic};
+    use std::path::PathBuf;
     use std::thunk::Thunk;
     use std::sync::mpsc::channel;
 
@@ -1284,6 +1600,25 @@ mod tests {
         assert!((opts.run_ignored));
     }
 
+    #[test]
+    fn parse_bench_flags() {
+        let args = vec!("progname".to_string(),
+                        "--bench".to_string(),
+                        "--bench-samples".to_string(), "200".to_string(),
+                        "--bench-save".to_string(), "out.csv".to_string());
+        let opts = match parse_opts(&args) {
+            Some(Ok(o)) => o,
+            _ => panic!("Malformed arg in parse_bench_flags")
+        };
+        assert_eq!(opts.bench_samples, 200);
+        assert_eq!(opts.bench_save, Some(PathBuf::from("out.csv")));
+        assert_eq!(opts.bench_baseline, None);
+
+        let args = vec!("progname".to_string(),
+                        "--bench-samples".to_string(), "1".to_string());
+        assert!(parse_opts(&args).unwrap().is_err());
+    }
+
     #[test]
     pub fn filter_for_ignored_option() {
         // When we run ignored tests the test filter should filter out all the
@@ -0,0 +1,139 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+//! Hardware performance counters read around benchmark loops.
+//!
+//! The counters are opened through `perf_event_open` by helpers in the
+//! runtime. Elsewhere, or when the kernel or the hardware does not offer
+//! them (as is common in virtual machines), no counters open and benchmarks
+//! report wall time alone.
+
+use libc::c_int;
+use std::cell::RefCell;
+
+/// The number of counters read.
+pub const COUNTERS: usize = 4;
+
+/// The names of the counters, in the order the runtime opens them.
+pub const NAMES: [&'static str; COUNTERS] =
+    ["cycles", "instructions", "cache-misses", "branch-misses"];
+
+extern {
+    fn rust_perf_open(fds: *mut c_int, n: c_int) -> c_int;
+    fn rust_perf_start(fds: *const c_int, n: c_int);
+    fn rust_perf_stop(fds: *const c_int, n: c_int, values: *mut u64);
+    fn rust_perf_close(fds: *const c_int, n: c_int);
+}
+
+thread_local!(static RUNNING: RefCell<Option<Counters>> = RefCell::new(None));
+
+/// Counters of the thread that opened them, closed when dropped. A counter
+/// that could not be opened has a descriptor of -1.
+pub struct Counters {
+    fds: [c_int; COUNTERS],
+    values: [u64; COUNTERS],
+}
+
+impl Counters {
+    /// Opens whichever counters are available, returning `None` if there
+    /// are none.
+    pub fn open() -> Option<Counters> {
+        let mut fds = [-1; COUNTERS];
+        let opened = unsafe { rust_perf_open(fds.as_mut_ptr(), COUNTERS as c_int) };
+        if opened == 0 {
+            return None
+        }
+        Some(Counters { fds: fds, values: [0; COUNTERS] })
+    }
+
+    /// Resets the counters and starts counting.
+    pub fn start(&mut self) {
+        unsafe { rust_perf_start(self.fds.as_ptr(), COUNTERS as c_int) }
+    }
+
+    /// Stops counting, keeping the counts since `start`.
+    pub fn stop(&mut self) {
+        unsafe {
+            rust_perf_stop(self.fds.as_ptr(), COUNTERS as c_int, self.values.as_mut_ptr())
+        }
+    }
+
+    /// The names and counts of the available counters from the last
+    /// `start`/`stop` pair.
+    pub fn values(&self) -> Vec<(&'static str, u64)> {
+        (0..COUNTERS).filter(|&i| self.fds[i] >= 0)
+                     .map(|i| (NAMES[i], self.values[i]))
+                     .collect()
+    }
+}
+
+/// Makes `counters` the ones `Bencher::iter` reads on this thread, until
+/// they are handed back by `uninstall`. A `Bencher` is `Copy`, so it cannot
+/// hold them itself.
+pub fn install(counters: Counters) {
+    RUNNING.with(|running| *running.borrow_mut() = Some(counters));
+}
+
+/// Takes back the counters installed on this thread, if any.
+pub fn uninstall() -> Option<Counters> {
+    RUNNING.with(|running| running.borrow_mut().take())
+}
+
+/// Starts the counters installed on this thread, if any.
+pub fn start() {
+    RUNNING.with(|running| {
+        if let Some(ref mut counters) = *running.borrow_mut() {
+            counters.start();
+        }
+    })
+}
+
+/// Stops the counters installed on this thread, if any.
+pub fn stop() {
+    RUNNING.with(|running| {
+        if let Some(ref mut counters) = *running.borrow_mut() {
+            counters.stop();
+        }
+    })
+}
+
+impl Drop for Counters {
+    fn drop(&mut self) {
+        unsafe { rust_perf_close(self.fds.as_ptr(), COUNTERS as c_int) }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::{Counters, install, uninstall, start, stop};
+
+    #[test]
+    fn counters_open_or_fall_back() {
+        if let Some(mut counters) = Counters::open() {
+            counters.start();
+            counters.stop();
+            assert!(!counters.values().is_empty());
+        }
+    }
+
+    #[test]
+    fn installed_counters_are_handed_back() {
+        start();
+        stop();
+        assert!(uninstall().is_none());
+        if let Some(counters) = Counters::open() {
+            install(counters);
+            start();
+            stop();
+            assert!(!uninstall().unwrap().values().is_empty());
+            assert!(uninstall().is_none());
+        }
+    }
+}
@@ -326,12 +326,51 @@ pub fn winsorize(samples: &mut [f64], pct: f64) {
     }
 }
 
+/// Estimate a confidence interval for the median of a sample set by bootstrap
+/// resampling: the median is recomputed over `resamples` sets drawn with
+/// replacement from `samples`, and the bounds of the central `confidence`
+/// percent of those medians are returned.
+///
+/// The resampling is seeded with a fixed value so that repeated runs over the
+/// same samples report the same interval.
+///
+/// See: http://en.wikipedia.org/wiki/Bootstrapping_(statistics)
+pub fn bootstrap_median_ci(samples: &[f64], resamples: usize, confidence: f64) -> (f64, f64) {
+    assert!(!samples.is_empty());
+    assert!(resamples > 0);
+    assert!(0.0 < confidence && confidence <= 100.0);
+
+    // A xorshift generator is plenty for picking sample indices.
+    let mut state = 0x2545f4914f6cdd1du64;
+    let mut next = || {
+        state = state ^ (state << 13);
+        state = state ^ (state >> 7);
+        state = state ^ (state << 17);
+        state
+    };
+
+    let n = samples.len();
+    let mut resample = vec![0.0; n];
+    let mut medians = Vec::with_capacity(resamples);
+    for _ in 0..resamples {
+        for r in &mut resample {
+            *r = samples[(next() % n as u64) as usize];
+        }
+        local_sort(&mut resample);
+        medians.push(percentile_of_sorted(&resample, 50.0));
+    }
+    local_sort(&mut medians);
+    let tail = (100.0 - confidence) / 2.0;
+    (percentile_of_sorted(&medians, tail), percentile_of_sorted(&medians, 100.0 - tail))
+}
+
 // Test vectors generated from R, using the script src/etc/stat-test-vectors.r.
 
 #[cfg(test)]
 mod tests {
     use stats::Stats;
     use stats::Summary;
+    use stats::bootstrap_median_ci;
     use std::f64;
     use std::io::prelude::*;
     use std::io;
@@ -896,6 +935,19 @@ mod tests {
         check(val, summ);
     }
 
+    #[test]
+    fn test_bootstrap_median_ci() {
+        let constant = [7.0f64; 20];
+        assert_eq!(bootstrap_median_ci(&constant, 100, 95.0), (7.0, 7.0));
+
+        let samples = (0..100).map(|i| i as f64).collect::<Vec<_>>();
+        let (lo, hi) = bootstrap_median_ci(&samples, 1000, 95.0);
+        let median = samples.median();
+        assert!(lo < median && median < hi);
+        assert!(hi - lo < 40.0);
+        assert_eq!(bootstrap_median_ci(&samples, 1000, 95.0), (lo, hi));
+    }
+
     #[test]
     fn test_sum_f64s() {
         assert_eq!([0.5f64, 3.2321f64, 1.5678f64].sum(), 5.2999);
@@ -16,12 +16,17 @@
 
 #if !defined(__WIN32__)
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
 #else
 #include <windows.h>
 #include <wincrypt.h>
@@ -48,19 +53,29 @@ rust_list_dir_val(struct dirent* entry_ptr) {
     return entry_ptr->d_name;
 }
 
-int
-rust_dir_get_mode(struct dirent* entry_ptr) {
-#if defined(_DIRENT_HAVE_D_TYPE)
-    switch (entry_ptr->d_type) {
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(__linux__)
+static int
+dir_type_to_mode(unsigned char d_type) {
+    switch (d_type) {
         case DT_BLK: return S_IFBLK;
         case DT_CHR: return S_IFCHR;
+        case DT_DIR: return S_IFDIR;
         case DT_FIFO: return S_IFIFO;
         case DT_LNK: return S_IFLNK;
         case DT_REG: return S_IFREG;
         case DT_SOCK: return S_IFSOCK;
     }
+    return -1;
+}
 #endif
+
+int
+rust_dir_get_mode(struct dirent* entry_ptr) {
+#if defined(_DIRENT_HAVE_D_TYPE)
+    return dir_type_to_mode(entry_ptr->d_type);
+#else
     return -1;
+#endif
 }
 
 ino_t
@@ -82,6 +97,96 @@ int
 rust_dirent_t_size() {
     return sizeof(struct dirent);
 }
+
+#if defined(__linux__)
+// Batched directory enumeration. rust_dir_fill reads as many entries as fit
+// into `buf` with a single getdents64 call on the directory's descriptor and
+// returns the number of bytes filled, 0 at the end of the directory, or -1 on
+// error. `buf` must be 8-byte aligned. The records are walked in place with
+// the rust_dirent64_* accessors, so no per-entry copies are needed. A DIR
+// enumerated this way must not also be passed to readdir.
+struct rust_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+ssize_t
+rust_dir_fill(DIR *dirp, void *buf, size_t len) {
+    return syscall(SYS_getdents64, dirfd(dirp), buf, len);
+}
+
+size_t
+rust_dirent64_reclen(struct rust_dirent64 *entry_ptr) {
+    return entry_ptr->d_reclen;
+}
+
+const char*
+rust_dirent64_name(struct rust_dirent64 *entry_ptr) {
+    return entry_ptr->d_name;
+}
+
+int
+rust_dirent64_mode(struct rust_dirent64 *entry_ptr) {
+    return dir_type_to_mode(entry_ptr->d_type);
+}
+
+uint64_t
+rust_dirent64_ino(struct rust_dirent64 *entry_ptr) {
+    return entry_ptr->d_ino;
+}
+#endif
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__DragonFly__) || \
+    defined(__OpenBSD__) || defined(__Bitrig__)
+#define RUST_HAVE_OPENAT 1
+#endif
+
+// Opens the subdirectory `name` of the open directory `dirp` relative to its
+// descriptor, so that recursive walks don't resolve each directory's full
+// path again. Symlinks are not followed. Returns NULL and sets errno on
+// failure, with ENOSYS where openat is unavailable.
+DIR*
+rust_opendirat(DIR *dirp, const char *name) {
+#if defined(RUST_HAVE_OPENAT)
+    DIR *child;
+    int err;
+    int fd = openat(dirfd(dirp), name,
+                    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    child = fdopendir(fd);
+    if (child == NULL) {
+        err = errno;
+        close(fd);
+        errno = err;
+    }
+    return child;
+#else
+    errno = ENOSYS;
+    return NULL;
+#endif
+}
+
+// Returns the st_mode of `name` within the open directory `dirp` without
+// following symlinks, or -1 with errno set on failure (ENOSYS where fstatat
+// is unavailable).
+int
+rust_dir_lstat_mode(DIR *dirp, const char *name) {
+#if defined(RUST_HAVE_OPENAT)
+    struct stat st;
+    if (fstatat(dirfd(dirp), name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return -1;
+    }
+    return st.st_mode;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
 #endif
 
 uintptr_t
@@ -124,6 +229,196 @@ get_num_cpus() {
     }
     return numCPU;
 }
+#elif defined(__linux__)
+#include <limits.h>
+#include <stdio.h>
+
+static int
+read_first_line(const char *path, char *buf, int len) {
+    FILE *f = fopen(path, "r");
+    char *line;
+    if (f == NULL) {
+        return -1;
+    }
+    line = fgets(buf, len, f);
+    fclose(f);
+    return line == NULL ? -1 : 0;
+}
+
+// Finds this process's cgroup in the hierarchy holding the `cpu` controller
+// (or the unified cgroup v2 hierarchy if `v2` is set) by scanning lines of
+// the form `id:controllers:path` in /proc/self/cgroup.
+static int
+self_cgroup(int v2, char *path, int len) {
+    char line[PATH_MAX + 128];
+    char *controllers, *cgroup, *c, *nl, *save;
+    int found = -1;
+    FILE *f = fopen("/proc/self/cgroup", "r");
+    if (f == NULL) {
+        return -1;
+    }
+    while (found != 0 && fgets(line, sizeof(line), f) != NULL) {
+        if ((controllers = strchr(line, ':')) == NULL) continue;
+        controllers++;
+        if ((cgroup = strchr(controllers, ':')) == NULL) continue;
+        *cgroup++ = '\0';
+        if ((nl = strchr(cgroup, '\n')) != NULL) *nl = '\0';
+        if (v2) {
+            if (*controllers != '\0') continue;
+        } else {
+            for (c = strtok_r(controllers, ",", &save); c != NULL;
+                 c = strtok_r(NULL, ",", &save)) {
+                if (strcmp(c, "cpu") == 0) break;
+            }
+            if (c == NULL) continue;
+        }
+        if (strlen(cgroup) < (size_t)len) {
+            strcpy(path, cgroup);
+            found = 0;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+// Number of CPUs granted by a CFS bandwidth quota, rounded up, or 0 if the
+// quota is unlimited.
+static int
+quota_cpus(long quota, long period) {
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return (int)((quota + period - 1) / period);
+}
+
+// The CPU limit set by cgroup v2's `cpu.max` in the cgroup directory `dir`:
+// a number of CPUs, 0 if it is unlimited, or -1 if there is no such file.
+static int
+dir_cpus_v2(const char *dir) {
+    char file[PATH_MAX + 64], line[128];
+    long quota, period;
+
+    snprintf(file, sizeof(file), "%s/cpu.max", dir);
+    if (read_first_line(file, line, sizeof(line)) != 0) {
+        return -1;
+    }
+    // "max <period>" means no limit
+    if (sscanf(line, "%ld %ld", &quota, &period) != 2) {
+        return 0;
+    }
+    return quota_cpus(quota, period);
+}
+
+// The CPU limit set by cgroup v1's `cpu.cfs_quota_us` and `cpu.cfs_period_us`
+// in the cgroup directory `dir`, as for `dir_cpus_v2`.
+static int
+dir_cpus_v1(const char *dir) {
+    char file[PATH_MAX + 64], line[128];
+    long quota, period;
+
+    snprintf(file, sizeof(file), "%s/cpu.cfs_quota_us", dir);
+    if (read_first_line(file, line, sizeof(line)) != 0 ||
+        sscanf(line, "%ld", &quota) != 1) {
+        return -1;
+    }
+    snprintf(file, sizeof(file), "%s/cpu.cfs_period_us", dir);
+    if (read_first_line(file, line, sizeof(line)) != 0 ||
+        sscanf(line, "%ld", &period) != 1) {
+        return -1;
+    }
+    return quota_cpus(quota, period);
+}
+
+// A cgroup can use no more CPU than any of its ancestors, so this applies
+// `dir_cpus` to `cgroup` (which it truncates) and to each of its ancestors
+// under `mount`, and returns the tightest limit, 0 if none is set, or -1 if
+// no directory had the files. Climbing up also reaches the root of the
+// mount, which is all a container sees when its cgroup is mounted there but
+// /proc/self/cgroup names the host's path for it.
+static int
+hierarchy_cpus(const char *mount, char *cgroup, int (*dir_cpus)(const char *)) {
+    char dir[PATH_MAX + 64];
+    char *slash;
+    int cpus, limit = -1;
+
+    for (;;) {
+        snprintf(dir, sizeof(dir), "%s%s", mount, cgroup);
+        cpus = dir_cpus(dir);
+        if (cpus > 0 && (limit <= 0 || cpus < limit)) {
+            limit = cpus;
+        } else if (cpus == 0 && limit < 0) {
+            limit = 0;
+        }
+        if ((slash = strrchr(cgroup, '/')) == NULL) {
+            break;
+        }
+        *slash = '\0';
+    }
+    return limit;
+}
+
+// Returns the CPU limit imposed by the CPU quotas of this process's cgroup
+// and its ancestors, using cgroup v2 if it is mounted and cgroup v1
+// otherwise, or 0 if there is none.
+static int
+cgroup_cpus() {
+    static const char *v1_mounts[] = {
+        "/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"
+    };
+    char self[PATH_MAX], cgroup[PATH_MAX];
+    int i, cpus;
+
+    if (self_cgroup(1, cgroup, sizeof(cgroup)) == 0) {
+        cpus = hierarchy_cpus("/sys/fs/cgroup", cgroup, dir_cpus_v2);
+        if (cpus >= 0) {
+            return cpus;
+        }
+    }
+
+    if (self_cgroup(0, self, sizeof(self)) == 0) {
+        for (i = 0; i < 2; i++) {
+            strcpy(cgroup, self);
+            cpus = hierarchy_cpus(v1_mounts[i], cgroup, dir_cpus_v1);
+            if (cpus >= 0) {
+                return cpus;
+            }
+        }
+    }
+    return 0;
+}
+
+// The number of CPUs in this process's scheduler affinity mask, or 0 if it
+// can't be read. The system call is made directly so that this file needn't
+// be built with _GNU_SOURCE for sched_getaffinity and CPU_COUNT.
+static int
+affinity_cpus() {
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    long i, len = syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask);
+    int n = 0;
+
+    for (i = 0; i < len / (long)sizeof(unsigned long); i++) {
+        n += __builtin_popcountl(mask[i]);
+    }
+    return n;
+}
+
+// The number of CPUs this process may actually run on: the online CPUs,
+// narrowed by the scheduler affinity mask and by any cgroup CPU quota.
+int
+get_num_cpus() {
+    int quota;
+    int n = sysconf(_SC_NPROCESSORS_ONLN);
+    int affinity = affinity_cpus();
+
+    if (affinity > 0 && affinity < n) {
+        n = affinity;
+    }
+    quota = cgroup_cpus();
+    if (quota > 0 && quota < n) {
+        n = quota;
+    }
+    return n < 1 ? 1 : n;
+}
 #elif defined(__GNUC__)
 int
 get_num_cpus() {
@@ -136,6 +431,113 @@ rust_get_num_cpus() {
     return get_num_cpus();
 }
 
+// Hardware performance counters, used by libtest to report what happens
+// inside a benchmark loop besides the passing of time.
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+
+// The events behind libtest's counters, in the order it reports them.
+static const uint64_t perf_events[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// Opens the first `n` of the events above as initially disabled counters of
+// the calling thread's user-space execution, storing their descriptors in
+// `fds`, or -1 for those the kernel or the hardware cannot provide (or that
+// perf_event_paranoid forbids). Returns how many were opened.
+int
+rust_perf_open(int *fds, int n) {
+    struct perf_event_attr attr;
+    int i, opened = 0;
+    for (i = 0; i < n; i++) {
+        fds[i] = -1;
+        if (i >= (int)(sizeof(perf_events) / sizeof(perf_events[0]))) {
+            continue;
+        }
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = perf_events[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fds[i] >= 0) {
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+            opened++;
+        }
+    }
+    return opened;
+}
+
+void
+rust_perf_start(const int *fds, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        if (fds[i] < 0) continue;
+        ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+// Stops the counters and stores their counts in `values`, scaled up for any
+// time the kernel had to multiplex them off the hardware. Counters that are
+// unavailable or could not be read count 0.
+void
+rust_perf_stop(const int *fds, int n, uint64_t *values) {
+    uint64_t buf[3]; // value, time enabled, time running
+    int i;
+    for (i = 0; i < n; i++) {
+        if (fds[i] >= 0) ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (i = 0; i < n; i++) {
+        values[i] = 0;
+        if (fds[i] < 0 || read(fds[i], buf, sizeof(buf)) != sizeof(buf) ||
+            buf[2] == 0) {
+            continue;
+        }
+        values[i] = buf[1] == buf[2] ?
+            buf[0] : (uint64_t)((double)buf[0] * buf[1] / buf[2]);
+    }
+}
+
+void
+rust_perf_close(const int *fds, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+}
+#else
+int
+rust_perf_open(int *fds, int n) {
+    int i;
+    for (i = 0; i < n; i++) {
+        fds[i] = -1;
+    }
+    return 0;
+}
+
+void
+rust_perf_start(const int *fds, int n) {
+}
+
+void
+rust_perf_stop(const int *fds, int n, uint64_t *values) {
+    memset(values, 0, n * sizeof(uint64_t));
+}
+
+void
+rust_perf_close(const int *fds, int n) {
+}
+#endif
+
 unsigned int
 rust_valgrind_stack_register(void *start, void *end) {
   return VALGRIND_STACK_REGISTER(start, end);
@@ -11,6 +11,7 @@
 // Helper functions used only in tests
 
 #include <stdint.h>
+#include <stdarg.h>
 #include <assert.h>
 
 // These functions are used in the unit tests for C ABI calls.
@@ -44,6 +45,18 @@ rust_dbg_call(dbg_callback cb, void *data) {
 
 void rust_dbg_do_nothing() { }
 
+uint64_t
+rust_dbg_extern_sum_u64s(int n, ...) {
+    uint64_t sum = 0;
+    va_list ap;
+    va_start(ap, n);
+    while (n-- > 0) {
+        sum += va_arg(ap, uint64_t);
+    }
+    va_end(ap);
+    return sum;
+}
+
 struct TwoU8s {
     uint8_t one;
     uint8_t two;
@@ -0,0 +1,84 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// Valgrind client requests describing the heap to valgrind's tools.
+//
+// liballoc and libarena call these when built with `--cfg valgrind_heap`
+// (`./configure --enable-valgrind-heap`). jemalloc is linked with a prefix,
+// so without them memcheck, massif and DHAT cannot see Rust allocations at
+// all, and memory carved out of arena chunks looks like one big block.
+// Outside of valgrind each request costs a handful of instructions.
+
+#include <stddef.h>
+#include <stdint.h>
+
+//include valgrind.h after stdint.h so that uintptr_t is defined for msys2 w64
+#include "valgrind/valgrind.h"
+#include "valgrind/memcheck.h"
+
+// The in-tree headers predate pool flags (valgrind 3.12). Older valgrinds
+// ignore the extra argument of the request.
+#ifndef VALGRIND_CREATE_MEMPOOL_EXT
+#define VALGRIND_MEMPOOL_METAPOOL 2
+#define VALGRIND_CREATE_MEMPOOL_EXT(pool, rzB, is_zeroed, flags)        \
+    VALGRIND_DO_CLIENT_REQUEST_STMT(VG_USERREQ__CREATE_MEMPOOL,         \
+                                    pool, rzB, is_zeroed, flags, 0)
+#endif
+
+// Heap blocks, as handed out by liballoc's allocator
+
+void
+rust_valgrind_malloclike(void *addr, size_t size) {
+    VALGRIND_MALLOCLIKE_BLOCK(addr, size, 0, 0);
+}
+
+void
+rust_valgrind_freelike(void *addr) {
+    VALGRIND_FREELIKE_BLOCK(addr, 0);
+}
+
+void
+rust_valgrind_resize_inplace(void *addr, size_t old_size, size_t new_size) {
+    VALGRIND_RESIZEINPLACE_BLOCK(addr, old_size, new_size, 0);
+}
+
+// Memory pools, for arenas which carve objects out of larger chunks
+
+// Registers a pool anchored at `pool` and makes the `len` bytes of the chunk
+// at `pool` inaccessible until objects are allocated from it. Chunks are
+// themselves heap blocks described by liballoc, so the pool is a metapool:
+// its objects are not counted a second time.
+void
+rust_valgrind_create_mempool(void *pool, size_t len) {
+    VALGRIND_CREATE_MEMPOOL_EXT(pool, 0, 0, VALGRIND_MEMPOOL_METAPOOL);
+    (void) VALGRIND_MAKE_MEM_NOACCESS(pool, len);
+}
+
+void
+rust_valgrind_mempool_alloc(void *pool, void *addr, size_t size) {
+    VALGRIND_MEMPOOL_ALLOC(pool, addr, size);
+}
+
+// Releases every object of the pool. The chunk itself must be released
+// afterwards, as the pool does not own it.
+void
+rust_valgrind_destroy_mempool(void *pool) {
+    VALGRIND_DESTROY_MEMPOOL(pool);
+}
+
+//
+// Local Variables:
+// mode: C++
+// fill-column: 78;
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// buffer-file-coding-system: utf-8-unix
+// End:
+//
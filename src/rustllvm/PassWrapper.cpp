@@ -69,7 +69,6 @@ LLVMRustCreateTargetMachine(const char *triple,
                             CodeModel::Model CM,
                             Reloc::Model RM,
                             CodeGenOpt::Level OptLevel,
-                            bool EnableSegmentedStacks,
                             bool UseSoftFloat,
                             bool NoFramePointerElim,
                             bool PositionIndependentExecutable,
@@ -0,0 +1,175 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// Measures the cost of calls between Rust and C for the argument and
+// return shapes lowered by librustc_trans/trans/cabi_*.rs: scalars, small
+// structs passed and returned by value, callbacks from C back into Rust
+// and variadic calls, all against the helpers in rust_test_helpers.c.
+//
+// Each shape is timed twice: as a chain of calls each taking the result of
+// the one before (latency), and as independent calls (throughput).
+
+#![feature(libc, std_misc)]
+#![allow(non_snake_case)]
+
+extern crate libc;
+
+use std::env;
+use std::time::Duration;
+
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub struct TwoU8s { one: u8, two: u8 }
+
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub struct TwoU16s { one: u16, two: u16 }
+
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub struct TwoU32s { one: u32, two: u32 }
+
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub struct TwoU64s { one: u64, two: u64 }
+
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub struct TwoDoubles { one: f64, two: f64 }
+
+#[link(name = "rust_test_helpers")]
+extern {
+    fn rust_dbg_do_nothing();
+    fn rust_dbg_extern_identity_u8(v: u8) -> u8;
+    fn rust_dbg_extern_identity_u32(v: u32) -> u32;
+    fn rust_dbg_extern_identity_u64(v: u64) -> u64;
+    fn rust_dbg_extern_identity_double(v: f64) -> f64;
+    fn rust_dbg_extern_identity_TwoU8s(v: TwoU8s) -> TwoU8s;
+    fn rust_dbg_extern_identity_TwoU16s(v: TwoU16s) -> TwoU16s;
+    fn rust_dbg_extern_identity_TwoU32s(v: TwoU32s) -> TwoU32s;
+    fn rust_dbg_extern_identity_TwoU64s(v: TwoU64s) -> TwoU64s;
+    fn rust_dbg_extern_identity_TwoDoubles(v: TwoDoubles) -> TwoDoubles;
+    fn rust_dbg_extern_return_TwoU64s() -> TwoU64s;
+    fn rust_dbg_call(cb: extern "C" fn(libc::uintptr_t) -> libc::uintptr_t,
+                     data: libc::uintptr_t)
+                     -> libc::uintptr_t;
+    fn rust_dbg_extern_sum_u64s(n: libc::c_int, ...) -> u64;
+}
+
+extern fn callback(data: libc::uintptr_t) -> libc::uintptr_t {
+    data + 1
+}
+
+fn report(shape: &str, kind: &str, iters: u64, dur: Duration) {
+    let ns = dur.num_nanoseconds().unwrap() as f64 / iters as f64;
+    println!("{:<12} {:<10} {:>8.2} ns/call {:>9.1} Mcalls/s",
+             shape, kind, ns, 1e3 / ns);
+}
+
+/// Times `iters` calls of `f`, each given the result of the previous one.
+fn latency<F: FnMut(u64) -> u64>(shape: &str, iters: u64, mut f: F) -> u64 {
+    let mut x = 0;
+    let dur = Duration::span(|| {
+        for _ in 0..iters {
+            x = f(x);
+        }
+    });
+    report(shape, "latency", iters, dur);
+    x
+}
+
+/// Times `iters` calls of `f` on independent arguments.
+fn throughput<F: FnMut(u64) -> u64>(shape: &str, iters: u64, mut f: F) -> u64 {
+    let mut sum = 0u64;
+    let dur = Duration::span(|| {
+        for i in 0..iters {
+            sum = sum.wrapping_add(f(i));
+        }
+    });
+    report(shape, "throughput", iters, dur);
+    sum
+}
+
+fn both<F: FnMut(u64) -> u64>(shape: &str, iters: u64, mut f: F) -> u64 {
+    latency(shape, iters, |x| f(x)).wrapping_add(throughput(shape, iters, |x| f(x)))
+}
+
+fn main() {
+    let args = env::args();
+    let args = if env::var_os("RUST_BENCH").is_some() {
+        vec!("".to_string(), "100000000".to_string())
+    } else if args.len() <= 1 {
+        vec!("".to_string(), "100000".to_string())
+    } else {
+        args.collect()
+    };
+    let iters: u64 = args[1].parse().unwrap();
+
+    // Results are folded into a checksum so that no call can be dropped.
+    let mut check = 0u64;
+    unsafe {
+        let dur = Duration::span(|| {
+            for _ in 0..iters {
+                rust_dbg_do_nothing();
+            }
+        });
+        report("()", "throughput", iters, dur);
+
+        check ^= both("u8", iters, |x| {
+            rust_dbg_extern_identity_u8((x as u8).wrapping_add(1)) as u64
+        });
+        check ^= both("u32", iters, |x| {
+            rust_dbg_extern_identity_u32((x as u32).wrapping_add(1)) as u64
+        });
+        check ^= both("u64", iters, |x| rust_dbg_extern_identity_u64(x.wrapping_add(1)));
+        check ^= both("f64", iters, |x| {
+            rust_dbg_extern_identity_double(x as f64 + 1.0) as u64
+        });
+
+        check ^= both("TwoU8s", iters, |x| {
+            let v = TwoU8s { one: x as u8, two: ((x >> 8) as u8).wrapping_add(1) };
+            let v = rust_dbg_extern_identity_TwoU8s(v);
+            v.one as u64 | (v.two as u64) << 8
+        });
+        check ^= both("TwoU16s", iters, |x| {
+            let v = TwoU16s { one: x as u16, two: ((x >> 16) as u16).wrapping_add(1) };
+            let v = rust_dbg_extern_identity_TwoU16s(v);
+            v.one as u64 | (v.two as u64) << 16
+        });
+        check ^= both("TwoU32s", iters, |x| {
+            let v = TwoU32s { one: x as u32, two: ((x >> 32) as u32).wrapping_add(1) };
+            let v = rust_dbg_extern_identity_TwoU32s(v);
+            v.one as u64 | (v.two as u64) << 32
+        });
+        check ^= both("TwoU64s", iters, |x| {
+            let v = TwoU64s { one: x, two: x.wrapping_add(1) };
+            rust_dbg_extern_identity_TwoU64s(v).two
+        });
+        check ^= both("TwoDoubles", iters, |x| {
+            let v = TwoDoubles { one: x as f64, two: x as f64 + 1.0 };
+            rust_dbg_extern_identity_TwoDoubles(v).two as u64
+        });
+        check ^= throughput("ret TwoU64s", iters, |_| {
+            rust_dbg_extern_return_TwoU64s().one
+        });
+
+        check ^= both("callback", iters, |x| {
+            rust_dbg_call(callback, x as libc::uintptr_t) as u64
+        });
+
+        check ^= both("variadic 1", iters, |x| {
+            rust_dbg_extern_sum_u64s(1, x.wrapping_add(1))
+        });
+        check ^= both("variadic 4", iters, |x| {
+            rust_dbg_extern_sum_u64s(4, x, 1u64, 0u64, 0u64)
+        });
+    }
+    println!("checksum {}", check);
+}
@@ -0,0 +1,28 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#![crate_type = "rlib"]
+
+pub struct S { pub a: u32, b: String }
+
+pub enum E { A(u8), B { x: i64 } }
+
+pub trait T {
+    fn f(&self) -> u32 { 0 }
+}
+
+impl T for S {}
+
+impl S {
+    pub fn new() -> S { S { a: 0, b: String::new() } }
+}
+
+#[inline]
+pub fn g<X: Clone>(x: &X) -> X { x.clone() }
@@ -0,0 +1,101 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// Times the child lookups which metadata/decoder.rs makes in item
+// documents, on the metadata of a real crate:
+//
+//     lookup path/to/libstd-*.rlib [rounds]
+//
+// Each of the tags below is looked up in every item, once through
+// `reader::maybe_get_doc`, which uses an item's child index if it has one,
+// and once by scanning the item's children, and the two must agree.
+
+#![feature(rustc_private, std_misc)]
+
+extern crate rbml;
+extern crate rustc;
+
+use rbml::Doc;
+use rbml::reader;
+use rustc::metadata::common::*;
+use rustc::metadata::loader::get_metadata_section;
+
+use std::env;
+use std::path::Path;
+use std::time::Duration;
+
+// The tags decoding an item most often asks for, in no particular order.
+const TAGS: [usize; 8] = [
+    tag_items_data_item_family,
+    tag_items_data_item_type,
+    tag_items_data_item_symbol,
+    tag_items_data_item_visibility,
+    tag_items_data_parent_item,
+    tag_items_data_item_stability,
+    tag_item_generics,
+    tag_path,
+];
+
+// The first child of `d` with tag `tg`, found as maybe_get_doc did before
+// documents were indexed.
+fn scan_get_doc<'a>(d: Doc<'a>, tg: usize) -> Option<Doc<'a>> {
+    let mut found = None;
+    reader::docs(d, |tag, doc| {
+        if tag == tg { found = Some(doc) }
+        found.is_none()
+    });
+    found
+}
+
+fn lookups<F>(items: &[Doc], rounds: usize, mut get: F) -> (Duration, usize) where
+    F: FnMut(Doc, usize) -> Option<usize>,
+{
+    let mut check = 0;
+    let dur = Duration::span(|| {
+        for _ in 0..rounds {
+            for &item in items {
+                for &tag in &TAGS {
+                    check = check.wrapping_add(get(item, tag).unwrap_or(0));
+                }
+            }
+        }
+    });
+    (dur, check)
+}
+
+fn report(what: &str, n: usize, dur: Duration) {
+    let ns = dur.num_nanoseconds().unwrap() as f64;
+    println!("{:<14} {:>8.1} ns/lookup", what, ns / n as f64);
+}
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    let path = Path::new(&args[1]);
+    let rounds = args.get(2).map(|r| r.parse().unwrap()).unwrap_or(100);
+
+    let blob = get_metadata_section(cfg!(target_os = "macos"), path).unwrap();
+    let root = Doc::new(blob.as_slice());
+    let items_data = reader::get_doc(reader::get_doc(root, tag_items), tag_items_data);
+    let mut items = Vec::new();
+    reader::tagged_docs(items_data, tag_items_data_item, |item| { items.push(item); true });
+
+    let (indexed, check1) = lookups(&items, rounds, |item, tag| {
+        reader::maybe_get_doc(item, tag).map(|d| d.start)
+    });
+    let (scanned, check2) = lookups(&items, rounds, |item, tag| {
+        scan_get_doc(item, tag).map(|d| d.start)
+    });
+    assert_eq!(check1, check2);
+
+    let n = items.len() * TAGS.len() * rounds;
+    println!("{} items, {} lookups", items.len(), n);
+    report("maybe_get_doc", n, indexed);
+    report("scan", n, scanned);
+}
@@ -0,0 +1,72 @@
+// Copyright 2015 The Rust Project Developers. See the COPYRIGHT
+// file at the top-level directory of this distribution and at
+// http://rust-lang.org/COPYRIGHT.
+//
+// Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+// http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+// <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// compile-flags: -C stack-probes
+// ignore-android
+// ignore-freebsd
+// ignore-ios
+// ignore-dragonfly
+// ignore-bitrig
+// ignore-musl
+// ignore-windows
+
+#![feature(asm)]
+
+use std::process::Command;
+use std::env;
+use std::thread;
+
+// lifted from the test module
+// Inlining to avoid llvm turning the recursive functions into tail calls,
+// which doesn't consume stack.
+#[inline(always)]
+pub fn black_box<T>(dummy: T) { unsafe { asm!("" : : "r"(&dummy)) } }
+
+// Each frame is many pages long, so without probes the recursion would
+// step over the guard page rather than into it.
+fn recurse() {
+    let buf = [0u8; 64 * 1024];
+    black_box(&buf);
+    recurse();
+    black_box(());
+}
+
+// A large frame inlined into a small one must not leave the caller's frame
+// unprobed, so the large function is kept out of line.
+#[inline(always)]
+fn large_frame() {
+    let buf = [0u8; 64 * 1024];
+    black_box(&buf);
+}
+
+fn recurse_inlined() {
+    let small = [0u8; 16];
+    black_box(&small);
+    large_frame();
+    recurse_inlined();
+    black_box(());
+}
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() > 1 && args[1] == "recurse" {
+        thread::spawn(recurse).join();
+    } else if args.len() > 1 && args[1] == "recurse-inlined" {
+        thread::spawn(recurse_inlined).join();
+    } else {
+        for mode in &["recurse", "recurse-inlined"] {
+            let recurse = Command::new(&args[0]).arg(mode).output().unwrap();
+            assert!(!recurse.status.success());
+            let error = String::from_utf8_lossy(&recurse.stderr);
+            println!("`{}`", error);
+            assert!(error.contains("has overflowed its stack"));
+        }
+    }
+}